@@ -0,0 +1,18 @@
+#include "AnalysisContext.h"
+
+namespace analysis
+{
+    AnalysisContext AnalysisContext::FromTempo(int sampleRate, double bpm, Key musicalKey, float songLength)
+    {
+        if (bpm <= 0.0)
+            bpm = 120.0;
+
+        AnalysisContext ctx;
+        ctx.sampleRate = sampleRate;
+        ctx.twoBeatDuration = static_cast<float>((1.0 / (bpm / 60.0)) / 0.5);
+        ctx.qBeatDuration = static_cast<float>((1.0 / (bpm / 60.0)) / 4.0);
+        ctx.musicalKey = musicalKey;
+        ctx.songLength = songLength;
+        return ctx;
+    }
+}
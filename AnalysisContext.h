@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Keys.h"
+
+namespace analysis
+{
+    // Per-track analysis parameters. Replaces the process-wide GLOBAL::sampleRate /
+    // qBeatDuration / twoBeatDuration / MUSICAL_KEY / SONG_LENGTH so that several tracks
+    // can be analyzed at once; pass it by const reference into MidiMaker, Chunk and Util.
+    struct AnalysisContext
+    {
+        int sampleRate = 0;
+        float qBeatDuration = 0.0f;   // quarter of a beat, seconds
+        float twoBeatDuration = 0.0f; // two beats, seconds
+        Key musicalKey = Key::NO_KEY;
+        float songLength = 0.0f;      // seconds; 0 = unknown
+        bool isMonophonic = false;
+        int chordVoices = 0;
+        int pitchBinsPerOctave = 36;  // MidiMaker constant-Q resolution (12/24/36); 0 = top linear FFT bins
+
+        // Derives the beat durations from a tempo. A non-positive bpm falls back to 120.
+        static AnalysisContext FromTempo(int sampleRate, double bpm, Key musicalKey, float songLength);
+
+        // A monophonic track cannot have more than one chord voice.
+        bool IsValid() const { return sampleRate > 0 && !(isMonophonic && chordVoices > 1); }
+    };
+}
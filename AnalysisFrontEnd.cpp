@@ -0,0 +1,103 @@
+#include "AnalysisFrontEnd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+
+#include "Profiler.h"
+#include "Resampler.h"
+
+namespace analysis
+{
+    bool ParseCropWindow(const std::string& text, FrontEndOptions& options)
+    {
+        const std::size_t colon = text.find(':');
+        if (colon == std::string::npos)
+            return false;
+        try
+        {
+            const double offset = std::stod(text.substr(0, colon));
+            const double seconds = std::stod(text.substr(colon + 1));
+            if (!std::isfinite(offset) || !std::isfinite(seconds) || offset < 0.0)
+                return false;
+            options.cropOffsetSeconds = offset;
+            options.cropSeconds = seconds;
+            return true;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    AnalysisSignal BuildAnalysisSignal(const audiofile::AudioView& audio, int sampleRate, const FrontEndOptions& options)
+    {
+        WAVEOUT_PROFILE_SCOPE("analysis.frontEnd");
+        AnalysisSignal out;
+        if (audio.empty() || sampleRate <= 0)
+            return out;
+
+        const bool decimate = options.targetSampleRate > 0 && options.targetSampleRate < sampleRate;
+        out.sampleRate = decimate ? options.targetSampleRate : sampleRate;
+
+        // The downmix is produced a block at a time and streamed straight into the resampler.
+        constexpr std::size_t BLOCK_FRAMES = 4096;
+        constexpr float PCM16_SCALE = 1.0f / 32768.0f;
+        const std::size_t frames = audio.Frames();
+        float block[BLOCK_FRAMES];
+        float peak = 0.0f; // of the full-rate downmix, in PCM16 units
+
+        if (!decimate)
+        {
+            out.mono.resize(frames);
+            for (std::size_t i = 0; i < frames; ++i)
+            {
+                const float v = audio.Mono(i);
+                peak = (std::max)(peak, std::fabs(v));
+                out.mono[i] = v * PCM16_SCALE;
+            }
+        }
+        else
+        {
+            dsp::PolyphaseResampler resampler(sampleRate, out.sampleRate, 1, dsp::PolyphaseResampler::ANALYSIS_HALF_TAPS);
+            out.mono.reserve(static_cast<std::size_t>(
+                static_cast<double>(frames) * out.sampleRate / sampleRate) + resampler.max_output(0));
+            for (std::size_t pos = 0; pos < frames; pos += BLOCK_FRAMES)
+            {
+                const std::size_t n = (std::min)(BLOCK_FRAMES, frames - pos);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    const float v = audio.Mono(pos + i);
+                    peak = (std::max)(peak, std::fabs(v));
+                    block[i] = v * PCM16_SCALE;
+                }
+                resampler.process(block, n, out.mono);
+            }
+            resampler.flush(out.mono);
+        }
+
+        // Peak-normalize like BPMDetection's NormalizeForAnalysis does for the PCM16 entry points,
+        // so the fixed dB thresholds (first-audio RMS gate, aubio silence gate) see the same levels
+        // for quiet masters. A near-silent track (peak <= 2 LSB) stays in PCM16 units, as it did there.
+        const float gain = (peak > 2.0f) ? 32768.0f / (peak + 1e-12f) : 32768.0f;
+        for (float& v : out.mono)
+            v *= gain;
+        WAVEOUT_PROFILE_BYTES(out.mono.size() * sizeof(float));
+
+        // Same clamping as aubioTest.py: a window running past the end is cut short, one that
+        // starts past the end falls back to the whole track.
+        out.cropBegin = 0;
+        out.cropEnd = out.mono.size();
+        if (options.cropSeconds > 0.0)
+        {
+            const std::size_t begin = static_cast<std::size_t>((std::max)(0.0, options.cropOffsetSeconds) * out.sampleRate);
+            const std::size_t end = begin + static_cast<std::size_t>(options.cropSeconds * out.sampleRate);
+            if (begin < out.mono.size())
+            {
+                out.cropBegin = begin;
+                out.cropEnd = (std::min)(end, out.mono.size());
+            }
+        }
+        return out;
+    }
+}
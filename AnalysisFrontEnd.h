@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "AudioView.h"
+
+namespace analysis
+{
+    struct FrontEndOptions
+    {
+        // Rate key and tempo detection run at. Both only look below ~5 kHz, so 11025 Hz keeps
+        // everything they use while cutting their input 4x (8x at 88.2 kHz).
+        // <= 0, or anything at or above the source rate, keeps the source rate.
+        int targetSampleRate = 11025;
+
+        // Optional analysis window for the tempo estimate and the key, like BPM_CROP_OFFSET_S /
+        // BPM_CROP_SECONDS in aubioTest.py. cropSeconds <= 0 analyzes the whole track. Beat-grid
+        // anchors always use the whole signal, since they are absolute times.
+        double cropOffsetSeconds = 0.0;
+        double cropSeconds = 0.0;
+    };
+
+    // "OFFSET:SECONDS" (e.g. "10:150") -> crop fields; false (options untouched) if malformed.
+    bool ParseCropWindow(const std::string& text, FrontEndOptions& options);
+
+    // One anti-aliased, decimated mono float signal shared by the key and beat-grid detectors.
+    struct AnalysisSignal
+    {
+        std::vector<float> mono;   // downmix, peak-normalized to [-1, 1] over the whole track
+        int sampleRate = 0;
+        std::size_t cropBegin = 0; // [cropBegin, cropEnd) of mono is the analysis window
+        std::size_t cropEnd = 0;
+
+        bool empty() const { return mono.empty() || sampleRate <= 0; }
+        bool IsCropped() const { return cropBegin != 0 || cropEnd != mono.size(); }
+        const float* CropData() const { return mono.data() + cropBegin; }
+        std::size_t CropSize() const { return cropEnd - cropBegin; }
+        double DurationSeconds() const { return sampleRate > 0 ? static_cast<double>(mono.size()) / sampleRate : 0.0; }
+    };
+
+    // Downmixes `audio` and resamples it to options.targetSampleRate in one streaming pass
+    // (polyphase windowed sinc, so nothing above the new Nyquist folds back). No full-rate copy
+    // of the track is made.
+    AnalysisSignal BuildAnalysisSignal(const audiofile::AudioView& audio, int sampleRate, const FrontEndOptions& options = {});
+}
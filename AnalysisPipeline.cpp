@@ -0,0 +1,375 @@
+#include "AnalysisPipeline.h"
+
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <keyfinder/keyfinder.h>
+
+#include "AnalysisContext.h"
+#include "AudioFileLoader.h"
+#include "AudioView.h"
+#include "ChunkStore.h"
+#include "DecodeCache.h"
+#include "KeyDetection.h"
+#include "MidiMaker.h"
+#include "ParallelLoader.h"
+#include "Profiler.h"
+#include "StemSeperator.h"
+#include "TaskGraph.h"
+#include "Util.h"
+#include "filter.cpp"
+
+namespace analysis
+{
+    namespace
+    {
+        void SetError(std::string* errorMessage, const std::string& message)
+        {
+            if (errorMessage)
+                *errorMessage = message;
+        }
+
+        // demucs saturates the GPU on its own and writes into a shared separated/ directory.
+        std::mutex& StemSeparationMutex()
+        {
+            static std::mutex m;
+            return m;
+        }
+
+        std::vector<ChunkSummary> SummarizeChunks(const ChunkStore& chunks)
+        {
+            std::vector<ChunkSummary> out;
+            out.reserve(chunks.Size());
+            const std::size_t peaks = static_cast<std::size_t>(chunks.PeaksPerChunk());
+            for (std::size_t c = 0; c < chunks.Size(); ++c)
+            {
+                ChunkSummary s;
+                s.index = chunks.Index(c);
+                s.startSeconds = chunks.StartSeconds(c);
+                s.endSeconds = chunks.EndSeconds(c); // clamped to the song length
+                s.frequencies.assign(chunks.Frequencies(c), chunks.Frequencies(c) + peaks);
+                s.intensities.assign(chunks.Magnitudes(c), chunks.Magnitudes(c) + peaks);
+                if (chunks.IsClamped())
+                {
+                    const Keys* notes = chunks.Notes(c);
+                    for (std::size_t p = 0; p < peaks; ++p)
+                        s.notes.push_back(Util::getEnumString(notes[p]));
+                }
+                out.push_back(std::move(s));
+            }
+            return out;
+        }
+
+        // Summaries go into the result; the loaded audio stays with the caller for transcription.
+        void LoadStems(const std::string& path, TrackResult& result, std::vector<audiofile::LoadedAudio>& stemAudio)
+        {
+            {
+                std::lock_guard<std::mutex> lock(StemSeparationMutex());
+                StemSeperator::split(path);
+            }
+
+            const std::string base = "separated/htdemucs_ft/" + std::filesystem::path(path).stem().string() + "/";
+            for (const char* name : { "bass", "vocals", "drums", "other" })
+            {
+                StemSummary stem;
+                stem.name = name;
+                stem.path = base + name + ".wav";
+                audiofile::LoadedAudio loaded = audiofile::ParallelLoader::Load({ stem.path, audiofile::LoadMode::MapOrDecode });
+                stem.ok = loaded.ok;
+                if (loaded.ok && loaded.Channels() > 0)
+                    stem.frames = loaded.Samples().size() / static_cast<std::size_t>(loaded.Channels());
+                result.stems.push_back(std::move(stem));
+                stemAudio.push_back(std::move(loaded));
+            }
+        }
+
+        std::string JsonEscape(const std::string& s)
+        {
+            std::string out;
+            out.reserve(s.size() + 2);
+            for (char ch : s)
+            {
+                switch (ch)
+                {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(ch) < 0x20)
+                    {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(ch)));
+                        out += buf;
+                    }
+                    else
+                    {
+                        out += ch;
+                    }
+                }
+            }
+            return out;
+        }
+
+        // JSON has no inf/nan; 20*log10(0) shows up for silent chunks.
+        std::string JsonNumber(double v)
+        {
+            if (!std::isfinite(v))
+                return "null";
+            std::ostringstream ss;
+            ss.precision(10);
+            ss << v;
+            return ss.str();
+        }
+
+        template <typename T, typename Format>
+        void WriteArray(std::ostream& os, const std::vector<T>& values, Format&& format)
+        {
+            os << "[";
+            for (std::size_t i = 0; i < values.size(); ++i)
+                os << (i ? ", " : "") << format(values[i]);
+            os << "]";
+        }
+
+        void WriteChunks(std::ostream& os, const char* name, const std::vector<ChunkSummary>& chunks)
+        {
+            os << "  \"" << name << "\": [";
+            for (std::size_t i = 0; i < chunks.size(); ++i)
+            {
+                const ChunkSummary& c = chunks[i];
+                os << (i ? ",\n" : "\n") << "    { \"index\": " << c.index
+                    << ", \"start\": " << JsonNumber(c.startSeconds)
+                    << ", \"end\": " << JsonNumber(c.endSeconds)
+                    << ", \"frequencies\": ";
+                WriteArray(os, c.frequencies, JsonNumber);
+                os << ", \"intensitiesDb\": ";
+                WriteArray(os, c.intensities, [](double v) { return JsonNumber(20.0 * std::log10(v / 32768.0)); });
+                os << ", \"notes\": ";
+                WriteArray(os, c.notes, [](const std::string& n) { return "\"" + JsonEscape(n) + "\""; });
+                os << " }";
+            }
+            os << (chunks.empty() ? "]" : "\n  ]");
+        }
+    }
+
+    TrackResult AnalyzeTrack(const std::string& path, const TrackOptions& options)
+    {
+        WAVEOUT_PROFILE_SCOPE("analysis.track");
+        const auto started = std::chrono::steady_clock::now();
+        TrackResult result;
+        result.path = path;
+
+        // Stage outputs. Each is written by exactly one stage and only read by its dependents.
+        // Key, grid and the filters read the decoded (or mapped) samples through a view; nothing
+        // is split into per-channel or mono copies.
+        audiofile::LoadedAudio source;
+        audiofile::AudioView audio;
+        AnalysisSignal analysisSignal;
+        std::vector<short> lowPassed;  // interleaved, same channel count as the source
+        std::vector<short> highPassed;
+        std::vector<audiofile::LoadedAudio> stemAudio; // parallel to result.stems
+        ChunkStore lowChunks;
+        ChunkStore highChunks;
+        std::vector<ChunkStore> stemChunks;            // parallel to result.stems
+
+        threading::TaskGraph graph;
+        const auto decode = graph.Add("decode", [&]() {
+            source = audiofile::ParallelLoader::Load({ path, audiofile::LoadMode::Decode, options.decodeCache });
+            if (!source.ok)
+                throw std::runtime_error(source.error);
+            result.sampleRate = source.SampleRate();
+            result.channels = source.Channels();
+            audio = audiofile::AudioView::Interleaved(source.Samples(), source.Channels());
+            if (audio.empty() || result.sampleRate <= 0)
+                throw std::runtime_error("Decoded audio is empty.");
+            result.durationSeconds = static_cast<double>(audio.Frames()) / result.sampleRate;
+        });
+
+        // demucs only needs the path, so it overlaps with everything else.
+        threading::TaskGraph::TaskId stems = 0;
+        if (options.runStemSeparation)
+            stems = graph.Add("stems", [&]() { LoadStems(path, result, stemAudio); });
+
+        // Key and tempo read one decimated mono signal instead of the full-rate PCM.
+        const auto frontEnd = graph.Add("analysis front end", [&]() {
+            analysisSignal = BuildAnalysisSignal(audio, result.sampleRate, options.frontEnd);
+        }, { decode });
+
+        const auto key = graph.Add("key", [&]() {
+            KeyFinder::KeyFinder kf;
+            result.key = KeyDetection::getKey(analysisSignal, kf);
+            result.keyName = Util::getEnumString(result.key);
+        }, { frontEnd });
+
+        const auto grid = graph.Add("beat grid", [&]() {
+            result.grid = BPMDetection::estimateBeatGridMonoAubio(analysisSignal);
+        }, { frontEnd });
+
+        if (options.detectOnsets)
+        {
+            graph.Add("onsets", [&]() {
+                OnsetConfig config = options.onsets;
+                config.sampleRate = result.sampleRate;
+                result.onsets = NoteSegmentor::detect(audio, config);
+            }, { decode });
+        }
+
+        // One crossover pass yields both the low and the high band.
+        const auto bands = graph.Add("band split", [&]() {
+            std::vector<std::vector<short>> split = filter::splitBands(audio, result.sampleRate, { options.filterCutoffHz }, options.pool);
+            lowPassed = std::move(split[0]);
+            highPassed = std::move(split[1]);
+        }, { decode });
+
+        // Chunks of a track without a detected key keep their frequencies but get no notes.
+        auto makeContext = [&]() {
+            AnalysisContext ctx = AnalysisContext::FromTempo(result.sampleRate, std::round(result.grid.bpm),
+                result.key, static_cast<float>(result.durationSeconds));
+            ctx.pitchBinsPerOctave = options.pitchBinsPerOctave;
+            return ctx;
+        };
+        const auto midiLow = graph.Add("midi low", [&]() {
+            lowChunks = MidiMaker::lowPass(audiofile::AudioView::Interleaved(lowPassed, result.channels), makeContext(), options.pool);
+            result.lowPassChunks = SummarizeChunks(lowChunks);
+        }, { key, grid, bands });
+        const auto midiHigh = graph.Add("midi high", [&]() {
+            highChunks = MidiMaker::highPass(audiofile::AudioView::Interleaved(highPassed, result.channels), makeContext(), options.pool);
+            result.highPassChunks = SummarizeChunks(highChunks);
+        }, { key, grid, bands });
+
+        std::vector<threading::TaskGraph::TaskId> midiInputs = { midiLow, midiHigh };
+        if (options.runStemSeparation)
+        {
+            // Each separated stem goes through the pass that matches its range; drums have no pitch
+            // to transcribe. Stems come back at demucs' rate, so they are conformed to the track's.
+            midiInputs.push_back(graph.Add("midi stems", [&]() {
+                stemChunks.resize(stemAudio.size());
+                for (std::size_t i = 0; i < stemAudio.size(); ++i)
+                {
+                    const std::string& name = result.stems[i].name;
+                    if (!stemAudio[i].ok || name == "drums")
+                        continue;
+                    audiofile::ParallelLoader::ConformSampleRate(stemAudio[i], result.sampleRate);
+                    const audiofile::AudioView view = audiofile::AudioView::Interleaved(stemAudio[i].Samples(), stemAudio[i].Channels());
+                    if (name == "bass")
+                        stemChunks[i] = MidiMaker::lowPass(view, makeContext(), options.pool);
+                    else if (name == "vocals")
+                        stemChunks[i] = MidiMaker::highPass(view, makeContext(), options.pool);
+                    else
+                        stemChunks[i] = MidiMaker::bandPass(view, makeContext(), options.pool);
+                }
+            }, { stems, key, grid }));
+        }
+
+        // The separated stems make the better transcription; the filter bands stand in without them.
+        if (!options.midiFile.empty())
+        {
+            graph.Add("midi file", [&]() {
+                std::vector<MidiStem> parts;
+                for (std::size_t i = 0; i < stemChunks.size(); ++i)
+                {
+                    const std::string& name = result.stems[i].name;
+                    if (stemChunks[i].Size() == 0)
+                        continue;
+                    if (name == "bass")
+                        parts.push_back({ "Bass", &stemChunks[i], 0, 33 });    // fingered bass
+                    else if (name == "vocals")
+                        parts.push_back({ "Vocals", &stemChunks[i], 1, 53 });  // voice oohs
+                    else
+                        parts.push_back({ "Other", &stemChunks[i], 2, 0 });    // piano
+                }
+                if (parts.empty())
+                {
+                    parts.push_back({ "Low Pass", &lowChunks, 0, 33 });
+                    parts.push_back({ "High Pass", &highChunks, 1, 0 });
+                }
+
+                const std::string midiPath = options.midiFile.string();
+                std::string midiError;
+                if (!MidiMaker::makeMidi(parts, result.grid, midiPath, &midiError))
+                    throw std::runtime_error(midiError);
+                result.midiPath = midiPath;
+            }, midiInputs);
+        }
+
+        std::string error;
+        result.ok = graph.Run(options.pool, &error);
+        if (!result.ok)
+            result.error = error;
+        result.stageTimings = graph.Timings();
+        result.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return result;
+    }
+
+    bool WriteTrackResult(const TrackResult& result, const std::filesystem::path& outFile, std::string* errorMessage)
+    {
+        std::ofstream os(outFile, std::ios::binary | std::ios::trunc);
+        if (!os)
+        {
+            SetError(errorMessage, "Failed to open results file: " + outFile.string());
+            return false;
+        }
+
+        os << "{\n"
+            << "  \"path\": \"" << JsonEscape(result.path) << "\",\n"
+            << "  \"ok\": " << (result.ok ? "true" : "false") << ",\n"
+            << "  \"error\": \"" << JsonEscape(result.error) << "\",\n"
+            << "  \"sampleRate\": " << result.sampleRate << ",\n"
+            << "  \"channels\": " << result.channels << ",\n"
+            << "  \"durationSeconds\": " << JsonNumber(result.durationSeconds) << ",\n"
+            << "  \"key\": \"" << JsonEscape(result.keyName) << "\",\n"
+            << "  \"bpm\": " << JsonNumber(result.grid.bpm) << ",\n"
+            << "  \"grid\": { \"t0\": " << JsonNumber(result.grid.t0)
+            << ", \"audioStart\": " << JsonNumber(result.grid.audioStart)
+            << ", \"approxOnset\": " << JsonNumber(result.grid.approxOnset)
+            << ", \"kickAttack\": " << JsonNumber(result.grid.kickAttack) << " },\n"
+            << "  \"midi\": \"" << JsonEscape(result.midiPath) << "\",\n"
+            << "  \"elapsedSeconds\": " << JsonNumber(result.elapsedSeconds) << ",\n";
+
+        os << "  \"stages\": [";
+        for (std::size_t i = 0; i < result.stageTimings.size(); ++i)
+        {
+            const threading::TaskGraph::StageTiming& t = result.stageTimings[i];
+            os << (i ? ", " : "") << "{ \"name\": \"" << JsonEscape(t.name) << "\", \"ran\": " << (t.ran ? "true" : "false")
+                << ", \"startMs\": " << JsonNumber(t.startMs) << ", \"durationMs\": " << JsonNumber(t.durationMs) << " }";
+        }
+        os << "],\n";
+
+        os << "  \"stems\": [";
+        for (std::size_t i = 0; i < result.stems.size(); ++i)
+        {
+            const StemSummary& s = result.stems[i];
+            os << (i ? ", " : "") << "{ \"name\": \"" << JsonEscape(s.name) << "\", \"path\": \"" << JsonEscape(s.path)
+                << "\", \"ok\": " << (s.ok ? "true" : "false") << ", \"frames\": " << s.frames << " }";
+        }
+        os << "],\n";
+
+        os << "  \"onsets\": ";
+        WriteArray(os, result.onsets, [](const Onset& o) {
+            return "{ \"time\": " + JsonNumber(o.seconds) + ", \"strength\": " + JsonNumber(o.strength) + " }";
+        });
+        os << ",\n";
+
+        WriteChunks(os, "lowPassChunks", result.lowPassChunks);
+        os << ",\n";
+        WriteChunks(os, "highPassChunks", result.highPassChunks);
+        os << "\n}\n";
+
+        os.flush();
+        if (!os)
+        {
+            SetError(errorMessage, "Failed to write results file: " + outFile.string());
+            return false;
+        }
+        return true;
+    }
+}
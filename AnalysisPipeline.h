@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "AnalysisFrontEnd.h"
+#include "BPMDetection.h"
+#include "Keys.h"
+#include "NoteSegmentor.h"
+#include "TaskGraph.h"
+
+namespace audiofile
+{
+    class DecodeCache;
+}
+
+namespace analysis
+{
+    struct TrackOptions
+    {
+        bool runStemSeparation = false;          // demucs via StemSeperator (slow, GPU)
+        int filterCutoffHz = 200;                // low/high split used for the MIDI chunking
+        FrontEndOptions frontEnd;                // decimated signal shared by key and beat-grid detection
+        int pitchBinsPerOctave = 36;             // constant-Q note detection for the MIDI chunks; 0 = linear FFT peaks
+        bool detectOnsets = true;                // spectral-flux note onsets of the full mix
+        OnsetConfig onsets;                      // sampleRate is taken from the decoded audio
+        std::filesystem::path midiFile;          // transcription written here once the MIDI passes finish; empty = none
+        audiofile::DecodeCache* decodeCache = nullptr; // optional, shared between tracks
+        threading::WorkerPool* pool = nullptr;         // runs independent stages concurrently; null = caller's thread only
+    };
+
+    struct ChunkSummary
+    {
+        int index = 0;
+        double startSeconds = 0.0;
+        double endSeconds = 0.0;
+        std::vector<double> frequencies;
+        std::vector<double> intensities;
+        std::vector<std::string> notes;
+    };
+
+    struct StemSummary
+    {
+        std::string name;
+        std::string path;
+        bool ok = false;
+        std::size_t frames = 0;
+    };
+
+    // Everything one headless run of the Stem -> Key -> BPM -> MIDI pipeline produces.
+    struct TrackResult
+    {
+        std::string path;
+        bool ok = false;
+        std::string error;
+
+        int sampleRate = 0;
+        int channels = 0;
+        double durationSeconds = 0.0;
+        Key key = Key::NO_KEY;
+        std::string keyName;
+        BPMDetection::BeatGridEstimate grid{};
+        std::vector<Onset> onsets;
+
+        std::vector<StemSummary> stems;
+        std::vector<ChunkSummary> lowPassChunks;
+        std::vector<ChunkSummary> highPassChunks;
+        std::string midiPath;                    // empty unless the MIDI file was written
+
+        std::vector<threading::TaskGraph::StageTiming> stageTimings;
+        double elapsedSeconds = 0.0;
+    };
+
+    // Runs the full analysis for one file without touching any Win32 window.
+    // Stages form a TaskGraph: key, beat grid, onsets and both filters run side by side once the
+    // audio is decoded, and each MIDI pass starts as soon as its filter, key and grid are done.
+    // With TrackOptions::midiFile set, the passes end in one .mid: one track per separated stem
+    // when stem separation ran, otherwise the low and high bands.
+    // Never throws; failures are reported through TrackResult::ok / error.
+    TrackResult AnalyzeTrack(const std::string& path, const TrackOptions& options);
+
+    // Writes the result as a small JSON document.
+    bool WriteTrackResult(const TrackResult& result, const std::filesystem::path& outFile, std::string* errorMessage = nullptr);
+}
@@ -1,12 +1,17 @@
 #include "AudioEngine.h"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cmath>
 #include <cstring>
 #include <mutex>
 #include <windows.h>
 
+#include "Biquad.h"
+#include "DSP.h"
+#include "Profiler.h"
+
 #if __has_include("third_party/miniaudio.h")
 #define WAVEOUT_HAS_MINIAUDIO 1
 #define MINIAUDIO_IMPLEMENTATION
@@ -141,17 +146,6 @@ namespace audio
 {
     struct AudioEngine::Impl
     {
-        struct Biquad
-        {
-            double b0 = 1.0, b1 = 0.0, b2 = 0.0;
-            double a1 = 0.0, a2 = 0.0;
-        };
-
-        struct BiquadState
-        {
-            double z1 = 0.0, z2 = 0.0;
-        };
-
 #if WAVEOUT_HAS_MINIAUDIO
         ma_device device{};
         bool deviceInitialized = false;
@@ -177,12 +171,7 @@ namespace audio
         double eqCoeffLowDb = 0.0;
         double eqCoeffMidDb = 0.0;
         double eqCoeffHighDb = 0.0;
-        Biquad eqLow;
-        Biquad eqMid;
-        Biquad eqHigh;
-        BiquadState eqLowState[2]{};
-        BiquadState eqMidState[2]{};
-        BiquadState eqHighState[2]{};
+        dsp::BiquadBank eq{ 2, 3 }; // low shelf, mid bell, high shelf over the L/R mix
         std::atomic<double> playbackRate{ 1.0 };
         double currentFrameExact = 0.0; // protected by sourceMutex in callback/seek paths
         std::atomic<unsigned long long> currentFrame{ 0 };
@@ -191,12 +180,7 @@ namespace audio
 
         void resetEqStates()
         {
-            eqLowState[0] = {};
-            eqLowState[1] = {};
-            eqMidState[0] = {};
-            eqMidState[1] = {};
-            eqHighState[0] = {};
-            eqHighState[1] = {};
+            eq.reset();
         }
 
         void closeFileSource()
@@ -287,26 +271,6 @@ namespace audio
             return true;
         }
 
-        static Biquad normalizeBiquad(double b0, double b1, double b2, double a0, double a1, double a2)
-        {
-            const double invA0 = (std::fabs(a0) > 1e-18) ? (1.0 / a0) : 1.0;
-            Biquad q{};
-            q.b0 = b0 * invA0;
-            q.b1 = b1 * invA0;
-            q.b2 = b2 * invA0;
-            q.a1 = a1 * invA0;
-            q.a2 = a2 * invA0;
-            return q;
-        }
-
-        static double processBiquad(const Biquad& q, double x, BiquadState& s)
-        {
-            const double y = q.b0 * x + s.z1;
-            s.z1 = q.b1 * x - q.a1 * y + s.z2;
-            s.z2 = q.b2 * x - q.a2 * y;
-            return y;
-        }
-
         void rebuildEqCoeffsIfNeeded(const LiveMixConfig& cfg)
         {
             if (sampleRate <= 0) return;
@@ -319,68 +283,10 @@ namespace audio
                 return;
             }
 
-            auto make_peaking = [&](double fc, double q, double gainDb) -> Biquad
-            {
-                const double fs = static_cast<double>(sampleRate);
-                fc = (std::min)((std::max)(fc, 10.0), fs * 0.45);
-                q = (std::max)(q, 0.1);
-                const double A = std::pow(10.0, gainDb / 40.0);
-                const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
-                const double cw0 = std::cos(w0);
-                const double sw0 = std::sin(w0);
-                const double alpha = sw0 / (2.0 * q);
-                return normalizeBiquad(
-                    1.0 + alpha * A,
-                    -2.0 * cw0,
-                    1.0 - alpha * A,
-                    1.0 + alpha / A,
-                    -2.0 * cw0,
-                    1.0 - alpha / A);
-            };
-
-            auto make_lowshelf = [&](double fc, double slope, double gainDb) -> Biquad
-            {
-                const double fs = static_cast<double>(sampleRate);
-                fc = (std::min)((std::max)(fc, 10.0), fs * 0.45);
-                slope = (std::max)(slope, 0.1);
-                const double A = std::pow(10.0, gainDb / 40.0);
-                const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
-                const double cw0 = std::cos(w0);
-                const double sw0 = std::sin(w0);
-                const double alpha = sw0 * 0.5 * std::sqrt((A + 1.0 / A) * (1.0 / slope - 1.0) + 2.0);
-                const double t = 2.0 * std::sqrt(A) * alpha;
-                return normalizeBiquad(
-                    A * ((A + 1.0) - (A - 1.0) * cw0 + t),
-                    2.0 * A * ((A - 1.0) - (A + 1.0) * cw0),
-                    A * ((A + 1.0) - (A - 1.0) * cw0 - t),
-                    (A + 1.0) + (A - 1.0) * cw0 + t,
-                    -2.0 * ((A - 1.0) + (A + 1.0) * cw0),
-                    (A + 1.0) + (A - 1.0) * cw0 - t);
-            };
-
-            auto make_highshelf = [&](double fc, double slope, double gainDb) -> Biquad
-            {
-                const double fs = static_cast<double>(sampleRate);
-                fc = (std::min)((std::max)(fc, 10.0), fs * 0.45);
-                slope = (std::max)(slope, 0.1);
-                const double A = std::pow(10.0, gainDb / 40.0);
-                const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
-                const double cw0 = std::cos(w0);
-                const double sw0 = std::sin(w0);
-                const double alpha = sw0 * 0.5 * std::sqrt((A + 1.0 / A) * (1.0 / slope - 1.0) + 2.0);
-                const double t = 2.0 * std::sqrt(A) * alpha;
-                return normalizeBiquad(
-                    A * ((A + 1.0) + (A - 1.0) * cw0 + t),
-                    -2.0 * A * ((A - 1.0) + (A + 1.0) * cw0),
-                    A * ((A + 1.0) + (A - 1.0) * cw0 - t),
-                    (A + 1.0) - (A - 1.0) * cw0 + t,
-                    2.0 * ((A - 1.0) - (A + 1.0) * cw0),
-                    (A + 1.0) - (A - 1.0) * cw0 - t);
-            };
-
-            eqLow = make_lowshelf(220.0, 0.9, cfg.eqLowDb);
-            eqMid = make_peaking(1000.0, 0.75, cfg.eqMidDb);
-            eqHigh = make_highshelf(4200.0, 0.9, cfg.eqHighDb);
+            const std::array<dsp::BiquadCoeffs, 3> sections =
+                dsp::design_playback_eq(static_cast<double>(sampleRate), cfg.eqLowDb, cfg.eqMidDb, cfg.eqHighDb);
+            for (int i = 0; i < 3; ++i)
+                eq.set_section(i, sections[static_cast<std::size_t>(i)]);
 
             eqCoeffsValid = true;
             eqCoeffSampleRate = sampleRate;
@@ -396,16 +302,14 @@ namespace audio
 
         static inline short normToPcm16(double x)
         {
-            if (!std::isfinite(x)) x = 0.0;
-            if (x > 1.0) x = 1.0;
-            if (x < -1.0) x = -1.0;
-            return static_cast<short>(std::lround(x * 32767.0));
+            return dsp::float_to_pcm16(x);
         }
     };
 
 #if WAVEOUT_HAS_MINIAUDIO
     void AudioEngine::Impl::audio_callback(ma_device* pDevice, void* pOutput, const void* /*pInput*/, ma_uint32 frameCount)
     {
+        // Real-time thread: no WAVEOUT_PROFILE_* here, the profiler locks and allocates.
         auto* impl = static_cast<AudioEngine::Impl*>(pDevice ? pDevice->pUserData : nullptr);
         if (!impl || !pOutput)
             return;
@@ -437,9 +341,9 @@ namespace audio
 
         auto getTotalFramesFor = [](const MixSourceView& s) -> std::size_t
         {
-            if (!s.interleavedPcm16 || s.sampleRate <= 0) return 0;
+            if (s.sampleRate <= 0) return 0;
             const std::size_t c = static_cast<std::size_t>((std::max)(1, (std::min)(2, s.channels)));
-            return s.interleavedPcm16->size() / c;
+            return s.Samples().size() / c;
         };
         auto getTotalFramesForMain = [&](const MixSourceView& s) -> std::size_t
         {
@@ -490,7 +394,8 @@ namespace audio
             if (srcFrameD < 0.0)
                 return;
 
-            if (!s.interleavedPcm16 || s.interleavedPcm16->empty())
+            const audiofile::Pcm16Span pcm = s.Samples();
+            if (pcm.empty())
             {
                 if (impl->fileSourceValid && (&s == &cfg.main))
                 {
@@ -511,7 +416,7 @@ namespace audio
             }
 
             const int srcCh = (std::max)(1, (std::min)(2, s.channels));
-            const std::size_t srcFrames = s.interleavedPcm16->size() / static_cast<std::size_t>(srcCh);
+            const std::size_t srcFrames = pcm.size() / static_cast<std::size_t>(srcCh);
             if (srcFrames == 0) return;
             const double maxSrc = static_cast<double>(srcFrames - 1);
             if (srcFrameD > maxSrc) return;
@@ -522,21 +427,56 @@ namespace audio
 
             const std::size_t b0 = i0 * static_cast<std::size_t>(srcCh);
             const std::size_t b1 = i1 * static_cast<std::size_t>(srcCh);
-            const double l0 = pcm16ToNorm((*s.interleavedPcm16)[b0]);
-            const double r0 = (srcCh >= 2 && (b0 + 1) < s.interleavedPcm16->size())
-                ? pcm16ToNorm((*s.interleavedPcm16)[b0 + 1])
+            const double l0 = pcm16ToNorm(pcm[b0]);
+            const double r0 = (srcCh >= 2 && (b0 + 1) < pcm.size())
+                ? pcm16ToNorm(pcm[b0 + 1])
                 : l0;
-            const double l1 = pcm16ToNorm((*s.interleavedPcm16)[b1]);
-            const double r1 = (srcCh >= 2 && (b1 + 1) < s.interleavedPcm16->size())
-                ? pcm16ToNorm((*s.interleavedPcm16)[b1 + 1])
+            const double l1 = pcm16ToNorm(pcm[b1]);
+            const double r1 = (srcCh >= 2 && (b1 + 1) < pcm.size())
+                ? pcm16ToNorm(pcm[b1 + 1])
                 : l1;
 
             outL = l0 + (l1 - l0) * t;
             outR = r0 + (r1 - r0) * t;
         };
 
-        std::size_t renderedFrames = 0;
-        for (; renderedFrames < static_cast<std::size_t>(frameCount); ++renderedFrames)
+        // Frames are mixed into a small stereo block first so the EQ cascade runs over a whole
+        // block at a time (both channels in one pass) instead of sample by sample.
+        constexpr std::size_t MIX_BLOCK = 256;
+        double mix[MIX_BLOCK * 2];
+        std::size_t blockStart = 0;
+        std::size_t blockFrames = 0;
+        auto flushMix = [&]()
+        {
+            if (blockFrames == 0) return;
+            if (eqActive)
+                impl->eq.process(mix, mix, blockFrames);
+            for (std::size_t i = 0; i < blockFrames; ++i)
+            {
+                double l = mix[2 * i];
+                double r = mix[2 * i + 1];
+                if (gainActive)
+                {
+                    l *= masterGain;
+                    r *= masterGain;
+                }
+
+                const std::size_t outBase = (blockStart + i) * static_cast<std::size_t>(ch);
+                if (ch >= 2)
+                {
+                    out[outBase] = normToPcm16(l);
+                    out[outBase + 1] = normToPcm16(r);
+                }
+                else
+                {
+                    out[outBase] = normToPcm16(0.5 * (l + r));
+                }
+            }
+            blockStart += blockFrames;
+            blockFrames = 0;
+        };
+
+        for (std::size_t renderedFrames = 0; renderedFrames < static_cast<std::size_t>(frameCount); ++renderedFrames)
         {
             if (cursorD >= static_cast<double>(totalFrames))
                 break;
@@ -560,42 +500,14 @@ namespace audio
                 }
             }
 
-            if (eqActive)
-            {
-                l = processBiquad(impl->eqLow, l, impl->eqLowState[0]);
-                l = processBiquad(impl->eqMid, l, impl->eqMidState[0]);
-                l = processBiquad(impl->eqHigh, l, impl->eqHighState[0]);
-                if (ch >= 2)
-                {
-                    r = processBiquad(impl->eqLow, r, impl->eqLowState[1]);
-                    r = processBiquad(impl->eqMid, r, impl->eqMidState[1]);
-                    r = processBiquad(impl->eqHigh, r, impl->eqHighState[1]);
-                }
-                else
-                {
-                    r = l;
-                }
-            }
-
-            if (gainActive)
-            {
-                l *= masterGain;
-                r *= masterGain;
-            }
-
-            const std::size_t outBase = renderedFrames * static_cast<std::size_t>(ch);
-            if (ch >= 2)
-            {
-                out[outBase] = normToPcm16(l);
-                out[outBase + 1] = normToPcm16(r);
-            }
-            else
-            {
-                out[outBase] = normToPcm16(0.5 * (l + r));
-            }
+            mix[2 * blockFrames] = l;
+            mix[2 * blockFrames + 1] = r;
+            if (++blockFrames == MIX_BLOCK)
+                flushMix();
 
             cursorD += playbackRate;
         }
+        flushMix();
 
         impl->currentFrameExact = cursorD;
         const std::size_t cursorFrame = (cursorD <= 0.0)
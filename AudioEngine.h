@@ -4,13 +4,21 @@
 #include <string>
 #include <vector>
 
+#include "AudioFileLoader.h"
+
 namespace audio
 {
     struct MixSourceView
     {
-        std::vector<short>* interleavedPcm16 = nullptr; // non-owning
+        std::vector<short>* interleavedPcm16 = nullptr; // non-owning; re-read each callback so the vector may be swapped
+        audiofile::Pcm16Span mappedPcm16{};              // non-owning fixed view (e.g. memory-mapped stem), used when interleavedPcm16 is null
         int sampleRate = 0;
         int channels = 2;
+
+        audiofile::Pcm16Span Samples() const
+        {
+            return interleavedPcm16 ? audiofile::Pcm16Span(*interleavedPcm16) : mappedPcm16;
+        }
     };
 
     struct LiveMixConfig
@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <cstdint>
 #include <sstream>
+#include <utility>
+
+#include "Profiler.h"
 
 #if __has_include("third_party/miniaudio.h")
 #include "third_party/miniaudio.h"
@@ -22,19 +25,57 @@ namespace audiofile
         {
             if (outErr) *outErr = msg;
         }
+
+        // Block size used when pulling a whole file through StreamingDecoder.
+        constexpr std::size_t kLoadBlockFrames = 16384;
     }
 
-    bool AudioFileLoader::LoadPcm16(const std::string& path, DecodedPcm16& out, std::string* errorMessage)
+    struct StreamingDecoder::Impl
     {
-        out = {};
+#if WAVEOUT_HAS_MINIAUDIO_DECODER
+        ma_decoder decoder{};
+#endif
+        bool open = false;
+        bool error = false;
+        int sampleRate = 0;
+        int channels = 0;
+    };
+
+    StreamingDecoder::StreamingDecoder()
+        : m_impl(new Impl())
+    {
+    }
+
+    StreamingDecoder::~StreamingDecoder()
+    {
+        Close();
+        delete m_impl;
+    }
+
+    StreamingDecoder::StreamingDecoder(StreamingDecoder&& other) noexcept
+        : m_impl(other.m_impl)
+    {
+        other.m_impl = new Impl();
+    }
+
+    StreamingDecoder& StreamingDecoder::operator=(StreamingDecoder&& other) noexcept
+    {
+        if (this != &other)
+            std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    bool StreamingDecoder::Open(const std::string& path, std::string* errorMessage)
+    {
+        Close();
 
 #if !WAVEOUT_HAS_MINIAUDIO_DECODER
+        (void)path;
         SetError(errorMessage, "miniaudio.h not found; cannot decode MP3/FLAC/WAV.");
         return false;
 #else
         ma_decoder_config cfg = ma_decoder_config_init(ma_format_s16, 0, 0);
-        ma_decoder decoder{};
-        const ma_result initRes = ma_decoder_init_file(path.c_str(), &cfg, &decoder);
+        const ma_result initRes = ma_decoder_init_file(path.c_str(), &cfg, &m_impl->decoder);
         if (initRes != MA_SUCCESS)
         {
             std::ostringstream oss;
@@ -46,87 +87,223 @@ namespace audiofile
         ma_format fmt = ma_format_unknown;
         ma_uint32 ch = 0;
         ma_uint32 sr = 0;
-        if (ma_decoder_get_data_format(&decoder, &fmt, &ch, &sr, nullptr, 0) != MA_SUCCESS)
+        if (ma_decoder_get_data_format(&m_impl->decoder, &fmt, &ch, &sr, nullptr, 0) != MA_SUCCESS)
         {
-            ma_decoder_uninit(&decoder);
+            ma_decoder_uninit(&m_impl->decoder);
             SetError(errorMessage, "ma_decoder_get_data_format failed.");
             return false;
         }
 
         if (fmt != ma_format_s16 || ch == 0 || sr == 0)
         {
-            ma_decoder_uninit(&decoder);
+            ma_decoder_uninit(&m_impl->decoder);
             SetError(errorMessage, "Decoder did not produce valid PCM16 output.");
             return false;
         }
 
-        out.sampleRate = static_cast<int>(sr);
-        out.channels = static_cast<int>(ch);
+        m_impl->open = true;
+        m_impl->error = false;
+        m_impl->sampleRate = static_cast<int>(sr);
+        m_impl->channels = static_cast<int>(ch);
+        return true;
+#endif
+    }
 
-        ma_uint64 totalFrames = 0;
-        const ma_result lenRes = ma_decoder_get_length_in_pcm_frames(&decoder, &totalFrames);
-        const std::size_t channels = static_cast<std::size_t>((std::max)(1u, ch));
+    void StreamingDecoder::Close()
+    {
+        if (!m_impl || !m_impl->open)
+            return;
+#if WAVEOUT_HAS_MINIAUDIO_DECODER
+        ma_decoder_uninit(&m_impl->decoder);
+#endif
+        *m_impl = Impl();
+    }
+
+    bool StreamingDecoder::IsOpen() const
+    {
+        return m_impl && m_impl->open;
+    }
 
-        if (lenRes == MA_SUCCESS && totalFrames > 0)
+    std::size_t StreamingDecoder::ReadFrames(short* dst, std::size_t frameCount)
+    {
+        if (!IsOpen() || !dst || frameCount == 0)
+            return 0;
+
+#if WAVEOUT_HAS_MINIAUDIO_DECODER
+        ma_uint64 framesRead = 0;
+        const ma_result readRes = ma_decoder_read_pcm_frames(
+            &m_impl->decoder, dst, static_cast<ma_uint64>(frameCount), &framesRead);
+        if (readRes != MA_SUCCESS && readRes != MA_AT_END)
         {
-            out.samples.resize(static_cast<std::size_t>(totalFrames) * channels);
+            m_impl->error = true;
+            return 0;
+        }
+        return static_cast<std::size_t>(framesRead);
+#else
+        return 0;
+#endif
+    }
 
-            ma_uint64 framesReadTotal = 0;
-            while (framesReadTotal < totalFrames)
-            {
-                ma_uint64 framesRead = 0;
-                const ma_result readRes = ma_decoder_read_pcm_frames(
-                    &decoder,
-                    out.samples.data() + static_cast<std::size_t>(framesReadTotal) * channels,
-                    totalFrames - framesReadTotal,
-                    &framesRead);
-                if (readRes != MA_SUCCESS && readRes != MA_AT_END)
-                {
-                    out.samples.clear();
-                    break;
-                }
-                if (framesRead == 0)
-                    break;
-                framesReadTotal += framesRead;
-            }
+    bool StreamingDecoder::SeekFrame(std::uint64_t frame)
+    {
+        if (!IsOpen())
+            return false;
 
-            if (framesReadTotal == 0)
-            {
-                out.samples.clear();
-            }
-            else if (framesReadTotal < totalFrames)
+#if WAVEOUT_HAS_MINIAUDIO_DECODER
+        return ma_decoder_seek_to_pcm_frame(&m_impl->decoder, static_cast<ma_uint64>(frame)) == MA_SUCCESS;
+#else
+        (void)frame;
+        return false;
+#endif
+    }
+
+    bool StreamingDecoder::GetTotalFramesHint(std::uint64_t& outFrames) const
+    {
+        outFrames = 0;
+        if (!IsOpen())
+            return false;
+
+#if WAVEOUT_HAS_MINIAUDIO_DECODER
+        ma_uint64 totalFrames = 0;
+        if (ma_decoder_get_length_in_pcm_frames(&m_impl->decoder, &totalFrames) != MA_SUCCESS || totalFrames == 0)
+            return false;
+        outFrames = static_cast<std::uint64_t>(totalFrames);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::uint64_t StreamingDecoder::GetCursorFrame() const
+    {
+        if (!IsOpen())
+            return 0;
+
+#if WAVEOUT_HAS_MINIAUDIO_DECODER
+        ma_uint64 cursor = 0;
+        if (ma_decoder_get_cursor_in_pcm_frames(&m_impl->decoder, &cursor) != MA_SUCCESS)
+            return 0;
+        return static_cast<std::uint64_t>(cursor);
+#else
+        return 0;
+#endif
+    }
+
+    int StreamingDecoder::GetSampleRate() const
+    {
+        return m_impl ? m_impl->sampleRate : 0;
+    }
+
+    int StreamingDecoder::GetChannels() const
+    {
+        return m_impl ? m_impl->channels : 0;
+    }
+
+    bool StreamingDecoder::HasError() const
+    {
+        return m_impl && m_impl->error;
+    }
+
+    bool AudioFileLoader::LoadPcm16(const std::string& path, DecodedPcm16& out, std::string* errorMessage)
+    {
+        WAVEOUT_PROFILE_SCOPE("decode.loadPcm16");
+        out = {};
+
+        StreamingDecoder decoder;
+        if (!decoder.Open(path, errorMessage))
+            return false;
+
+        out.sampleRate = decoder.GetSampleRate();
+        out.channels = decoder.GetChannels();
+        const std::size_t channels = static_cast<std::size_t>((std::max)(1, out.channels));
+
+        // Reserve once from the container length when it is known; otherwise let the
+        // vector grow geometrically. Blocks are decoded straight into the tail of the
+        // output so there is no intermediate copy.
+        std::uint64_t hintFrames = 0;
+        if (decoder.GetTotalFramesHint(hintFrames))
+            out.samples.reserve((static_cast<std::size_t>(hintFrames) + kLoadBlockFrames) * channels);
+
+        std::size_t framesTotal = 0;
+        for (;;)
+        {
+            const std::size_t want = kLoadBlockFrames;
+            if (out.samples.size() < (framesTotal + want) * channels)
             {
-                out.samples.resize(static_cast<std::size_t>(framesReadTotal) * channels);
+                if (out.samples.capacity() < (framesTotal + want) * channels)
+                    out.samples.reserve((std::max)(out.samples.capacity() * 2, (framesTotal + want) * channels));
+                out.samples.resize((framesTotal + want) * channels);
             }
+
+            const std::size_t got = decoder.ReadFrames(out.samples.data() + framesTotal * channels, want);
+            if (got == 0)
+                break;
+            framesTotal += got;
+        }
+
+        if (decoder.HasError())
+        {
+            out.samples.clear();
         }
         else
         {
-            constexpr ma_uint64 kChunkFrames = 4096;
-            std::vector<short> temp(static_cast<std::size_t>(kChunkFrames) * channels);
-            for (;;)
-            {
-                ma_uint64 framesRead = 0;
-                const ma_result readRes = ma_decoder_read_pcm_frames(&decoder, temp.data(), kChunkFrames, &framesRead);
-                if (readRes != MA_SUCCESS && readRes != MA_AT_END)
-                {
-                    out.samples.clear();
-                    break;
-                }
-                if (framesRead == 0)
-                    break;
-                const std::size_t samplesRead = static_cast<std::size_t>(framesRead) * channels;
-                out.samples.insert(out.samples.end(), temp.begin(), temp.begin() + static_cast<std::ptrdiff_t>(samplesRead));
-            }
+            out.samples.resize(framesTotal * channels);
+            // Only trim if the hint was badly off; the common case already fits exactly.
+            if (out.samples.capacity() > out.samples.size() + kLoadBlockFrames * channels)
+                out.samples.shrink_to_fit();
         }
 
-        ma_decoder_uninit(&decoder);
-
         if (out.samples.empty())
         {
             SetError(errorMessage, "Decoded audio contained no samples.");
             return false;
         }
+        WAVEOUT_PROFILE_BYTES(out.samples.capacity() * sizeof(short));
+        WAVEOUT_PROFILE_COUNT("decode.frames", framesTotal);
         return true;
-#endif
+    }
+
+    std::vector<short> AudioFileLoader::ToInterleavedStereo(Pcm16Span src, int channels)
+    {
+        if (channels <= 0 || src.empty()) return {};
+
+        if (channels == 2)
+            return std::vector<short>(src.begin(), src.end());
+
+        const std::size_t ch = static_cast<std::size_t>(channels);
+        const std::size_t frames = src.size() / ch;
+        std::vector<short> out(frames * 2, 0);
+
+        if (channels == 1)
+        {
+            for (std::size_t i = 0; i < frames; ++i)
+            {
+                const short s = src[i];
+                out[2 * i] = s;
+                out[2 * i + 1] = s;
+            }
+            return out;
+        }
+
+        // Downmix multi-channel inputs to stereo by averaging even/odd channel groups.
+        for (std::size_t i = 0; i < frames; ++i)
+        {
+            const std::size_t base = i * ch;
+            long long accL = 0;
+            long long accR = 0;
+            int nL = 0;
+            int nR = 0;
+            for (int c = 0; c < channels; ++c)
+            {
+                const short s = src[base + static_cast<std::size_t>(c)];
+                if ((c % 2) == 0) { accL += s; ++nL; }
+                else { accR += s; ++nR; }
+            }
+            if (nL == 0) { accL = accR; nL = (nR > 0 ? nR : 1); }
+            if (nR == 0) { accR = accL; nR = (nL > 0 ? nL : 1); }
+            out[2 * i] = static_cast<short>(accL / nL);
+            out[2 * i + 1] = static_cast<short>(accR / nR);
+        }
+        return out;
     }
 }
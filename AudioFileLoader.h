@@ -1,10 +1,33 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace audiofile
 {
+    // Non-owning, read-only view of interleaved PCM16 samples. Backed either by a
+    // std::vector owned elsewhere or by a memory-mapped file (see MappedWavFile).
+    class Pcm16Span
+    {
+    public:
+        Pcm16Span() = default;
+        Pcm16Span(const short* data, std::size_t size) : m_data(data), m_size(data ? size : 0) {}
+        Pcm16Span(const std::vector<short>& v) : m_data(v.data()), m_size(v.size()) {}
+
+        const short* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        const short& operator[](std::size_t i) const { return m_data[i]; }
+        const short* begin() const { return m_data; }
+        const short* end() const { return m_data + m_size; }
+
+    private:
+        const short* m_data = nullptr;
+        std::size_t m_size = 0;
+    };
+
     struct DecodedPcm16
     {
         std::vector<short> samples; // interleaved PCM16
@@ -12,12 +35,56 @@ namespace audiofile
         int channels = 0;
     };
 
+    // Pull-based PCM16 decoder on top of miniaudio's ma_decoder.
+    // Callers pull fixed-size blocks into their own buffers, so peak memory is bounded
+    // by the block size instead of the song length.
+    class StreamingDecoder
+    {
+    public:
+        StreamingDecoder();
+        ~StreamingDecoder();
+
+        StreamingDecoder(const StreamingDecoder&) = delete;
+        StreamingDecoder& operator=(const StreamingDecoder&) = delete;
+
+        StreamingDecoder(StreamingDecoder&& other) noexcept;
+        StreamingDecoder& operator=(StreamingDecoder&& other) noexcept;
+
+        // Opens any miniaudio-supported file (WAV/MP3/FLAC) at its native rate/channel count.
+        bool Open(const std::string& path, std::string* errorMessage = nullptr);
+        void Close();
+        bool IsOpen() const;
+
+        // Reads up to frameCount interleaved frames into dst (dst must hold frameCount * GetChannels()
+        // shorts). Returns the number of frames written; 0 means end of stream or a decode error
+        // (check HasError()).
+        std::size_t ReadFrames(short* dst, std::size_t frameCount);
+        bool SeekFrame(std::uint64_t frame);
+
+        // Length reported by the container. Returns false if the length is unknown up front
+        // (e.g. VBR MP3 without a Xing/Info header); the stream is still readable to the end.
+        bool GetTotalFramesHint(std::uint64_t& outFrames) const;
+        std::uint64_t GetCursorFrame() const;
+
+        int GetSampleRate() const;
+        int GetChannels() const;
+        bool HasError() const;
+
+    private:
+        struct Impl;
+        Impl* m_impl;
+    };
+
     class AudioFileLoader
     {
     public:
         // Decodes an audio file (WAV/MP3/FLAC and any miniaudio-supported format)
         // into interleaved PCM16 at the file's native sample rate/channel count.
+        // Thin wrapper over StreamingDecoder for callers that want the whole song in memory.
         static bool LoadPcm16(const std::string& path, DecodedPcm16& out, std::string* errorMessage = nullptr);
+
+        // Converts interleaved PCM16 with any channel count to interleaved stereo: mono is
+        // duplicated, more than two channels are downmixed (even channels left, odd right).
+        static std::vector<short> ToInterleavedStereo(Pcm16Span src, int channels);
     };
 }
-
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+
+#include "AudioFileLoader.h"
+
+namespace audiofile
+{
+    // Non-owning, read-only view of PCM16 frames: (pointer, frames, channels, stride).
+    //
+    // Sample (frame f, channel c) lives at data[f * stride + c]. Channel() narrows an interleaved
+    // view to one channel without copying, and Mono() downmixes on the fly, so stages that used to
+    // take LeftRight()/Consolidate() copies can read straight from the decoded buffer. The view does
+    // not keep the samples alive; the owning vector or mapping must outlive it.
+    class AudioView
+    {
+    public:
+        AudioView() = default;
+        AudioView(const short* data, std::size_t frames, int channels, std::size_t stride)
+            : m_data(data), m_frames(data ? frames : 0), m_channels(channels), m_stride(stride)
+        {
+        }
+
+        // Interleaved samples with `channels` channels; a trailing partial frame is ignored.
+        static AudioView Interleaved(Pcm16Span samples, int channels)
+        {
+            if (channels <= 0)
+                return AudioView();
+            const std::size_t ch = static_cast<std::size_t>(channels);
+            return AudioView(samples.data(), samples.size() / ch, channels, ch);
+        }
+
+        const short* data() const { return m_data; }
+        std::size_t Frames() const { return m_frames; }
+        int Channels() const { return m_channels; }
+        std::size_t Stride() const { return m_stride; }
+        bool empty() const { return m_frames == 0 || m_channels <= 0; }
+
+        short At(std::size_t frame, int channel) const { return m_data[frame * m_stride + static_cast<std::size_t>(channel)]; }
+
+        // Mean of all channels of one frame, in PCM16 units.
+        float Mono(std::size_t frame) const
+        {
+            const short* f = m_data + frame * m_stride;
+            if (m_channels == 1)
+                return static_cast<float>(f[0]);
+            if (m_channels == 2)
+                return (static_cast<float>(f[0]) + static_cast<float>(f[1])) * 0.5f;
+            float sum = 0.0f;
+            for (int c = 0; c < m_channels; ++c)
+                sum += static_cast<float>(f[c]);
+            return sum / static_cast<float>(m_channels);
+        }
+
+        // Single-channel view of channel c (no copy).
+        AudioView Channel(int c) const
+        {
+            if (c < 0 || c >= m_channels)
+                return AudioView();
+            return AudioView(m_data + c, m_frames, 1, m_stride);
+        }
+
+        // Frames [startFrame, startFrame + frameCount), clamped to the view.
+        AudioView Slice(std::size_t startFrame, std::size_t frameCount) const
+        {
+            if (startFrame >= m_frames)
+                return AudioView(m_data, 0, m_channels, m_stride);
+            if (frameCount > m_frames - startFrame)
+                frameCount = m_frames - startFrame;
+            return AudioView(m_data + startFrame * m_stride, frameCount, m_channels, m_stride);
+        }
+
+        // Copy helpers for stages that genuinely need contiguous storage (e.g. FFT input).
+        // dst must hold Frames() elements.
+        template <typename T>
+        void CopyChannel(int c, T* dst) const
+        {
+            const short* src = m_data + c;
+            for (std::size_t i = 0; i < m_frames; ++i)
+                dst[i] = static_cast<T>(src[i * m_stride]);
+        }
+
+        template <typename T>
+        void CopyMono(T* dst) const
+        {
+            for (std::size_t i = 0; i < m_frames; ++i)
+                dst[i] = static_cast<T>(Mono(i));
+        }
+
+    private:
+        const short* m_data = nullptr;
+        std::size_t m_frames = 0;
+        int m_channels = 0;
+        std::size_t m_stride = 0;
+    };
+}
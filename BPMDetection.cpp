@@ -4,6 +4,9 @@
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include "AudioView.h"
+#include "Profiler.h"
+#include "RollingStats.h"
 
 extern "C"
 {
@@ -23,6 +26,16 @@ namespace
         return bpm;
     }
 
+    // Frame/hop sizes below were tuned at 44.1 kHz; this keeps their duration at other rates
+    // (nearest power of two, so 44.1 and 48 kHz use the sizes unchanged).
+    static uint_t framesAtRate(uint_t frames44k, int sampleRate)
+    {
+        const double scaled = (double)frames44k * (double)sampleRate / 44100.0;
+        uint_t n = 16;
+        while (n < frames44k && (double)n * 1.5 < scaled) n *= 2;
+        return n;
+    }
+
     static std::vector<float> ToMonoFloat(const std::vector<double>& monoPcm)
     {
         std::vector<float> y;
@@ -31,6 +44,16 @@ namespace
         return y;
     }
 
+    // Fused downmix: one pass from the (possibly interleaved) PCM16 buffer to mono float.
+    static std::vector<float> ToMonoFloat(const audiofile::AudioView& audio)
+    {
+        WAVEOUT_PROFILE_SCOPE("bpm.toMonoFloat");
+        std::vector<float> y(audio.Frames());
+        WAVEOUT_PROFILE_BYTES(y.size() * sizeof(float));
+        audio.CopyMono(y.data());
+        return y;
+    }
+
     static std::vector<float> NormalizeForAnalysis(std::vector<float> x)
     {
         float mx = 0.0f;
@@ -69,15 +92,18 @@ namespace
         if (mono.size() < static_cast<size_t>(frame) || sr <= 0) return 0.0;
         const double thr = std::pow(10.0, thresholdDb / 20.0);
         constexpr double eps = 1e-12;
-        for (size_t i = 0; i + static_cast<size_t>(frame) <= mono.size(); i += static_cast<size_t>(hop))
-        {
-            double sum2 = 0.0;
-            for (int j = 0; j < frame; ++j)
-            {
-                const double s = mono[i + j];
-                sum2 += s * s;
-            }
-            const double rms = std::sqrt(sum2 / static_cast<double>(frame) + eps);
+        // Mean square of the frame slides one sample at a time; frames start every hop.
+        dsp::SlidingMoments power(static_cast<size_t>(frame));
+        for (size_t e = 0; e < mono.size(); ++e)
+        {
+            const double s = mono[e];
+            power.push(s * s);
+            if (!power.full())
+                continue;
+            const size_t i = e + 1 - static_cast<size_t>(frame);
+            if (i % static_cast<size_t>(hop) != 0)
+                continue;
+            const double rms = std::sqrt(power.mean() + eps);
             if (rms >= thr)
                 return static_cast<double>(i) / static_cast<double>(sr);
         }
@@ -202,6 +228,7 @@ namespace
     static double bpmAutocorrOnsetLike(const std::vector<float>& mono, int sr, int hopLength = 256,
         double bpmMin = 60.0, double bpmMax = 200.0)
     {
+        WAVEOUT_PROFILE_SCOPE("bpm.onsetAutocorr");
         if (mono.empty() || sr <= 0 || hopLength <= 0) return 0.0;
 
         // Lightweight onset-strength proxy (librosa-like intent, not exact):
@@ -266,6 +293,7 @@ namespace
     static double refineBpmLocalAutocorr(const std::vector<float>& mono, int sr, double bpm0,
         double search = 2.0, double step = 0.01, int hopLength = 256)
     {
+        WAVEOUT_PROFILE_SCOPE("bpm.refineLocalAutocorr");
         bpm0 = foldBpm(bpm0);
         if (!std::isfinite(bpm0) || bpm0 <= 0.0) return 0.0;
         if (mono.empty() || sr <= 0 || hopLength <= 0) return bpm0;
@@ -519,6 +547,7 @@ namespace
         double search = 1.0, double step = 0.01, int windows = 7, double windowLenS = 18.0,
         double startFrac = 0.10, double endFrac = 0.90, double lam = 0.25)
     {
+        WAVEOUT_PROFILE_SCOPE("bpm.refineByDrift");
         const double duration = (sr > 0) ? ((double)mono.size() / (double)sr) : 0.0;
         if (duration < 30.0 || bpm0 <= 0.0 || sr <= 0) return bpm0;
 
@@ -576,8 +605,9 @@ namespace
 
     static double aubioTempoMedianAndReported(const std::vector<float>& mono, int sampleRate, double* outReported = nullptr)
     {
+        WAVEOUT_PROFILE_SCOPE("bpm.aubioTempo");
         if (sampleRate <= 0 || mono.empty()) return 0.0;
-        const uint_t win_size = 1024;
+        const uint_t win_size = framesAtRate(1024, sampleRate);
         const uint_t hop_size = win_size / 4;
 
         aubio_tempo_t* tempo = new_aubio_tempo("default", win_size, hop_size, (uint_t)sampleRate);
@@ -627,50 +657,96 @@ namespace
 }
 
 
-double BPMDetection::getBpmMonoAubio(const std::vector<double>& monoPcm, int sampleRate)
+namespace
 {
-    if (sampleRate <= 0 || monoPcm.empty()) return 0.0;
-    std::vector<float> mono = NormalizeForAnalysis(ToMonoFloat(monoPcm));
-    double aubioReported = 0.0;
-    double aubioMedian = aubioTempoMedianAndReported(mono, sampleRate, &aubioReported);
+    // Both entry points funnel into these so a grid estimate converts/normalizes the audio once.
+    double BpmFromNormalizedMono(const std::vector<float>& mono, int sampleRate)
+    {
+        WAVEOUT_PROFILE_SCOPE("bpm.estimate");
+        double aubioReported = 0.0;
+        double aubioMedian = aubioTempoMedianAndReported(mono, sampleRate, &aubioReported);
 
 	std::cout << "Detected BPM using median period: " << aubioMedian << "\n";
 	std::cout << "Detected BPM using aubio_get_bpm: " << aubioReported << "\n";
 
-    double onsetAc = bpmAutocorrOnsetLike(mono, sampleRate, 256, 60.0, 200.0);
-    std::cout << "Detected BPM using onset autocorr: " << onsetAc << "\n";
-    double bpm0 = clusterPickMedianFolded({ aubioMedian, aubioReported, onsetAc }, 1.5);
-    std::cout << "Clustered/folded BPM seed: " << bpm0 << "\n";
-    double refined = refineBpmLocalAutocorr(mono, sampleRate, bpm0, 2.0, 0.01, 256);
-    std::cout << "Refined BPM (autocorr local): " << refined << "\n";
-
-    if (refined > 0.0) return refined;
-    if (bpm0 > 0.0) return bpm0;
-    if (aubioMedian > 0.0) return aubioMedian;
-    return foldBpm(aubioReported);
+        const int hop = (int)framesAtRate(256, sampleRate);
+        double onsetAc = bpmAutocorrOnsetLike(mono, sampleRate, hop, 60.0, 200.0);
+        std::cout << "Detected BPM using onset autocorr: " << onsetAc << "\n";
+        double bpm0 = clusterPickMedianFolded({ aubioMedian, aubioReported, onsetAc }, 1.5);
+        std::cout << "Clustered/folded BPM seed: " << bpm0 << "\n";
+        double refined = refineBpmLocalAutocorr(mono, sampleRate, bpm0, 2.0, 0.01, hop);
+        std::cout << "Refined BPM (autocorr local): " << refined << "\n";
+
+        if (refined > 0.0) return refined;
+        if (bpm0 > 0.0) return bpm0;
+        if (aubioMedian > 0.0) return aubioMedian;
+        return foldBpm(aubioReported);
+    }
+
+    // tempoMono, when given, is the (cropped) window the tempo is estimated on.
+    BPMDetection::BeatGridEstimate GridFromNormalizedMono(const std::vector<float>& mono, int sampleRate,
+        const std::vector<float>* tempoMono = nullptr)
+    {
+        WAVEOUT_PROFILE_SCOPE("bpm.beatGrid");
+        BPMDetection::BeatGridEstimate out{};
+        out.bpm = BpmFromNormalizedMono(tempoMono ? *tempoMono : mono, sampleRate);
+        out.audioStart = firstAudioTimeByRms(mono, sampleRate, 0.02, 0.01, -45.0);
+        out.approxOnset = aubioFirstOnsetTime(mono, sampleRate, out.audioStart,
+            framesAtRate(1024, sampleRate), framesAtRate(128, sampleRate), "hfc", 0.25f, -60.0f, 0.08f);
+        out.kickAttack = findKickAttackStart(mono, sampleRate, out.approxOnset, 200.0, 80.0, 2.5, 6.0, 8.0, 180.0);
+
+        // Mirrors current Python default: ANCHOR_MODE="audio_start", SNAP_AFTER_AUDIO_START=False
+        out.t0 = out.audioStart;
+        if (!std::isfinite(out.t0) || out.t0 < 0.0) out.t0 = 0.0;
+
+        if (out.bpm > 0.0)
+        {
+            const double beforeDrift = out.bpm;
+            out.bpm = refineBpmByDrift(mono, sampleRate, out.t0, out.bpm, 1.0, 0.01, 7, 18.0, 0.10, 0.90, 0.25);
+            std::cout << "BPM before drift: " << beforeDrift << "  after drift: " << out.bpm << "\n";
+        }
+
+        return out;
+    }
 }
 
-BPMDetection::BeatGridEstimate BPMDetection::estimateBeatGridMonoAubio(const std::vector<double>& monoPcm, int sampleRate)
+double BPMDetection::getBpmMonoAubio(const std::vector<double>& monoPcm, int sampleRate)
 {
-    BeatGridEstimate out{};
-    if (sampleRate <= 0 || monoPcm.empty()) return out;
+    if (sampleRate <= 0 || monoPcm.empty()) return 0.0;
+    return BpmFromNormalizedMono(NormalizeForAnalysis(ToMonoFloat(monoPcm)), sampleRate);
+}
+
+double BPMDetection::getBpmMonoAubio(const audiofile::AudioView& audio, int sampleRate)
+{
+    if (sampleRate <= 0 || audio.empty()) return 0.0;
+    return BpmFromNormalizedMono(NormalizeForAnalysis(ToMonoFloat(audio)), sampleRate);
+}
 
-    std::vector<float> mono = NormalizeForAnalysis(ToMonoFloat(monoPcm));
-    out.bpm = getBpmMonoAubio(monoPcm, sampleRate);
-    out.audioStart = firstAudioTimeByRms(mono, sampleRate, 0.02, 0.01, -45.0);
-    out.approxOnset = aubioFirstOnsetTime(mono, sampleRate, out.audioStart, 1024, 128, "hfc", 0.25f, -60.0f, 0.08f);
-    out.kickAttack = findKickAttackStart(mono, sampleRate, out.approxOnset, 200.0, 80.0, 2.5, 6.0, 8.0, 180.0);
+BPMDetection::BeatGridEstimate BPMDetection::estimateBeatGridMonoAubio(const std::vector<double>& monoPcm, int sampleRate)
+{
+    if (sampleRate <= 0 || monoPcm.empty()) return BeatGridEstimate{};
+    return GridFromNormalizedMono(NormalizeForAnalysis(ToMonoFloat(monoPcm)), sampleRate);
+}
 
-    // Mirrors current Python default: ANCHOR_MODE="audio_start", SNAP_AFTER_AUDIO_START=False
-    out.t0 = out.audioStart;
-    if (!std::isfinite(out.t0) || out.t0 < 0.0) out.t0 = 0.0;
+BPMDetection::BeatGridEstimate BPMDetection::estimateBeatGridMonoAubio(const audiofile::AudioView& audio, int sampleRate)
+{
+    if (sampleRate <= 0 || audio.empty()) return BeatGridEstimate{};
+    return GridFromNormalizedMono(NormalizeForAnalysis(ToMonoFloat(audio)), sampleRate);
+}
 
-    if (out.bpm > 0.0)
-    {
-        const double beforeDrift = out.bpm;
-        out.bpm = refineBpmByDrift(mono, sampleRate, out.t0, out.bpm, 1.0, 0.01, 7, 18.0, 0.10, 0.90, 0.25);
-        std::cout << "BPM before drift: " << beforeDrift << "  after drift: " << out.bpm << "\n";
-    }
+double BPMDetection::getBpmMonoAubio(const analysis::AnalysisSignal& signal)
+{
+    if (signal.empty()) return 0.0;
+    if (!signal.IsCropped()) return BpmFromNormalizedMono(signal.mono, signal.sampleRate);
+    const std::vector<float> window(signal.CropData(), signal.CropData() + signal.CropSize());
+    return BpmFromNormalizedMono(window, signal.sampleRate);
+}
 
-    return out;
+BPMDetection::BeatGridEstimate BPMDetection::estimateBeatGridMonoAubio(const analysis::AnalysisSignal& signal)
+{
+    if (signal.empty()) return BeatGridEstimate{};
+    // BuildAnalysisSignal has already peak-normalized the whole track like NormalizeForAnalysis.
+    if (!signal.IsCropped()) return GridFromNormalizedMono(signal.mono, signal.sampleRate);
+    const std::vector<float> window(signal.CropData(), signal.CropData() + signal.CropSize());
+    return GridFromNormalizedMono(signal.mono, signal.sampleRate, &window);
 }
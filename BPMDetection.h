@@ -2,6 +2,9 @@
 
 #include <vector>
 
+#include "AnalysisFrontEnd.h"
+#include "AudioView.h"
+
 namespace BPMDetection
 {
     struct BeatGridEstimate
@@ -16,4 +19,14 @@ namespace BPMDetection
     double getBpmMonoAubio(const std::vector<double>& monoPcm, int sampleRate);
     BeatGridEstimate estimateBeatGridMonoAubio(const std::vector<double>& monoPcm, int sampleRate);
 
+    // Same analysis on a view; multi-channel views are downmixed while converting to float.
+    double getBpmMonoAubio(const audiofile::AudioView& audio, int sampleRate);
+    BeatGridEstimate estimateBeatGridMonoAubio(const audiofile::AudioView& audio, int sampleRate);
+
+    // Same analysis on the shared decimated front-end signal. Frame and hop sizes follow its
+    // rate, so timing resolution matches the full-rate path. The tempo estimate only looks at
+    // the signal's crop window; t0, the onset/kick anchors and the drift refinement use all of it.
+    double getBpmMonoAubio(const analysis::AnalysisSignal& signal);
+    BeatGridEstimate estimateBeatGridMonoAubio(const analysis::AnalysisSignal& signal);
+
 };
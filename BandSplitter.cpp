@@ -0,0 +1,77 @@
+// BandSplitter.cpp
+#include "BandSplitter.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+
+namespace dsp
+{
+    int crossover_taps(double sampleRate, double lowestCrossoverHz)
+    {
+        const double transitionHz = (std::min)((std::max)(lowestCrossoverHz * 0.5, 20.0), 500.0);
+        return fir_taps_for_transition(sampleRate, transitionHz);
+    }
+
+    std::vector<std::vector<double>> design_crossover_bank(double sampleRate, std::vector<double> crossoversHz, int taps)
+    {
+        std::sort(crossoversHz.begin(), crossoversHz.end());
+        if ((taps & 1) == 0) ++taps;
+
+        std::vector<std::vector<double>> bank;
+        bank.reserve(crossoversHz.size() + 1);
+
+        std::vector<double> below((std::size_t)taps, 0.0); // low-pass at the previous crossover (none yet)
+        for (double fc : crossoversHz)
+        {
+            std::vector<double> lp = design_lowpass_fir(sampleRate, fc, taps);
+            std::vector<double> band(lp);
+            for (std::size_t i = 0; i < band.size(); ++i) band[i] -= below[i];
+            bank.push_back(std::move(band));
+            below = std::move(lp);
+        }
+
+        std::vector<double> top(below);
+        for (double& v : top) v = -v;
+        top[top.size() / 2] += 1.0;
+        bank.push_back(std::move(top));
+        return bank;
+    }
+
+    template <typename Real>
+    void BasicBandSplitter<Real>::init(double sampleRate, const std::vector<double>& crossoversHz, int taps)
+    {
+        if (crossoversHz.empty() || sampleRate <= 0.0)
+        {
+            m_conv.destroy();
+            return;
+        }
+        if (taps <= 0)
+            taps = crossover_taps(sampleRate, *std::min_element(crossoversHz.begin(), crossoversHz.end()));
+        std::vector<std::vector<double>> bank = design_crossover_bank(sampleRate, crossoversHz, taps);
+        bank.pop_back(); // the top band is derived in split()
+        m_conv.init_bank(bank);
+    }
+
+    template <typename Real>
+    void BasicBandSplitter<Real>::split(const audiofile::AudioView& channel, float* const* dst)
+    {
+        WAVEOUT_PROFILE_SCOPE("dsp.bandSplit");
+        if (!valid() || channel.empty()) return;
+
+        const std::size_t lower = (std::size_t)m_conv.kernel_count();
+        fir_filter_bank_aligned(m_conv, channel.data(), channel.Frames(), channel.Stride(), dst);
+
+        float* top = dst[lower];
+        for (std::size_t i = 0; i < channel.Frames(); ++i)
+        {
+            float rest = (float)channel.At(i, 0);
+            for (std::size_t b = 0; b < lower; ++b)
+                rest -= dst[b][i];
+            top[i] = rest;
+        }
+    }
+
+    template class BasicBandSplitter<double>;
+    template class BasicBandSplitter<float>;
+}
@@ -0,0 +1,55 @@
+// BandSplitter.h
+#pragma once
+
+#include <vector>
+
+#include "AudioView.h"
+#include "DSP.h"
+#include "FirConvolver.h"
+
+namespace dsp
+{
+    // -------------------------
+    // Complementary FIR crossover
+    // -------------------------
+
+    // Tap count the analysis filters use for a split at lowestCrossoverHz: the transition band is
+    // half the crossover, kept between 20 and 500 Hz (about 2400 taps for 200 Hz at 44.1 kHz).
+    int crossover_taps(double sampleRate, double lowestCrossoverHz);
+
+    // crossoversHz.size() + 1 linear-phase kernels of the same odd length: band 0 is the low-pass at
+    // the first crossover, band k the difference of the low-passes at crossovers k and k-1, and the
+    // last band the unit impulse minus the top low-pass. They sum to a centered unit impulse.
+    std::vector<std::vector<double>> design_crossover_bank(double sampleRate, std::vector<double> crossoversHz, int taps);
+
+    // Splits one channel into bands from a single pass over the input: every block is transformed
+    // forward once and inverted once per band below the top one (OverlapSaveConvolver::init_bank).
+    // The kernels are complementary, so the top band is simply the input minus the others; the
+    // bands therefore add back up to the input to within float rounding, and a two-way split costs
+    // one forward and one inverse FFT per block instead of two of each.
+    //
+    // BandSplitter runs its FFTs in fft_real; BasicBandSplitter<double/float> picks explicitly.
+    template <typename Real>
+    class BasicBandSplitter
+    {
+    public:
+        BasicBandSplitter() = default;
+        BasicBandSplitter(double sampleRate, const std::vector<double>& crossoversHz, int taps = 0) { init(sampleRate, crossoversHz, taps); }
+
+        // taps 0 uses crossover_taps() for the lowest crossover.
+        void init(double sampleRate, const std::vector<double>& crossoversHz, int taps = 0);
+
+        bool valid() const { return m_conv.valid(); }
+        int bands() const { return valid() ? m_conv.kernel_count() + 1 : 0; }
+        int taps() const { return m_conv.taps(); }
+
+        // channel must be a single-channel view; dst[b] receives channel.Frames() samples of band b,
+        // aligned with the input.
+        void split(const audiofile::AudioView& channel, float* const* dst);
+
+    private:
+        BasicOverlapSaveConvolver<Real> m_conv;
+    };
+
+    using BandSplitter = BasicBandSplitter<fft_real>;
+}
@@ -0,0 +1,288 @@
+#include "BatchRunner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <system_error>
+
+#include <fftw3.h>
+
+#include "AnalysisPipeline.h"
+#include "DecodeCache.h"
+#include "Profiler.h"
+#include "WorkerPool.h"
+
+namespace analysis
+{
+    namespace
+    {
+        void SetError(std::string* errorMessage, const std::string& message)
+        {
+            if (errorMessage)
+                *errorMessage = message;
+        }
+
+        std::string ToLower(std::string s)
+        {
+            std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return s;
+        }
+
+        bool IsAudioFile(const std::filesystem::path& p)
+        {
+            const std::string ext = ToLower(p.extension().string());
+            return ext == ".wav" || ext == ".mp3" || ext == ".flac";
+        }
+
+        bool HasWildcard(const std::string& s)
+        {
+            return s.find_first_of("*?") != std::string::npos;
+        }
+
+        // Case-insensitive * / ? match, like the Windows shell.
+        bool WildcardMatch(const std::string& pattern, const std::string& text)
+        {
+            std::size_t p = 0, t = 0, star = std::string::npos, mark = 0;
+            while (t < text.size())
+            {
+                if (p < pattern.size() && (pattern[p] == '?' || std::tolower(static_cast<unsigned char>(pattern[p])) == std::tolower(static_cast<unsigned char>(text[t]))))
+                {
+                    ++p;
+                    ++t;
+                }
+                else if (p < pattern.size() && pattern[p] == '*')
+                {
+                    star = p++;
+                    mark = t;
+                }
+                else if (star != std::string::npos)
+                {
+                    p = star + 1;
+                    t = ++mark;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            while (p < pattern.size() && pattern[p] == '*')
+                ++p;
+            return p == pattern.size();
+        }
+
+        void ExpandOne(const std::string& input, std::vector<std::filesystem::path>& out, std::vector<std::string>& missing)
+        {
+            namespace fs = std::filesystem;
+            std::error_code ec;
+            const fs::path p(input);
+
+            if (HasWildcard(input))
+            {
+                // Only the filename component may contain wildcards ("Music/*.flac").
+                const fs::path dir = p.has_parent_path() ? p.parent_path() : fs::path(".");
+                const std::string pattern = p.filename().string();
+                bool any = false;
+                for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+                {
+                    if (it->is_regular_file(ec) && WildcardMatch(pattern, it->path().filename().string()))
+                    {
+                        out.push_back(it->path());
+                        any = true;
+                    }
+                }
+                if (!any)
+                    missing.push_back(input);
+                return;
+            }
+
+            if (fs::is_directory(p, ec))
+            {
+                for (fs::recursive_directory_iterator it(p, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec))
+                {
+                    if (it->is_regular_file(ec) && IsAudioFile(it->path()))
+                        out.push_back(it->path());
+                }
+                return;
+            }
+
+            if (fs::is_regular_file(p, ec))
+                out.push_back(p);
+            else
+                missing.push_back(input);
+        }
+
+        // Two inputs with the same stem in different folders must not overwrite each other's results.
+        std::vector<std::filesystem::path> AssignOutputFiles(const std::vector<std::filesystem::path>& inputs, const std::filesystem::path& outputDir)
+        {
+            std::map<std::string, int> used;
+            std::vector<std::filesystem::path> out;
+            out.reserve(inputs.size());
+            for (const auto& in : inputs)
+            {
+                const std::string stem = in.stem().string();
+                const int n = used[ToLower(stem)]++;
+                const std::string name = n == 0 ? stem : stem + " (" + std::to_string(n + 1) + ")";
+                out.push_back(outputDir / (name + ".analysis.json"));
+            }
+            return out;
+        }
+    }
+
+    std::vector<std::filesystem::path> ExpandInputs(const BatchOptions& options, std::string* errorMessage)
+    {
+        std::vector<std::string> inputs = options.inputs;
+        if (!options.listFile.empty())
+        {
+            std::ifstream list(options.listFile);
+            if (!list)
+            {
+                SetError(errorMessage, "Failed to open input list: " + options.listFile);
+                return {};
+            }
+            std::string line;
+            while (std::getline(list, line))
+            {
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                if (!line.empty() && line[0] != '#')
+                    inputs.push_back(line);
+            }
+        }
+
+        std::vector<std::filesystem::path> files;
+        std::vector<std::string> missing;
+        for (const auto& input : inputs)
+            ExpandOne(input, files, missing);
+
+        // Keep the order stable run to run and drop inputs named twice (e.g. a file plus its folder).
+        std::set<std::filesystem::path> seen;
+        std::vector<std::filesystem::path> unique;
+        std::sort(files.begin(), files.end());
+        for (const auto& f : files)
+        {
+            std::error_code ec;
+            std::filesystem::path key = std::filesystem::weakly_canonical(f, ec);
+            if (ec) key = f;
+            if (seen.insert(key).second)
+                unique.push_back(f);
+        }
+
+        if (!missing.empty())
+        {
+            std::string msg = "No audio files matched:";
+            for (const auto& m : missing)
+                msg += " \"" + m + "\"";
+            SetError(errorMessage, msg);
+        }
+        return unique;
+    }
+
+    int RunBatch(const BatchOptions& options)
+    {
+        std::string expandError;
+        const std::vector<std::filesystem::path> inputs = ExpandInputs(options, &expandError);
+        if (!expandError.empty())
+            std::cerr << expandError << std::endl;
+        if (inputs.empty())
+        {
+            std::cerr << "Batch mode: nothing to analyze." << std::endl;
+            return 2;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(options.outputDir, ec);
+        if (ec)
+        {
+            std::cerr << "Failed to create output directory " << options.outputDir.string() << ": " << ec.message() << std::endl;
+            return 2;
+        }
+
+        // Several tracks plan FFTs at the same time (filters, MidiMaker, libkeyfinder).
+        fftw_make_planner_thread_safe();
+        fftwf_make_planner_thread_safe();
+
+        const std::vector<std::filesystem::path> outFiles = AssignOutputFiles(inputs, options.outputDir);
+        audiofile::DecodeCache decodeCache;
+        threading::WorkerPool pool(options.threads);
+        const std::size_t jobs = (std::min)(options.jobs ? options.jobs : pool.ThreadCount(), inputs.size());
+
+        std::cout << "Batch mode: " << inputs.size() << " track(s), " << jobs << " job(s) on " << pool.ThreadCount()
+            << " thread(s), results in " << options.outputDir.string() << std::endl;
+
+        const auto started = std::chrono::steady_clock::now();
+        std::mutex printMutex;
+        std::size_t done = 0;
+        std::size_t failed = 0;
+        std::atomic<std::size_t> next{ 0 };
+
+        // Tracks are handed out to `jobs` long-running runners rather than submitted one job each,
+        // so the number of concurrent tracks does not have to equal the pool size.
+        auto analyzeOne = [&](std::size_t i) {
+            TrackOptions trackOptions;
+            trackOptions.runStemSeparation = options.runStemSeparation;
+            trackOptions.filterCutoffHz = options.filterCutoffHz;
+            trackOptions.frontEnd = options.frontEnd;
+            trackOptions.pitchBinsPerOctave = options.pitchBinsPerOctave;
+            trackOptions.midiFile = outFiles[i];
+            trackOptions.midiFile.replace_extension(); // "<name>.analysis.json" -> "<name>.mid"
+            trackOptions.midiFile.replace_extension(".mid");
+            trackOptions.decodeCache = &decodeCache;
+            trackOptions.pool = &pool; // stages of one track fan out onto the same pool
+
+            TrackResult result = AnalyzeTrack(inputs[i].string(), trackOptions);
+            std::string writeError;
+            const bool written = WriteTrackResult(result, outFiles[i], &writeError);
+
+            std::lock_guard<std::mutex> lock(printMutex);
+            ++done;
+            std::cout << "[" << done << "/" << inputs.size() << "] " << (result.ok ? "OK   " : "FAIL ")
+                << inputs[i].string();
+            if (result.ok)
+                std::cout << "  key=" << result.keyName << " bpm=" << result.grid.bpm << " (" << result.elapsedSeconds << "s)";
+            else
+                std::cout << "  " << result.error;
+            std::cout << std::endl;
+            if (!written)
+                std::cerr << writeError << std::endl;
+            if (!result.ok || !written)
+                ++failed;
+        };
+
+        std::vector<std::future<void>> runners;
+        runners.reserve(jobs);
+        for (std::size_t r = 0; r < jobs; ++r)
+        {
+            runners.push_back(pool.Submit([&]() {
+                for (std::size_t i = next++; i < inputs.size(); i = next++)
+                {
+                    try
+                    {
+                        analyzeOne(i);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::lock_guard<std::mutex> lock(printMutex);
+                        std::cerr << "Batch job failed: " << e.what() << std::endl;
+                        ++failed;
+                    }
+                }
+            }));
+        }
+        for (auto& r : runners)
+            r.get();
+
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        std::cout << "Batch finished: " << (inputs.size() - failed) << " ok, " << failed << " failed, "
+            << elapsed << "s total" << std::endl;
+        WAVEOUT_PROFILE_DUMP(options.outputDir / "profile.trace.json");
+        return failed == 0 ? 0 : 1;
+    }
+}
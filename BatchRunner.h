@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "AnalysisFrontEnd.h"
+
+namespace analysis
+{
+    struct BatchOptions
+    {
+        std::vector<std::string> inputs;  // files, directories (searched recursively) or filename globs (* and ?)
+        std::string listFile;             // optional text file with one input per line
+        std::size_t jobs = 0;             // concurrent tracks; 0 = one per worker thread
+        std::size_t threads = 0;          // worker threads shared by tracks and their stages; 0 picks hardware_concurrency
+        std::filesystem::path outputDir = "analysis_results";
+        bool runStemSeparation = false;
+        int filterCutoffHz = 200;
+        FrontEndOptions frontEnd;         // rate / window key and BPM detection run on
+        int pitchBinsPerOctave = 36;      // constant-Q note detection; 0 = linear FFT peaks
+    };
+
+    // Resolves inputs/listFile to a sorted, de-duplicated list of audio files (.wav/.mp3/.flac).
+    std::vector<std::filesystem::path> ExpandInputs(const BatchOptions& options, std::string* errorMessage = nullptr);
+
+    // Headless entry point: analyzes every input on a worker pool and writes
+    // <outputDir>/<name>.analysis.json and <outputDir>/<name>.mid per track. Returns a process exit code
+    // (0 = every track succeeded, 1 = at least one failed, 2 = nothing to do).
+    //
+    // At most `jobs` tracks are in flight; pool threads they leave idle pick up the stages and
+    // channel tasks those tracks fan out, so the process never runs more than `threads` workers.
+    int RunBatch(const BatchOptions& options);
+}
@@ -0,0 +1,164 @@
+// BatchedStft.cpp
+#include "BatchedStft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "DSP.h"
+#include "FftwPlanCache.h"
+#include "Profiler.h"
+#include "TaskGraph.h"
+#include "WorkerPool.h"
+
+namespace dsp
+{
+    static constexpr double STFT_PI = 3.141592653589793238462643383279502884;
+
+    template <typename Real>
+    void run_batched_r2c(int N, int frames, int batch, unsigned flags, threading::WorkerPool* pool,
+        const std::function<void(int, Real*)>& fill,
+        const std::function<void(int, const typename FftwApi<Real>::Complex*)>& consume)
+    {
+        using Api = FftwApi<Real>;
+        using Complex = typename Api::Complex;
+        if (N < 1 || frames <= 0) return;
+
+        const int bins = N / 2 + 1;
+        batch = (std::max)(1, (std::min)(batch, frames));
+        const int batches = (frames + batch - 1) / batch;
+        const int slices = pool ? (std::min)(batches, (int)pool->ThreadCount() + 1) : 1;
+
+        auto runSlice = [&, N, bins, batch](int firstBatch, int endBatch) {
+            FftwBuffer<Real> in((std::size_t)batch * (std::size_t)N);
+            FftwBuffer<Complex> spec((std::size_t)batch * (std::size_t)bins);
+            WAVEOUT_PROFILE_BYTES(sizeof(Real) * in.size() + sizeof(Complex) * spec.size());
+            typename Api::Plan plan = FftwPlanCache::instance().plan_many<Real>(FftKind::R2C, N, batch, in.data(), spec.data(), flags);
+            if (!plan)
+                throw std::runtime_error("FFTW could not plan a " + std::to_string(N) + "-point r2c batch");
+
+            for (int b = firstBatch; b < endBatch; ++b)
+            {
+                const int first = b * batch;
+                const int howmany = (std::min)(batch, frames - first);
+                for (int f = 0; f < howmany; ++f)
+                    fill(first + f, in.data() + (std::size_t)f * (std::size_t)N);
+                if (howmany < batch)
+                    std::memset(in.data() + (std::size_t)howmany * (std::size_t)N, 0, sizeof(Real) * (std::size_t)(batch - howmany) * (std::size_t)N);
+
+                Api::execute_r2c(plan, in.data(), spec.data());
+
+                for (int f = 0; f < howmany; ++f)
+                    consume(first + f, spec.data() + (std::size_t)f * (std::size_t)bins);
+            }
+        };
+
+        if (slices <= 1)
+        {
+            runSlice(0, batches);
+            return;
+        }
+
+        // TaskGraph runs work on the calling thread too and never waits on queued jobs, so this is
+        // safe from inside a pipeline stage that is itself running on the pool.
+        threading::TaskGraph graph;
+        for (int s = 0; s < slices; ++s)
+        {
+            const int b0 = (int)((long long)batches * s / slices);
+            const int b1 = (int)((long long)batches * (s + 1) / slices);
+            graph.Add("r2c slice " + std::to_string(s), [&runSlice, b0, b1]() { runSlice(b0, b1); });
+        }
+        graph.RunOrThrow(pool);
+    }
+
+    template void run_batched_r2c<float>(int, int, int, unsigned, threading::WorkerPool*,
+        const std::function<void(int, float*)>&, const std::function<void(int, const FftwApi<float>::Complex*)>&);
+    template void run_batched_r2c<double>(int, int, int, unsigned, threading::WorkerPool*,
+        const std::function<void(int, double*)>&, const std::function<void(int, const FftwApi<double>::Complex*)>&);
+
+    void BatchedStft::init(const StftConfig& config)
+    {
+        m_config = config;
+        if (m_config.frameSize < 2) m_config.frameSize = 2;
+        if (m_config.hop <= 0) m_config.hop = m_config.frameSize;
+        if (m_config.batchFrames < 1) m_config.batchFrames = 1;
+
+        const int N = m_config.frameSize;
+        m_window.assign((std::size_t)N, 1.0);
+        for (int i = 0; i < N; ++i)
+        {
+            const double t = 2.0 * STFT_PI * (double)i / (double)(N - 1);
+            switch (m_config.window)
+            {
+            case StftWindow::Rectangular: break;
+            case StftWindow::Hann: m_window[(std::size_t)i] = hann(i, N); break;
+            case StftWindow::Hamming: m_window[(std::size_t)i] = 0.54 - 0.46 * std::cos(t); break;
+            case StftWindow::Blackman: m_window[(std::size_t)i] = 0.42 - 0.5 * std::cos(t) + 0.08 * std::cos(2.0 * t); break;
+            }
+        }
+    }
+
+    int BatchedStft::frame_count(std::size_t samples) const
+    {
+        const std::size_t N = (std::size_t)m_config.frameSize;
+        if (m_window.empty() || samples < N) return 0;
+        return (int)((samples - N) / (std::size_t)m_config.hop + 1);
+    }
+
+    void BatchedStft::analyze(const audiofile::AudioView& audio, StftMagnitudes& out,
+        threading::WorkerPool* pool, int maxFrames) const
+    {
+        run([&audio](std::size_t i) { return (double)audio.Mono(i); }, audio.Frames(), out, pool, maxFrames);
+    }
+
+    void BatchedStft::analyze(const double* samples, std::size_t count, StftMagnitudes& out,
+        threading::WorkerPool* pool, int maxFrames) const
+    {
+        if (!samples) count = 0;
+        run([samples](std::size_t i) { return samples[i]; }, count, out, pool, maxFrames);
+    }
+
+    template <typename Source>
+    void BatchedStft::run(const Source& source, std::size_t count, StftMagnitudes& out,
+        threading::WorkerPool* pool, int maxFrames) const
+    {
+        WAVEOUT_PROFILE_SCOPE("dsp.batchedStft");
+
+        int frames = frame_count(count);
+        if (maxFrames >= 0) frames = (std::min)(frames, maxFrames);
+
+        const int bins = this->bins();
+        const std::size_t cells = (std::size_t)frames * (std::size_t)bins;
+        if (out.values.size() != cells) out.values.resize(cells);
+        out.frames = frames;
+        out.bins = bins;
+        if (frames == 0) return;
+
+        if (m_config.singlePrecision)
+            transform<float>(source, frames, out, pool);
+        else
+            transform<double>(source, frames, out, pool);
+    }
+
+    template <typename Real, typename Source>
+    void BatchedStft::transform(const Source& source, int frames, StftMagnitudes& out, threading::WorkerPool* pool) const
+    {
+        using Complex = typename FftwApi<Real>::Complex;
+        const int N = m_config.frameSize;
+        const int bins = this->bins();
+        run_batched_r2c<Real>(N, frames, m_config.batchFrames,
+            m_config.measurePlan ? FftwPlanCache::DEFAULT_FLAGS : FFTW_ESTIMATE, pool,
+            [&](int f, Real* dst) {
+                const std::size_t start = (std::size_t)f * (std::size_t)m_config.hop;
+                for (int j = 0; j < N; ++j)
+                    dst[j] = (Real)(source(start + (std::size_t)j) * m_window[(std::size_t)j]);
+            },
+            [&](int f, const Complex* X) {
+                double* row = out.frame(f);
+                for (int k = 0; k < bins; ++k)
+                    row[k] = std::sqrt((double)X[k][0] * X[k][0] + (double)X[k][1] * X[k][1]);
+            });
+    }
+}
@@ -0,0 +1,104 @@
+// BatchedStft.h
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "AudioView.h"
+#include "DSP.h"
+
+namespace threading
+{
+    class WorkerPool;
+}
+
+namespace dsp
+{
+    enum class StftWindow
+    {
+        Rectangular,
+        Hann,
+        Hamming,
+        Blackman,
+    };
+
+    struct StftConfig
+    {
+        int frameSize = 1024;
+        int hop = 0;                            // 0 = frameSize (back-to-back chunks)
+        StftWindow window = StftWindow::Hann;
+        int batchFrames = 8;                    // frames per fftw_plan_many_dft_r2c call
+        bool measurePlan = true;                // false: FFTW_ESTIMATE (sizes that change per track)
+        bool singlePrecision = std::is_same<fft_real, float>::value; // fftwf plans and float frames
+    };
+
+    // Frame-major magnitude matrix: row f holds the bins() magnitudes of frame f.
+    struct StftMagnitudes
+    {
+        int frames = 0;
+        int bins = 0;                  // frameSize / 2 + 1
+        std::vector<double> values;    // frames * bins
+
+        const double* frame(int f) const { return values.data() + (std::size_t)f * (std::size_t)bins; }
+        double* frame(int f) { return values.data() + (std::size_t)f * (std::size_t)bins; }
+    };
+
+    // -------------------------
+    // Batched r2c driver
+    // -------------------------
+    // The frame loop shared by BatchedStft and ConstantQ. `frames` frames of N real samples are
+    // transformed `batch` at a time through one cached many-transform plan; a short last batch is
+    // zero-filled and run through the same plan. With a pool, contiguous runs of batches go to
+    // different threads, each with its own buffers and plan. fill(f, dst) writes frame f's N
+    // samples and consume(f, X) reads its N / 2 + 1 bins; both run concurrently for different
+    // frames. A plan FFTW cannot create, or a failed slice, throws std::runtime_error.
+    template <typename Real>
+    void run_batched_r2c(int N, int frames, int batch, unsigned flags, threading::WorkerPool* pool,
+        const std::function<void(int, Real*)>& fill,
+        const std::function<void(int, const typename FftwApi<Real>::Complex*)>& consume);
+
+    // -------------------------
+    // Batched real-input STFT
+    // -------------------------
+    // Windowed frames are packed back to back and transformed batchFrames at a time with one
+    // cached many-transform r2c plan, so there is no per-frame planning, no complex transform of
+    // real data and no per-frame allocation. A short last batch is zero-filled and run through the
+    // same plan rather than planning a second size. With a pool, contiguous runs of batches go to
+    // different threads (each with its own buffers); every thread writes straight into its rows
+    // of the output matrix.
+    //
+    // Only frames that fit completely are analyzed (no padding at the end). Magnitudes are always
+    // returned as double; singlePrecision only changes what the frames are transformed in. A plan
+    // that FFTW cannot create, or a failed slice, throws std::runtime_error.
+    class BatchedStft
+    {
+    public:
+        BatchedStft() = default;
+        explicit BatchedStft(const StftConfig& config) { init(config); }
+
+        void init(const StftConfig& config);
+
+        const StftConfig& config() const { return m_config; }
+        int bins() const { return m_config.frameSize / 2 + 1; }
+        int frame_count(std::size_t samples) const;
+
+        // Mono downmix of the view (AudioView::Mono). maxFrames < 0 analyzes every frame that fits.
+        // out is resized only when its shape changes, so a reused matrix is not reallocated.
+        void analyze(const audiofile::AudioView& audio, StftMagnitudes& out,
+            threading::WorkerPool* pool = nullptr, int maxFrames = -1) const;
+        void analyze(const double* samples, std::size_t count, StftMagnitudes& out,
+            threading::WorkerPool* pool = nullptr, int maxFrames = -1) const;
+
+    private:
+        template <typename Source>
+        void run(const Source& source, std::size_t count, StftMagnitudes& out,
+            threading::WorkerPool* pool, int maxFrames) const;
+        template <typename Real, typename Source>
+        void transform(const Source& source, int frames, StftMagnitudes& out, threading::WorkerPool* pool) const;
+
+        StftConfig m_config;
+        std::vector<double> m_window;
+    };
+}
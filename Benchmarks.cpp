@@ -0,0 +1,409 @@
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "AudioFileLoader.h"
+#include "AudioView.h"
+#include "BandSplitter.h"
+#include "BatchedStft.h"
+#include "ChunkStore.h"
+#include "ConstantQ.h"
+#include "FirFilter.h"
+#include "MidiFile.h"
+#include "MidiMaker.h"
+
+namespace bench
+{
+    namespace
+    {
+        constexpr int kSampleRate = 44100;
+
+        double SecondsOf(const std::function<void()>& fn, int repeats)
+        {
+            double best = 1e30;
+            for (int r = 0; r < repeats; ++r)
+            {
+                const auto t0 = std::chrono::steady_clock::now();
+                fn();
+                best = (std::min)(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+            }
+            return best;
+        }
+
+        // Band-limited-ish stereo test signal: a random walk per channel, so it has music-like
+        // low-frequency weight rather than white noise.
+        std::vector<short> MakeStereoSignal(std::size_t frames)
+        {
+            std::vector<short> pcm(frames * 2);
+            std::uint32_t seed = 0x2545F491u;
+            double walk[2] = { 0.0, 0.0 };
+            for (std::size_t i = 0; i < pcm.size(); ++i)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                double& w = walk[i & 1];
+                w = 0.995 * w + ((double)(seed >> 16) - 32768.0) * 0.05;
+                pcm[i] = (short)(std::max)(-32768.0, (std::min)(32767.0, w));
+            }
+            return pcm;
+        }
+
+        // Same Hamming-windowed sinc as filter::yLcalculate_high_pass_filter_coefficients.
+        std::vector<long double> MakeCoefficients(double cutoff, int taps)
+        {
+            const long double pi = 3.1415926535897932384626433832795L;
+            const long double wc = 2.0L * pi * cutoff / kSampleRate;
+            std::vector<long double> c((std::size_t)taps);
+            for (int i = 0; i < taps; ++i)
+            {
+                if (i == taps / 2)
+                    c[(std::size_t)i] = wc / pi;
+                else
+                    c[(std::size_t)i] = std::sin(wc * (i - taps / 2)) / (pi * (i - taps / 2)) * (0.54 - 0.46 * std::cos(2.0L * pi * i / (taps - 1)));
+            }
+            return c;
+        }
+
+        // The loop filter::yLapply_high_pass_filter ran before: one channel at a time, long double
+        // coefficients, double accumulator.
+        void ReferenceFir(const audiofile::AudioView& audio, const std::vector<long double>& c, double* out)
+        {
+            const std::size_t taps = c.size();
+            const std::size_t frames = audio.Frames();
+            const int channels = audio.Channels();
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                for (std::size_t i = 0; i < frames; ++i)
+                {
+                    double acc = 0;
+                    if (i + taps <= frames)
+                    {
+                        for (std::size_t j = 0; j < taps; ++j)
+                            acc += c[j] * audio.At(i + j, ch);
+                    }
+                    out[i * channels + ch] = acc;
+                }
+            }
+        }
+
+        double MaxAbsDiff(const std::vector<double>& a, const std::vector<double>& b)
+        {
+            double m = 0.0;
+            for (std::size_t i = 0; i < a.size(); ++i)
+                m = (std::max)(m, std::fabs(a[i] - b[i]));
+            return m;
+        }
+
+        double MaxAbs(const std::vector<double>& a)
+        {
+            double m = 0.0;
+            for (double v : a)
+                m = (std::max)(m, std::fabs(v));
+            return m;
+        }
+
+        // Quarter-beat chunks with `peaks` voices each; every voice keeps its note with probability
+        // 0.7 per chunk, so runs are short and the file is dense.
+        analysis::ChunkStore MakeStemChunks(std::size_t chunks, int peaks, int lowMidi, int highMidi, float chunkSeconds, std::uint32_t seed)
+        {
+            analysis::ChunkStore store(peaks);
+            store.Reserve(chunks);
+            std::vector<double> freqs((std::size_t)peaks);
+            std::vector<double> mags((std::size_t)peaks);
+            std::vector<int> notes((std::size_t)peaks, lowMidi);
+            for (std::size_t c = 0; c < chunks; ++c)
+            {
+                for (int p = 0; p < peaks; ++p)
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    if (c == 0 || (seed >> 8) % 10 >= 7)
+                        notes[(std::size_t)p] = lowMidi + (int)((seed >> 16) % (std::uint32_t)(highMidi - lowMidi + 1));
+                    freqs[(std::size_t)p] = dsp::midi_to_hz(notes[(std::size_t)p]);
+                    mags[(std::size_t)p] = 100.0 + (double)((seed >> 4) % 20000u);
+                }
+                store.Append((int)c, chunkSeconds * c, chunkSeconds * (c + 1), freqs.data(), mags.data());
+            }
+            store.ClampToKey(analysis::KeyClampTable::ForKey(Key::C_MAJOR));
+            return store;
+        }
+
+        // The straightforward writer: note runs tracked per chunk, one MidiFile::addEvent (with its own
+        // byte vector) per note-on/note-off as runs end, then MidiFile::sortTracks(). Same runs, ticks
+        // and velocities as MidiMaker::buildMidi with a grid starting on a beat.
+        void ReferenceMidi(const std::vector<MidiStem>& stems, double bpm, smf::MidiFile& out)
+        {
+            const int tpq = 480;
+            auto ticks = [&](double seconds) { return (int)std::lround(seconds * bpm / 60.0 * tpq); };
+            auto velocity = [](double magnitude) {
+                const double db = 20.0 * std::log10((std::max)(magnitude, 1e-9) / 32768.0);
+                return (int)(std::max)(1L, (std::min)(127L, std::lround(127.0 * (1.0 + db / 60.0))));
+            };
+
+            out.clear();
+            out.setTicksPerQuarterNote(tpq);
+            out.addTracks((int)stems.size());
+            out.addTrackName(0, 0, "Tempo");
+            out.addTimeSignature(0, 0, 4, 4);
+            out.addTempo(0, 0, bpm);
+            for (std::size_t s = 0; s < stems.size(); ++s)
+            {
+                const analysis::ChunkStore& chunks = *stems[s].chunks;
+                const int track = (int)s + 1;
+                const int channel = stems[s].channel;
+                out.addTrackName(track, 0, stems[s].name);
+                if (stems[s].program >= 0)
+                    out.addPatchChange(track, 0, channel, stems[s].program);
+
+                std::vector<int> start(128, -1);
+                std::vector<double> peak(128, 0.0);
+                auto close = [&](int key, std::size_t last) {
+                    const int on = ticks(chunks.StartSeconds((std::size_t)start[key]));
+                    const int off = (std::max)(on + 1, ticks(chunks.EndSeconds(last)));
+                    std::vector<smf::uchar> noteOn = { (smf::uchar)(0x90 | channel), (smf::uchar)key, (smf::uchar)velocity(peak[key]) };
+                    std::vector<smf::uchar> noteOff = { (smf::uchar)(0x80 | channel), (smf::uchar)key, 0 };
+                    out.addEvent(track, on, noteOn);
+                    out.addEvent(track, off, noteOff);
+                    start[key] = -1;
+                    peak[key] = 0.0;
+                };
+                for (std::size_t c = 0; c < chunks.Size(); ++c)
+                {
+                    std::vector<bool> present(128, false);
+                    for (int p = 0; p < chunks.PeaksPerChunk(); ++p)
+                    {
+                        const int key = chunks.MidiNotes(c)[p];
+                        if (key <= 0 || key > 127) continue;
+                        present[(std::size_t)key] = true;
+                        if (start[key] < 0) start[key] = (int)c;
+                        peak[key] = (std::max)(peak[key], chunks.Magnitudes(c)[p]);
+                    }
+                    for (int key = 0; key < 128; ++key)
+                        if (start[key] >= 0 && !present[(std::size_t)key]) close(key, c - 1);
+                }
+                for (int key = 0; key < 128; ++key)
+                    if (start[key] >= 0) close(key, chunks.Size() - 1);
+            }
+            out.sortTracks();
+        }
+
+        // (tick, bytes) of every event per track, in a canonical order: MidiFile::sortTracks() does
+        // not fix the order of simultaneous note-ons, so files are compared as event sets.
+        std::vector<std::vector<std::tuple<int, std::vector<smf::uchar>>>> EventSets(smf::MidiFile& file)
+        {
+            std::vector<std::vector<std::tuple<int, std::vector<smf::uchar>>>> sets((std::size_t)file.getTrackCount());
+            for (int t = 0; t < file.getTrackCount(); ++t)
+            {
+                for (int e = 0; e < file[t].size(); ++e)
+                    sets[(std::size_t)t].emplace_back(file[t][e].tick, std::vector<smf::uchar>(file[t][e].begin(), file[t][e].end()));
+                std::sort(sets[(std::size_t)t].begin(), sets[(std::size_t)t].end());
+            }
+            return sets;
+        }
+    }
+
+    int RunFir()
+    {
+        const double seconds = 10.0;
+        const std::size_t frames = (std::size_t)(seconds * kSampleRate);
+        const std::vector<short> pcm = MakeStereoSignal(frames);
+        const audiofile::AudioView audio = audiofile::AudioView::Interleaved(pcm, 2);
+
+        std::printf("FIR benchmark: %.0f s stereo at %d Hz, direct-form ISA: %s, measured FFT crossover: %d taps\n\n",
+            seconds, kSampleRate, dsp::fir_direct_isa(), dsp::fir_fft_crossover_taps());
+        std::printf("  %6s %14s %12s %12s %12s %10s %14s\n", "taps", "reference ms", "direct ms", "fft ms", "auto ms", "speedup", "max rel err");
+
+        for (int taps : { 16, 64, 256, 1000 })
+        {
+            const std::vector<long double> coefficients = MakeCoefficients(1000.0, taps);
+            const std::vector<double> h(coefficients.begin(), coefficients.end());
+
+            std::vector<double> reference(frames * 2);
+            std::vector<double> direct(frames * 2);
+            std::vector<double> fft(frames * 2);
+            std::vector<double> automatic(frames * 2);
+
+            const double tRef = SecondsOf([&]() { ReferenceFir(audio, coefficients, reference.data()); }, 1);
+            const double tDirect = SecondsOf([&]() { dsp::fir_correlate_valid(audio, h, direct.data(), dsp::FirMethod::Direct); }, 3);
+            const double tFft = SecondsOf([&]() { dsp::fir_correlate_valid(audio, h, fft.data(), dsp::FirMethod::Fft); }, 3);
+            const double tAuto = SecondsOf([&]() { dsp::fir_correlate_valid(audio, h, automatic.data(), dsp::FirMethod::Auto); }, 3);
+
+            const double peak = (std::max)(MaxAbs(reference), 1e-12);
+            const double err = (std::max)(MaxAbsDiff(reference, direct), MaxAbsDiff(reference, fft)) / peak;
+            std::printf("  %6d %14.1f %12.1f %12.1f %12.1f %9.1fx %14.2e\n",
+                taps, tRef * 1e3, tDirect * 1e3, tFft * 1e3, tAuto * 1e3, tRef / (std::max)(tAuto, 1e-9), err);
+        }
+        return 0;
+    }
+
+    namespace
+    {
+        struct PrecisionInput
+        {
+            std::string name;
+            std::vector<short> pcm; // interleaved stereo
+            int sampleRate = kSampleRate;
+        };
+
+        // Every decodable file in Test/, cut to its first minute so one long track does not
+        // dominate the run.
+        std::vector<PrecisionInput> LoadPrecisionCorpus()
+        {
+            std::vector<PrecisionInput> inputs;
+            std::error_code ec;
+            for (const auto& entry : std::filesystem::directory_iterator("Test", ec))
+            {
+                if (!entry.is_regular_file(ec)) continue;
+                audiofile::DecodedPcm16 decoded;
+                if (!audiofile::AudioFileLoader::LoadPcm16(entry.path().string(), decoded) || decoded.channels <= 0) continue;
+
+                PrecisionInput in;
+                in.name = entry.path().filename().string();
+                in.sampleRate = decoded.sampleRate;
+                in.pcm = audiofile::AudioFileLoader::ToInterleavedStereo(decoded.samples, decoded.channels);
+                in.pcm.resize((std::min)(in.pcm.size(), (std::size_t)decoded.sampleRate * 60 * 2));
+                if (!in.pcm.empty()) inputs.push_back(std::move(in));
+            }
+            std::sort(inputs.begin(), inputs.end(), [](const PrecisionInput& a, const PrecisionInput& b) { return a.name < b.name; });
+            if (inputs.empty())
+                inputs.push_back({ "synthetic (no Test/ corpus)", MakeStereoSignal((std::size_t)(30.0 * kSampleRate)), kSampleRate });
+            return inputs;
+        }
+
+        int ArgMax(const double* row, int n)
+        {
+            return (int)(std::max_element(row, row + n) - row);
+        }
+    }
+
+    int RunPrecision()
+    {
+        const std::vector<PrecisionInput> inputs = LoadPrecisionCorpus();
+
+        dsp::StftConfig config;
+        config.frameSize = 4096;
+        config.hop = 1024;
+        config.window = dsp::StftWindow::Hann;
+        config.singlePrecision = false;
+        const dsp::BatchedStft stftDouble(config);
+        config.singlePrecision = true;
+        const dsp::BatchedStft stftFloat(config);
+
+        std::printf("Precision benchmark: float (fftwf) against double, STFT %d/%d Hann, 200 Hz band split of the left channel\n\n",
+            config.frameSize, config.hop);
+        std::printf("  %-44s %8s %12s %10s %10s %12s %10s\n",
+            "input", "seconds", "stft rel err", "peak bins", "stft x", "split LSB", "split x");
+
+        double worstStft = 0.0;
+        double worstSplit = 0.0;
+        for (const PrecisionInput& input : inputs)
+        {
+            const std::size_t frames = input.pcm.size() / 2;
+            const audiofile::AudioView audio = audiofile::AudioView::Interleaved(input.pcm, 2);
+
+            dsp::StftMagnitudes magDouble;
+            dsp::StftMagnitudes magFloat;
+            const double tStftDouble = SecondsOf([&]() { stftDouble.analyze(audio, magDouble); }, 3);
+            const double tStftFloat = SecondsOf([&]() { stftFloat.analyze(audio, magFloat); }, 3);
+
+            // Error relative to the loudest bin of the track: quiet bins are dominated by the 16-bit
+            // source's own noise floor, which neither precision changes.
+            double peak = 1e-12;
+            for (double v : magDouble.values) peak = (std::max)(peak, v);
+            double stftErr = 0.0;
+            for (std::size_t i = 0; i < magDouble.values.size(); ++i)
+                stftErr = (std::max)(stftErr, std::fabs(magDouble.values[i] - magFloat.values[i]) / peak);
+            int sameBins = 0;
+            for (int f = 0; f < magDouble.frames; ++f)
+                sameBins += ArgMax(magDouble.frame(f), magDouble.bins) == ArgMax(magFloat.frame(f), magFloat.bins);
+            const double binAgreement = magDouble.frames ? 100.0 * sameBins / magDouble.frames : 100.0;
+
+            dsp::BasicBandSplitter<double> splitDouble((double)input.sampleRate, { 200.0 });
+            dsp::BasicBandSplitter<float> splitFloat((double)input.sampleRate, { 200.0 });
+            std::vector<float> bandsDouble(frames * 2);
+            std::vector<float> bandsFloat(frames * 2);
+            float* dstDouble[2] = { bandsDouble.data(), bandsDouble.data() + frames };
+            float* dstFloat[2] = { bandsFloat.data(), bandsFloat.data() + frames };
+            const audiofile::AudioView left = audio.Channel(0);
+            const double tSplitDouble = SecondsOf([&]() { splitDouble.split(left, dstDouble); }, 3);
+            const double tSplitFloat = SecondsOf([&]() { splitFloat.split(left, dstFloat); }, 3);
+            double splitErr = 0.0;
+            for (std::size_t i = 0; i < bandsDouble.size(); ++i)
+                splitErr = (std::max)(splitErr, (double)std::fabs(bandsDouble[i] - bandsFloat[i]));
+
+            worstStft = (std::max)(worstStft, stftErr);
+            worstSplit = (std::max)(worstSplit, splitErr);
+            std::printf("  %-44.44s %8.1f %12.2e %9.1f%% %9.2fx %12.4f %9.2fx\n",
+                input.name.c_str(), (double)frames / input.sampleRate, stftErr, binAgreement,
+                tStftDouble / (std::max)(tStftFloat, 1e-9), splitErr, tSplitDouble / (std::max)(tSplitFloat, 1e-9));
+        }
+
+        // A split difference under half an LSB cannot change a 16-bit output sample by more than one step.
+        std::printf("\n  worst STFT error %.2e of peak, worst band-split difference %.4f LSB\n", worstStft, worstSplit);
+        return 0;
+    }
+
+    int RunMidi()
+    {
+        const double bpm = 128.0;
+        const float chunkSeconds = (float)(15.0 / bpm); // quarter beat, like MidiMaker's band chunks
+        const double minutes = 6.0;
+        const std::size_t chunks = (std::size_t)(minutes * 60.0 / chunkSeconds);
+
+        const analysis::ChunkStore bass = MakeStemChunks(chunks, 3, 28, 52, chunkSeconds, 1u);
+        const analysis::ChunkStore chords = MakeStemChunks(chunks, 6, 48, 84, chunkSeconds, 2u);
+        const analysis::ChunkStore lead = MakeStemChunks(chunks, 6, 60, 96, chunkSeconds, 3u);
+        const analysis::ChunkStore vocals = MakeStemChunks(chunks, 2, 55, 79, chunkSeconds, 4u);
+        const std::vector<MidiStem> stems = {
+            { "Bass", &bass, 0, 33 },
+            { "Chords", &chords, 1, 0 },
+            { "Lead", &lead, 2, 80 },
+            { "Vocals", &vocals, 3, 52 },
+        };
+        BPMDetection::BeatGridEstimate grid;
+        grid.bpm = bpm;
+
+        smf::MidiFile bulk;
+        smf::MidiFile reference;
+        const double tBulk = SecondsOf([&]() { MidiMaker::buildMidi(stems, grid, bulk); }, 5);
+        const double tReference = SecondsOf([&]() { ReferenceMidi(stems, bpm, reference); }, 5);
+
+        std::size_t events = 0;
+        for (int t = 0; t < bulk.getTrackCount(); ++t)
+            events += (std::size_t)bulk[t].size();
+        std::string bytes;
+        const double tWrite = SecondsOf([&]() {
+            std::ostringstream os;
+            bulk.write(os);
+            bytes = os.str();
+        }, 5);
+        const bool identical = EventSets(bulk) == EventSets(reference);
+
+        std::printf("MIDI benchmark: %.0f min at %.0f BPM, %zu quarter-beat chunks, 4 stems (3/6/6/2 voices)\n\n",
+            minutes, bpm, chunks);
+        std::printf("  %10s %14s %12s %10s %10s %12s %10s\n", "events", "addEvent ms", "bulk ms", "speedup", "write ms", "file bytes", "same");
+        std::printf("  %10zu %14.2f %12.2f %9.2fx %10.2f %12zu %10s\n", events, tReference * 1e3, tBulk * 1e3,
+            tReference / (std::max)(tBulk, 1e-9), tWrite * 1e3, bytes.size(), identical ? "yes" : "NO");
+        return identical ? 0 : 1;
+    }
+
+    int Run(const std::string& name)
+    {
+        if (name == "fir")
+            return RunFir();
+        if (name == "precision")
+            return RunPrecision();
+        if (name == "midi")
+            return RunMidi();
+        std::fprintf(stderr, "Unknown benchmark '%s' (available: fir, precision, midi)\n", name.c_str());
+        return 2;
+    }
+}
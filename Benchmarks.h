@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+namespace bench
+{
+    // Micro-benchmarks behind `waveOut --bench=<name>`. Each prints a small table to stdout and
+    // returns a process exit code (2 for an unknown name).
+    int Run(const std::string& name);
+
+    // Direct-form SIMD FIR and FFT convolution against the original scalar long double loop
+    // (filter::yLapply_high_pass_filter before it moved to dsp::fir_correlate_valid).
+    int RunFir();
+
+    // Single- against double-precision FFT stages (BatchedStft, BasicBandSplitter) on the Test/
+    // corpus, or on a synthetic signal when Test/ is not next to the working directory.
+    int RunPrecision();
+
+    // MidiMaker::buildMidi against one MidiFile::addEvent per note event plus sortTracks(), on a
+    // dense synthetic four-stem transcription.
+    int RunMidi();
+}
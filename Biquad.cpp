@@ -0,0 +1,263 @@
+// Biquad.cpp
+#include "Biquad.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WAVEOUT_BIQUAD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define WAVEOUT_BIQUAD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace dsp
+{
+    static constexpr double BIQUAD_PI = 3.141592653589793238462643383279502884;
+
+    BiquadCoeffs BiquadCoeffs::normalized(double b0, double b1, double b2, double a0, double a1, double a2)
+    {
+        const double invA0 = (std::fabs(a0) > 1e-18) ? (1.0 / a0) : 1.0;
+        BiquadCoeffs q;
+        q.b0 = b0 * invA0;
+        q.b1 = b1 * invA0;
+        q.b2 = b2 * invA0;
+        q.a1 = a1 * invA0;
+        q.a2 = a2 * invA0;
+        return q;
+    }
+
+    // -------------------------
+    // Designs
+    // -------------------------
+    namespace
+    {
+        double clamp_fc(double sampleRate, double fc)
+        {
+            return (std::min)((std::max)(fc, 10.0), sampleRate * 0.45);
+        }
+
+        double omega(double sampleRate, double fc)
+        {
+            return 2.0 * BIQUAD_PI * clamp_fc(sampleRate, fc) / sampleRate;
+        }
+
+        // Shelf alpha from the cookbook's shelf-slope parameter.
+        double shelf_alpha(double A, double sw0, double slope)
+        {
+            slope = (std::max)(slope, 0.1);
+            return sw0 * 0.5 * std::sqrt((A + 1.0 / A) * (1.0 / slope - 1.0) + 2.0);
+        }
+    }
+
+    BiquadCoeffs biquad_lowpass(double sampleRate, double fc, double q)
+    {
+        const double w0 = omega(sampleRate, fc);
+        const double cw0 = std::cos(w0);
+        const double alpha = std::sin(w0) / (2.0 * (std::max)(q, 0.1));
+        return BiquadCoeffs::normalized(
+            (1.0 - cw0) * 0.5,
+            1.0 - cw0,
+            (1.0 - cw0) * 0.5,
+            1.0 + alpha,
+            -2.0 * cw0,
+            1.0 - alpha);
+    }
+
+    BiquadCoeffs biquad_highpass(double sampleRate, double fc, double q)
+    {
+        const double w0 = omega(sampleRate, fc);
+        const double cw0 = std::cos(w0);
+        const double alpha = std::sin(w0) / (2.0 * (std::max)(q, 0.1));
+        return BiquadCoeffs::normalized(
+            (1.0 + cw0) * 0.5,
+            -(1.0 + cw0),
+            (1.0 + cw0) * 0.5,
+            1.0 + alpha,
+            -2.0 * cw0,
+            1.0 - alpha);
+    }
+
+    BiquadCoeffs biquad_peaking(double sampleRate, double fc, double q, double gainDb)
+    {
+        const double A = std::pow(10.0, gainDb / 40.0);
+        const double w0 = omega(sampleRate, fc);
+        const double cw0 = std::cos(w0);
+        const double alpha = std::sin(w0) / (2.0 * (std::max)(q, 0.1));
+        return BiquadCoeffs::normalized(
+            1.0 + alpha * A,
+            -2.0 * cw0,
+            1.0 - alpha * A,
+            1.0 + alpha / A,
+            -2.0 * cw0,
+            1.0 - alpha / A);
+    }
+
+    BiquadCoeffs biquad_low_shelf(double sampleRate, double fc, double slope, double gainDb)
+    {
+        const double A = std::pow(10.0, gainDb / 40.0);
+        const double w0 = omega(sampleRate, fc);
+        const double cw0 = std::cos(w0);
+        const double t = 2.0 * std::sqrt(A) * shelf_alpha(A, std::sin(w0), slope);
+        return BiquadCoeffs::normalized(
+            A * ((A + 1.0) - (A - 1.0) * cw0 + t),
+            2.0 * A * ((A - 1.0) - (A + 1.0) * cw0),
+            A * ((A + 1.0) - (A - 1.0) * cw0 - t),
+            (A + 1.0) + (A - 1.0) * cw0 + t,
+            -2.0 * ((A - 1.0) + (A + 1.0) * cw0),
+            (A + 1.0) + (A - 1.0) * cw0 - t);
+    }
+
+    BiquadCoeffs biquad_high_shelf(double sampleRate, double fc, double slope, double gainDb)
+    {
+        const double A = std::pow(10.0, gainDb / 40.0);
+        const double w0 = omega(sampleRate, fc);
+        const double cw0 = std::cos(w0);
+        const double t = 2.0 * std::sqrt(A) * shelf_alpha(A, std::sin(w0), slope);
+        return BiquadCoeffs::normalized(
+            A * ((A + 1.0) + (A - 1.0) * cw0 + t),
+            -2.0 * A * ((A - 1.0) + (A + 1.0) * cw0),
+            A * ((A + 1.0) + (A - 1.0) * cw0 - t),
+            (A + 1.0) - (A - 1.0) * cw0 + t,
+            2.0 * ((A - 1.0) - (A + 1.0) * cw0),
+            (A + 1.0) - (A - 1.0) * cw0 - t);
+    }
+
+    std::array<BiquadCoeffs, 3> design_playback_eq(double sampleRate, double lowDb, double midDb, double highDb)
+    {
+        return {
+            biquad_low_shelf(sampleRate, 220.0, 0.9, lowDb),
+            biquad_peaking(sampleRate, 1000.0, 0.75, midDb),
+            biquad_high_shelf(sampleRate, 4200.0, 0.9, highDb),
+        };
+    }
+
+    // -------------------------
+    // BiquadBank
+    // -------------------------
+    void BiquadBank::init(int lanes, int sections)
+    {
+        m_lanes = (std::max)(lanes, 0);
+        m_sections = (std::max)(sections, 0);
+        m_coeffs.assign((std::size_t)m_sections * 5 * (std::size_t)m_lanes, 0.0);
+        m_state.assign((std::size_t)m_sections * 2 * (std::size_t)m_lanes, 0.0);
+        m_block.assign(BLOCK_FRAMES * (std::size_t)m_lanes, 0.0);
+        for (int s = 0; s < m_sections; ++s)
+            set_section(s, BiquadCoeffs{});
+    }
+
+    void BiquadBank::set_section(int section, const BiquadCoeffs& c)
+    {
+        for (int l = 0; l < m_lanes; ++l)
+            set_section(section, l, c);
+    }
+
+    void BiquadBank::set_section(int section, int lane, const BiquadCoeffs& c)
+    {
+        if (section < 0 || section >= m_sections || lane < 0 || lane >= m_lanes) return;
+        coeff(section, 0)[lane] = c.b0;
+        coeff(section, 1)[lane] = c.b1;
+        coeff(section, 2)[lane] = c.b2;
+        coeff(section, 3)[lane] = c.a1;
+        coeff(section, 4)[lane] = c.a2;
+    }
+
+    void BiquadBank::reset()
+    {
+        std::fill(m_state.begin(), m_state.end(), 0.0);
+    }
+
+    void BiquadBank::process(const double* in, double* out, std::size_t frames)
+    {
+        if (!in || !out || m_lanes == 0) return;
+        if (in != out)
+            std::copy(in, in + frames * (std::size_t)m_lanes, out);
+        run(out, frames);
+    }
+
+    void BiquadBank::process(const float* in, float* out, std::size_t frames)
+    {
+        if (!in || !out || m_lanes == 0) return;
+        const std::size_t lanes = (std::size_t)m_lanes;
+        for (std::size_t pos = 0; pos < frames; pos += BLOCK_FRAMES)
+        {
+            const std::size_t n = (std::min)(BLOCK_FRAMES, frames - pos);
+            std::copy(in + pos * lanes, in + (pos + n) * lanes, m_block.data());
+            run(m_block.data(), n);
+            for (std::size_t i = 0; i < n * lanes; ++i)
+                out[pos * lanes + i] = (float)m_block[i];
+        }
+    }
+
+    // Section by section over the whole block, so each lane pair keeps its five coefficients and
+    // two state values in registers for the entire inner loop.
+    void BiquadBank::run(double* x, std::size_t frames)
+    {
+        const std::size_t lanes = (std::size_t)m_lanes;
+        for (int s = 0; s < m_sections; ++s)
+        {
+            const double* b0 = coeff(s, 0);
+            const double* b1 = coeff(s, 1);
+            const double* b2 = coeff(s, 2);
+            const double* a1 = coeff(s, 3);
+            const double* a2 = coeff(s, 4);
+            double* z1 = state(s, 0);
+            double* z2 = state(s, 1);
+
+            std::size_t l = 0;
+#if defined(WAVEOUT_BIQUAD_SSE2)
+            for (; l + 2 <= lanes; l += 2)
+            {
+                const __m128d vb0 = _mm_loadu_pd(b0 + l), vb1 = _mm_loadu_pd(b1 + l), vb2 = _mm_loadu_pd(b2 + l);
+                const __m128d va1 = _mm_loadu_pd(a1 + l), va2 = _mm_loadu_pd(a2 + l);
+                __m128d s1 = _mm_loadu_pd(z1 + l), s2 = _mm_loadu_pd(z2 + l);
+                double* p = x + l;
+                for (std::size_t f = 0; f < frames; ++f, p += lanes)
+                {
+                    const __m128d in = _mm_loadu_pd(p);
+                    const __m128d y = _mm_add_pd(_mm_mul_pd(vb0, in), s1);
+                    s1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(vb1, in), _mm_mul_pd(va1, y)), s2);
+                    s2 = _mm_sub_pd(_mm_mul_pd(vb2, in), _mm_mul_pd(va2, y));
+                    _mm_storeu_pd(p, y);
+                }
+                _mm_storeu_pd(z1 + l, s1);
+                _mm_storeu_pd(z2 + l, s2);
+            }
+#elif defined(WAVEOUT_BIQUAD_NEON)
+            for (; l + 2 <= lanes; l += 2)
+            {
+                const float64x2_t vb0 = vld1q_f64(b0 + l), vb1 = vld1q_f64(b1 + l), vb2 = vld1q_f64(b2 + l);
+                const float64x2_t va1 = vld1q_f64(a1 + l), va2 = vld1q_f64(a2 + l);
+                float64x2_t s1 = vld1q_f64(z1 + l), s2 = vld1q_f64(z2 + l);
+                double* p = x + l;
+                for (std::size_t f = 0; f < frames; ++f, p += lanes)
+                {
+                    const float64x2_t in = vld1q_f64(p);
+                    const float64x2_t y = vaddq_f64(vmulq_f64(vb0, in), s1);
+                    s1 = vaddq_f64(vsubq_f64(vmulq_f64(vb1, in), vmulq_f64(va1, y)), s2);
+                    s2 = vsubq_f64(vmulq_f64(vb2, in), vmulq_f64(va2, y));
+                    vst1q_f64(p, y);
+                }
+                vst1q_f64(z1 + l, s1);
+                vst1q_f64(z2 + l, s2);
+            }
+#endif
+            for (; l < lanes; ++l)
+            {
+                double s1 = z1[l], s2 = z2[l];
+                double* p = x + l;
+                for (std::size_t f = 0; f < frames; ++f, p += lanes)
+                {
+                    const double in = *p;
+                    const double y = b0[l] * in + s1;
+                    s1 = b1[l] * in - a1[l] * y + s2;
+                    s2 = b2[l] * in - a2[l] * y;
+                    *p = y;
+                }
+                z1[l] = s1;
+                z2[l] = s2;
+            }
+        }
+    }
+}
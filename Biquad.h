@@ -0,0 +1,85 @@
+// Biquad.h
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace dsp
+{
+    // -------------------------
+    // Second-order section coefficients (a0 normalized to 1)
+    // -------------------------
+    //   y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+    struct BiquadCoeffs
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0;
+        double a1 = 0.0, a2 = 0.0;
+
+        // Divides everything by a0 (left unscaled if a0 is ~0).
+        static BiquadCoeffs normalized(double b0, double b1, double b2, double a0, double a1, double a2);
+    };
+
+    // -------------------------
+    // RBJ audio-EQ-cookbook designs
+    // -------------------------
+    // fc is clamped to [10 Hz, 0.45 * sampleRate]; q and slope to at least 0.1.
+    constexpr double BUTTERWORTH_Q = 0.70710678118654752440;
+
+    BiquadCoeffs biquad_lowpass(double sampleRate, double fc, double q = BUTTERWORTH_Q);
+    BiquadCoeffs biquad_highpass(double sampleRate, double fc, double q = BUTTERWORTH_Q);
+    BiquadCoeffs biquad_peaking(double sampleRate, double fc, double q, double gainDb);
+    BiquadCoeffs biquad_low_shelf(double sampleRate, double fc, double slope, double gainDb);
+    BiquadCoeffs biquad_high_shelf(double sampleRate, double fc, double slope, double gainDb);
+
+    // The playback EQ shared by the audio engine, the MCI fallback and the spectrogram:
+    // low shelf at 220 Hz, broad bell at 1 kHz, high shelf at 4.2 kHz.
+    std::array<BiquadCoeffs, 3> design_playback_eq(double sampleRate, double lowDb, double midDb, double highDb);
+
+    // -------------------------
+    // Cascaded biquads with per-lane state
+    // -------------------------
+    // Runs `sections` second-order sections in series over `lanes` interleaved signals (stereo
+    // channels, or one lane per band when a signal is split several ways), transposed direct form
+    // II, double-precision state. Lanes go through the cascade two at a time in SIMD registers
+    // (SSE2 / NEON), so a stereo block costs about as much as a mono one.
+    //
+    // init() is the only call that allocates. process(), set_section() and reset() are safe to use
+    // from the real-time audio callback; set_section() keeps the state, so coefficients can be
+    // swapped between blocks without a click.
+    class BiquadBank
+    {
+    public:
+        BiquadBank() = default;
+        BiquadBank(int lanes, int sections) { init(lanes, sections); }
+
+        // Every section starts as a pass-through and every state at zero.
+        void init(int lanes, int sections);
+
+        int lanes() const { return m_lanes; }
+        int sections() const { return m_sections; }
+
+        // One section for every lane, or for a single lane.
+        void set_section(int section, const BiquadCoeffs& c);
+        void set_section(int section, int lane, const BiquadCoeffs& c);
+
+        void reset();
+
+        // frames interleaved frames of lanes() samples each; in == out filters in place.
+        void process(const double* in, double* out, std::size_t frames);
+        void process(const float* in, float* out, std::size_t frames);
+
+    private:
+        static constexpr std::size_t BLOCK_FRAMES = 256; // float I/O is widened this many frames at a time
+
+        void run(double* x, std::size_t frames);
+        double* coeff(int section, int k) { return m_coeffs.data() + ((std::size_t)section * 5 + (std::size_t)k) * (std::size_t)m_lanes; }
+        double* state(int section, int k) { return m_state.data() + ((std::size_t)section * 2 + (std::size_t)k) * (std::size_t)m_lanes; }
+
+        int m_lanes = 0;
+        int m_sections = 0;
+        std::vector<double> m_coeffs;  // [section][b0 b1 b2 a1 a2][lane]
+        std::vector<double> m_state;   // [section][z1 z2][lane]
+        std::vector<double> m_block;   // BLOCK_FRAMES * lanes
+    };
+}
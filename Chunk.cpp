@@ -1,102 +1,28 @@
 #include "Chunk.h"
-#include "GLOBAL.h"
+#include "ChunkStore.h"
 #include <vector>
 #include <iostream>
-void Chunk::clampKeys()//HI
+#include <cmath>
+void Chunk::clampKeys(Key musicalKey)//HI
 {
-	//std::cout << "Clamp Keys Called"<<std::endl;
-		Key k = GLOBAL::MUSICAL_KEY;
-		std::vector<Keys> ref;
-		switch (k)
-		{
-		case Key::A_MAJOR:
-			ref = GLOBAL::aMajor;
-			break;
-		case Key::A_SHARP_MAJOR:
-			ref = GLOBAL::aSharpMajor;
-			break;
-		case Key::B_MAJOR:
-			ref = GLOBAL::bMajor;
-			break;
-		case Key::C_MAJOR:
-			ref = GLOBAL::cMajor;
-			break;
-		case Key::C_SHARP_MAJOR:
-			ref = GLOBAL::cSharpMajor;
-			break;
-		case Key::D_MAJOR:
-			ref = GLOBAL::dMajor;
-			break;
-		case Key::D_SHARP_MAJOR:
-			ref = GLOBAL::dSharpMajor;
-			break;
-		case Key::E_MAJOR:
-			ref = GLOBAL::eMajor;
-			break;
-		case Key::F_MAJOR:
-			ref = GLOBAL::fMajor;
-			break;
-		case Key::F_SHARP_MAJOR:
-			ref = GLOBAL::fSharpMajor;
-			break;
-		case Key::G_MAJOR:
-			ref = GLOBAL::gMajor;
-			break;
-		case Key::G_SHARP_MAJOR:
-			ref = GLOBAL::gSharpMajor;
-			break;
-		case Key::NO_KEY:
-			break;
-		}
-		
-		if (this->singular == false)
-		{
-			//std::cout << "Non Singular!"<<std::endl;
-			std::vector<Keys> keyvec;
-
-			for (double f : this->freqVec)
-			{
-				double k = 0;
-				//std::cout << "THIS IS K: " << k <<" THIS IS SIZE OF freqVec: "<<freqVec.size()<<std::endl;
+	const analysis::KeyClampTable& table = analysis::KeyClampTable::ForKey(musicalKey);
+	if (table.empty())
+	{
+		return; //no key detected, nothing to clamp to
+	}
 
-
-				double minDiff = std::abs(f - static_cast<double>(ref[0]));
-				Keys closestKey = ref[0];
-				//std::cout << "THIS IS SIZE OF REF: " << ref.size() << std::endl;
-				for (size_t i = 1;i < ref.size();i++)
-				{
-					//std::cout << "THIS IS I: " << i << std::endl;
-					double diff = std::abs(f - static_cast<double>(ref[i]));
-					if (diff < minDiff)
-					{
-						minDiff = diff;
-						closestKey = ref[i];
-					}
-				}
-				keyvec.push_back(closestKey);
-				k++;
-			}
-			this->keyVec = keyvec;
-			
-		}
-		else
+	if (this->singular == false)
+	{
+		this->keyVec.resize(this->freqVec.size());
+		for (size_t i = 0; i < this->freqVec.size(); i++)
 		{
-			//std::cout << "Singular!" << std::endl;
-			double minDiff = std::abs(this->freq - static_cast<double>(ref[0]));
-			Keys closestKey = ref[0];
-
-			for (size_t i = 1;i < ref.size();i++)
-			{
-				double diff = std::abs(this->freq - static_cast<double>(ref[i]));
-				if (diff < minDiff)
-				{
-					minDiff = diff;
-					closestKey = ref[i];
-				}
-			}
-			this->key = closestKey;
+			this->keyVec[i] = table.Clamp(this->freqVec[i]);
 		}
-		//std::cout << "FINI" << std::endl;
+	}
+	else
+	{
+		this->key = table.Clamp(this->freq);
+	}
 }
 void Chunk::setTime()
 {
@@ -112,8 +38,9 @@ void Chunk::setTime()
 	this->endSecond = static_cast<int>(endTime) % 60;
 	this->endMili = static_cast<int>(std::round((endTime - static_cast<float>(endSecond) - static_cast<float>(endMinute) * 60) * 1000));
 }
-void Chunk::Init()
+void Chunk::Init(const analysis::AnalysisContext& ctx)
 {
-	this->clampKeys();
+	this->songLength = ctx.songLength;
+	this->clampKeys(ctx.musicalKey);
 	this->setTime();
 }
\ No newline at end of file
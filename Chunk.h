@@ -4,6 +4,7 @@
 #include "Keys.h"
 #include <string>
 #include "GLOBAL.h"
+#include "AnalysisContext.h"
 class Chunk
 {
 public:
@@ -37,12 +38,12 @@ public:
 		return freq;
 	}
 
-	std::vector<double> getFreqV()
+	const std::vector<double>& getFreqV() const
 	{
 		return freqVec;
 	}
 
-	std::vector<Keys> getKeyVec()
+	const std::vector<Keys>& getKeyVec() const
 	{
 		return keyVec;
 	}
@@ -57,7 +58,7 @@ public:
 		return iter;
 	}
 
-	std::vector<double> getIntenVec()
+	const std::vector<double>& getIntenVec() const
 	{
 		return intenVec;
 	}
@@ -89,9 +90,9 @@ public:
 
 	float getEnd()
 	{
-		if (chunkDuration * (iter + 1) > GLOBAL::SONG_LENGTH)
+		if (songLength > 0 && chunkDuration * (iter + 1) > songLength)
 		{
-			return GLOBAL::SONG_LENGTH;
+			return songLength;
 		}
 		else 
 		{
@@ -100,7 +101,7 @@ public:
 	}
 
 	
-	void Init();
+	void Init(const analysis::AnalysisContext& ctx);
 
 
 private:
@@ -125,8 +126,9 @@ private:
 	int endMili;
 
 	float chunkDuration;
+	float songLength = 0; //set by Init(); 0 means unknown and getEnd() is not clamped
 
 	void setTime();
-	void clampKeys(); //This function takes the raw frequency data and then clamps it to the closest appropriate note as determined by the musical Key the song is in
+	void clampKeys(Key musicalKey); //This function takes the raw frequency data and then clamps it to the closest appropriate note as determined by the musical Key the song is in
 };
 
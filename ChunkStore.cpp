@@ -0,0 +1,133 @@
+#include "ChunkStore.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "GLOBAL.h"
+#include "Profiler.h"
+
+namespace analysis
+{
+    KeyClampTable::KeyClampTable(Key key) : m_key(key)
+    {
+        const std::vector<Keys>* scale = GLOBAL::getScale(key);
+        if (scale == nullptr || scale->empty())
+            return;
+
+        // Scales are not sorted and repeat notes, so keep each distinct note with the position it
+        // is first listed at; that position decides ties exactly like the linear scan did.
+        struct Entry
+        {
+            int hz;
+            std::size_t firstPos;
+        };
+        std::vector<Entry> entries;
+        entries.reserve(scale->size());
+        for (std::size_t i = 0; i < scale->size(); ++i)
+            entries.push_back({ static_cast<int>((*scale)[i]), i });
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.hz < b.hz; });
+        entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.hz == b.hz; }), entries.end());
+
+        m_hz.reserve(entries.size());
+        m_notes.reserve(entries.size());
+        m_midi.reserve(entries.size());
+        m_tieUp.assign(entries.size(), 0);
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            const Keys note = static_cast<Keys>(entries[i].hz);
+            m_hz.push_back(static_cast<double>(entries[i].hz));
+            m_notes.push_back(note);
+            m_midi.push_back(ToMidiNote(note));
+            if (entries[i].firstPos == 0)
+                m_nanSlot = i;
+            if (i + 1 < entries.size())
+                m_tieUp[i] = entries[i + 1].firstPos < entries[i].firstPos ? 1 : 0;
+        }
+
+        m_below.assign(static_cast<std::size_t>(entries.back().hz) + 1, 0);
+        std::size_t j = 0;
+        for (std::size_t hz = 0; hz < m_below.size(); ++hz)
+        {
+            while (j + 1 < m_hz.size() && m_hz[j + 1] <= static_cast<double>(hz))
+                ++j;
+            m_below[hz] = static_cast<std::uint16_t>(j);
+        }
+    }
+
+    const KeyClampTable& KeyClampTable::ForKey(Key key)
+    {
+        static const std::array<KeyClampTable, 13> tables = []() {
+            std::array<KeyClampTable, 13> t;
+            for (int k = 0; k < 13; ++k)
+                t[k] = KeyClampTable(static_cast<Key>(k));
+            return t;
+        }();
+        const int k = static_cast<int>(key);
+        return tables[(k >= 0 && k < 13) ? k : 0];
+    }
+
+    std::uint8_t KeyClampTable::ToMidiNote(Keys note)
+    {
+        // Keys values are rounded Hz; rounding the semitone distance from A4 recovers the note.
+        const double hz = static_cast<double>(note);
+        if (hz <= 0.0)
+            return 0;
+        const long midi = std::lround(69.0 + 12.0 * std::log2(hz / 440.0));
+        return static_cast<std::uint8_t>((std::min)(127L, (std::max)(0L, midi)));
+    }
+
+    void ChunkStore::Reserve(std::size_t chunks)
+    {
+        const std::size_t peaks = chunks * static_cast<std::size_t>(m_peaks);
+        m_index.reserve(chunks);
+        m_start.reserve(chunks);
+        m_end.reserve(chunks);
+        m_frequencies.reserve(peaks);
+        m_magnitudes.reserve(peaks);
+        m_notes.reserve(peaks);
+        m_midi.reserve(peaks);
+    }
+
+    void ChunkStore::Clear()
+    {
+        m_index.clear();
+        m_start.clear();
+        m_end.clear();
+        m_frequencies.clear();
+        m_magnitudes.clear();
+        m_notes.clear();
+        m_midi.clear();
+        m_clamped = false;
+    }
+
+    std::size_t ChunkStore::Append(int index, float startSeconds, float endSeconds, const double* frequencies, const double* magnitudes)
+    {
+        const std::size_t peaks = static_cast<std::size_t>(m_peaks);
+        m_index.push_back(index);
+        m_start.push_back(startSeconds);
+        m_end.push_back(endSeconds);
+        m_frequencies.insert(m_frequencies.end(), frequencies, frequencies + peaks);
+        m_magnitudes.insert(m_magnitudes.end(), magnitudes, magnitudes + peaks);
+        m_notes.resize(m_notes.size() + peaks, Keys{});
+        m_midi.resize(m_midi.size() + peaks, 0);
+        return m_index.size() - 1;
+    }
+
+    void ChunkStore::ClampToKey(const KeyClampTable& table)
+    {
+        WAVEOUT_PROFILE_SCOPE("chunks.clampToKey");
+        if (table.empty())
+            return;
+        const std::size_t n = m_frequencies.size();
+        const double* f = m_frequencies.data();
+        Keys* notes = m_notes.data();
+        std::uint8_t* midi = m_midi.data();
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            notes[i] = table.Clamp(f[i]);
+            midi[i] = KeyClampTable::ToMidiNote(notes[i]);
+        }
+        m_clamped = true;
+    }
+}
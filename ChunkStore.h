@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Keys.h"
+
+namespace analysis
+{
+    // Nearest in-key note for a frequency in O(1).
+    //
+    // Gives exactly what a linear scan of GLOBAL::getScale(key) with |f - note| gives, first
+    // listed note winning ties, but as one table read and one compare: the scale is sorted once
+    // and a 1 Hz-resolution table maps floor(f) to the scale notes on either side of it.
+    class KeyClampTable
+    {
+    public:
+        KeyClampTable() = default;
+        explicit KeyClampTable(Key key);
+
+        // Shared, immutable tables for the twelve keys (built once, thread-safe).
+        // Key::NO_KEY gives an empty table.
+        static const KeyClampTable& ForKey(Key key);
+
+        bool empty() const { return m_notes.empty(); }
+        Key GetKey() const { return m_key; }
+
+        // Not for empty tables.
+        Keys Clamp(double hz) const { return m_notes[Slot(hz)]; }
+        std::uint8_t MidiNote(double hz) const { return m_midi[Slot(hz)]; }
+
+        // Standard MIDI note number of a Keys value (C_0 -> 12, A_4 -> 69).
+        static std::uint8_t ToMidiNote(Keys note);
+
+    private:
+        std::size_t Slot(double hz) const
+        {
+            if (!(hz >= m_hz[0]))
+                return (hz < m_hz[0]) ? 0 : m_nanSlot; // NaN matches nothing: the scan keeps the first listed note
+            if (hz >= m_hz.back())
+                return m_hz.size() - 1;
+            const std::size_t lo = m_below[static_cast<std::size_t>(hz)];
+            const double dLo = hz - m_hz[lo];
+            const double dHi = m_hz[lo + 1] - hz;
+            return (dLo < dHi || (dLo == dHi && !m_tieUp[lo])) ? lo : lo + 1;
+        }
+
+        Key m_key = Key::NO_KEY;
+        std::vector<double> m_hz;            // distinct scale notes, ascending
+        std::vector<Keys> m_notes;           // same order
+        std::vector<std::uint8_t> m_midi;    // same order
+        std::vector<std::uint8_t> m_tieUp;   // [i]: on an exact tie between i and i+1, i+1 was listed first
+        std::vector<std::uint16_t> m_below;  // [floor(hz)] -> last note <= hz, up to the top note
+        std::size_t m_nanSlot = 0;
+    };
+
+    // Columnar store for the peaks MidiMaker picks out of every chunk.
+    //
+    // Every chunk has the same number of peaks, so frequencies, magnitudes and clamped notes are
+    // dense [chunk][peak] arrays and the per-chunk times are plain columns. Appending never
+    // allocates once Reserve() has been called, and ClampToKey() is one pass over all peaks of the
+    // song with no allocation.
+    class ChunkStore
+    {
+    public:
+        ChunkStore() = default;
+        explicit ChunkStore(int peaksPerChunk) : m_peaks(peaksPerChunk > 0 ? peaksPerChunk : 0) {}
+
+        void Reserve(std::size_t chunks);
+        void Clear();
+
+        // frequencies / magnitudes hold PeaksPerChunk() values; returns the new chunk's position.
+        // Notes and MIDI notes stay zero until ClampToKey().
+        std::size_t Append(int index, float startSeconds, float endSeconds, const double* frequencies, const double* magnitudes);
+
+        // Fills Notes()/MidiNotes() for every peak. An empty table (no key) leaves them untouched.
+        void ClampToKey(const KeyClampTable& table);
+        bool IsClamped() const { return m_clamped; }
+
+        std::size_t Size() const { return m_index.size(); }
+        bool empty() const { return m_index.empty(); }
+        int PeaksPerChunk() const { return m_peaks; }
+
+        int Index(std::size_t chunk) const { return m_index[chunk]; }
+        float StartSeconds(std::size_t chunk) const { return m_start[chunk]; }
+        float EndSeconds(std::size_t chunk) const { return m_end[chunk]; }
+        const double* Frequencies(std::size_t chunk) const { return m_frequencies.data() + chunk * static_cast<std::size_t>(m_peaks); }
+        const double* Magnitudes(std::size_t chunk) const { return m_magnitudes.data() + chunk * static_cast<std::size_t>(m_peaks); }
+        const Keys* Notes(std::size_t chunk) const { return m_notes.data() + chunk * static_cast<std::size_t>(m_peaks); }
+        const std::uint8_t* MidiNotes(std::size_t chunk) const { return m_midi.data() + chunk * static_cast<std::size_t>(m_peaks); }
+
+        // Whole columns, for passes over the entire song.
+        const std::vector<int>& IndexColumn() const { return m_index; }
+        const std::vector<float>& StartColumn() const { return m_start; }
+        const std::vector<float>& EndColumn() const { return m_end; }
+        const std::vector<double>& FrequencyColumn() const { return m_frequencies; }
+        const std::vector<double>& MagnitudeColumn() const { return m_magnitudes; }
+        const std::vector<Keys>& NoteColumn() const { return m_notes; }
+        const std::vector<std::uint8_t>& MidiColumn() const { return m_midi; }
+
+    private:
+        int m_peaks = 0;
+        bool m_clamped = false;
+        std::vector<int> m_index;
+        std::vector<float> m_start;
+        std::vector<float> m_end;
+        std::vector<double> m_frequencies; // [chunk][peak]
+        std::vector<double> m_magnitudes;  // [chunk][peak]
+        std::vector<Keys> m_notes;         // [chunk][peak]
+        std::vector<std::uint8_t> m_midi;  // [chunk][peak]
+    };
+}
@@ -0,0 +1,213 @@
+// ConstantQ.cpp
+#include "ConstantQ.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "BatchedStft.h"
+#include "FftwPlanCache.h"
+#include "Profiler.h"
+#include "Resampler.h"
+
+namespace dsp
+{
+    static constexpr double CQ_PI = 3.141592653589793238462643383279502884;
+
+    double midi_to_hz(double midi)
+    {
+        return 440.0 * std::pow(2.0, (midi - 69.0) / 12.0);
+    }
+
+    double semitone_q()
+    {
+        return 1.0 / (std::pow(2.0, 1.0 / 12.0) - 1.0);
+    }
+
+    void ConstantQFrames::note_magnitudes(int f, double* out) const
+    {
+        const double* row = frame(f);
+        for (int n = 0; n < notes(); ++n)
+        {
+            const double* b = row + (std::size_t)n * (std::size_t)binsPerSemitone;
+            out[n] = *std::max_element(b, b + binsPerSemitone);
+        }
+    }
+
+    void ConstantQ::init(const ConstantQConfig& config)
+    {
+        WAVEOUT_PROFILE_SCOPE("dsp.constantQ.kernel");
+        m_config = config;
+        if (m_config.sampleRate < 1) m_config.sampleRate = 1;
+        m_config.minMidi = (std::max)(0, (std::min)(127, m_config.minMidi));
+        m_config.maxMidi = (std::max)(m_config.minMidi, (std::min)(127, m_config.maxMidi));
+        const int binsPerSemitone = (std::max)(1, (std::min)(3, (int)std::lround(m_config.binsPerOctave / 12.0)));
+        m_config.binsPerOctave = 12 * binsPerSemitone;
+        if (m_config.hop < 1) m_config.hop = 1;
+        if (m_config.batchFrames < 1) m_config.batchFrames = 1;
+        if (m_config.maxDecimation < 1) m_config.maxDecimation = 1;
+        if (m_config.q <= 0.0) m_config.q = 1.0 / (std::pow(2.0, 1.0 / m_config.binsPerOctave) - 1.0);
+        const double Q = m_config.q;
+
+        const int bins = (m_config.maxMidi - m_config.minMidi + 1) * binsPerSemitone;
+        m_frequencies.resize((std::size_t)bins);
+        for (int b = 0; b < bins; ++b)
+        {
+            const double offset = ((b % binsPerSemitone) - (binsPerSemitone - 1) * 0.5) / binsPerSemitone;
+            m_frequencies[(std::size_t)b] = midi_to_hz(m_config.minMidi + b / binsPerSemitone + offset);
+        }
+
+        // Keep the top bin's passband under 0.4x the analysis rate, i.e. well inside the
+        // decimator's passband.
+        const double top = m_frequencies.back() * (1.0 + 1.0 / Q);
+        m_decimation = 1;
+        while (m_decimation * 2 <= m_config.maxDecimation && top <= 0.4 * m_config.sampleRate / (m_decimation * 2))
+            m_decimation *= 2;
+        const double rate = (double)m_config.sampleRate / m_decimation;
+        m_hop = (std::max)(1, (int)std::lround((double)m_config.hop / m_decimation));
+
+        const int longest = (int)std::ceil(Q * rate / m_frequencies.front());
+        m_fftSize = 16;
+        while (m_fftSize < longest) m_fftSize *= 2;
+        const int N = m_fftSize;
+        const int spectrumBins = N / 2 + 1;
+
+        m_rowStart.assign(1, 0);
+        m_columns.clear();
+        m_kernelRe.clear();
+        m_kernelIm.clear();
+
+        FftwBuffer<fftw_complex> temporal((std::size_t)N);
+        FftwBuffer<fftw_complex> spectral((std::size_t)N);
+        fftw_plan plan = FftwPlanCache::instance().plan<double>(FftKind::C2CForward, N, temporal.data(), spectral.data(), FFTW_ESTIMATE);
+        std::vector<double> window;
+        for (int b = 0; b < bins; ++b)
+        {
+            const double fk = m_frequencies[(std::size_t)b];
+            const int Nk = (std::min)(N, (int)std::ceil(Q * rate / fk));
+            window.resize((std::size_t)Nk);
+            double windowSum = 0.0;
+            for (int n = 0; n < Nk; ++n)
+            {
+                window[(std::size_t)n] = (Nk > 1) ? 0.54 - 0.46 * std::cos(2.0 * CQ_PI * n / (Nk - 1)) : 1.0;
+                windowSum += window[(std::size_t)n];
+            }
+
+            // 2 / sum(w): a real sinusoid of amplitude A on the bin reads A.
+            std::memset(temporal.data(), 0, sizeof(fftw_complex) * (std::size_t)N);
+            const int start = N / 2 - Nk / 2;
+            for (int n = 0; n < Nk; ++n)
+            {
+                const double gain = 2.0 * window[(std::size_t)n] / windowSum;
+                const double phase = 2.0 * CQ_PI * fk * (n - Nk / 2) / rate;
+                temporal[(std::size_t)(start + n)][0] = gain * std::cos(phase);
+                temporal[(std::size_t)(start + n)][1] = gain * std::sin(phase);
+            }
+            if (plan) fftw_execute_dft(plan, temporal.data(), spectral.data());
+
+            // Only the non-negative half: the kernels have (almost) no negative-frequency content,
+            // and the frames come out of an r2c transform.
+            double peak = 0.0;
+            for (int j = 0; j < spectrumBins; ++j)
+                peak = (std::max)(peak, std::hypot(spectral[(std::size_t)j][0], spectral[(std::size_t)j][1]));
+            const double threshold = m_config.sparsity * peak;
+            for (int j = 0; j < spectrumBins; ++j)
+            {
+                const double re = spectral[(std::size_t)j][0];
+                const double im = spectral[(std::size_t)j][1];
+                if (std::hypot(re, im) < threshold || peak == 0.0) continue;
+                m_columns.push_back(j);
+                m_kernelRe.push_back((fft_real)(re / N));
+                m_kernelIm.push_back((fft_real)(-im / N));
+            }
+            m_rowStart.push_back((int)m_columns.size());
+        }
+        WAVEOUT_PROFILE_BYTES(m_columns.size() * (sizeof(int) + 2 * sizeof(fft_real)));
+    }
+
+    int ConstantQ::frame_count(std::size_t samples) const
+    {
+        if (m_fftSize == 0 || samples == 0) return 0;
+        const std::size_t decimated = (samples + (std::size_t)m_decimation - 1) / (std::size_t)m_decimation;
+        return (int)((decimated - 1) / (std::size_t)m_hop + 1);
+    }
+
+    void ConstantQ::analyze(const audiofile::AudioView& audio, ConstantQFrames& out,
+        threading::WorkerPool* pool, int maxFrames) const
+    {
+        std::vector<float> mono(audio.Frames());
+        audio.CopyMono(mono.data());
+        analyze(mono.data(), mono.size(), out, pool, maxFrames);
+    }
+
+    void ConstantQ::analyze(const float* samples, std::size_t count, ConstantQFrames& out,
+        threading::WorkerPool* pool, int maxFrames) const
+    {
+        WAVEOUT_PROFILE_SCOPE("dsp.constantQ");
+        if (!samples) count = 0;
+
+        int frames = frame_count(count);
+        if (maxFrames >= 0) frames = (std::min)(frames, maxFrames);
+
+        const int bins = this->bins();
+        const std::size_t cells = (std::size_t)frames * (std::size_t)bins;
+        if (out.values.size() != cells) out.values.resize(cells);
+        out.frames = frames;
+        out.bins = bins;
+        out.binsPerSemitone = bins_per_semitone();
+        out.minMidi = m_config.minMidi;
+        out.hopSeconds = hop_seconds();
+        if (frames == 0) return;
+
+        if (m_decimation == 1)
+        {
+            transform(samples, count, frames, out, pool);
+            return;
+        }
+        std::vector<float> decimated;
+        decimate(samples, count, m_decimation, decimated);
+        transform(decimated.data(), decimated.size(), frames, out, pool);
+    }
+
+    void ConstantQ::transform(const float* samples, std::size_t count, int frames, ConstantQFrames& out,
+        threading::WorkerPool* pool) const
+    {
+        using Complex = FftwApi<fft_real>::Complex;
+        const int N = m_fftSize;
+        const int bins = this->bins();
+        run_batched_r2c<fft_real>(N, frames, m_config.batchFrames,
+            m_config.measurePlan ? FftwPlanCache::DEFAULT_FLAGS : FFTW_ESTIMATE, pool,
+            [&](int f, fft_real* dst) {
+                // Frame centred on f * hop; zeros outside the signal.
+                const long long start = (long long)f * m_hop - N / 2;
+                const long long lo = (std::max)(0LL, -start);
+                const long long hi = (std::min)((long long)N, (long long)count - start);
+                if (hi <= lo)
+                {
+                    std::memset(dst, 0, sizeof(fft_real) * (std::size_t)N);
+                    return;
+                }
+                std::memset(dst, 0, sizeof(fft_real) * (std::size_t)lo);
+                for (long long j = lo; j < hi; ++j)
+                    dst[j] = (fft_real)samples[start + j];
+                std::memset(dst + hi, 0, sizeof(fft_real) * (std::size_t)(N - hi));
+            },
+            [&](int f, const Complex* X) {
+                double* row = out.frame(f);
+                for (int k = 0; k < bins; ++k)
+                {
+                    double re = 0.0;
+                    double im = 0.0;
+                    for (int e = m_rowStart[(std::size_t)k]; e < m_rowStart[(std::size_t)k + 1]; ++e)
+                    {
+                        const Complex& x = X[m_columns[(std::size_t)e]];
+                        const double kr = m_kernelRe[(std::size_t)e];
+                        const double ki = m_kernelIm[(std::size_t)e];
+                        re += x[0] * kr - x[1] * ki;
+                        im += x[0] * ki + x[1] * kr;
+                    }
+                    row[k] = std::sqrt(re * re + im * im);
+                }
+            });
+    }
+}
@@ -0,0 +1,115 @@
+// ConstantQ.h
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "AudioView.h"
+#include "DSP.h"
+
+namespace threading
+{
+    class WorkerPool;
+}
+
+namespace dsp
+{
+    struct ConstantQConfig
+    {
+        int sampleRate = 44100;
+        int minMidi = 24;              // C1
+        int maxMidi = 108;             // C8
+        int binsPerOctave = 36;        // 12, 24 or 36; other values are rounded to a multiple of 12
+        double q = 0.0;                // 0 = 1 / (2^(1/binsPerOctave) - 1); lower = shorter kernels
+        int hop = 512;                 // samples at sampleRate between frame centres
+        double sparsity = 0.0054;      // kernel values below this fraction of the kernel's peak are dropped
+        int maxDecimation = 16;        // analyze at sampleRate / 2^k when the top bin allows it; 1 = never
+        int batchFrames = 8;           // frames per r2c call
+        bool measurePlan = false;      // FFTW_MEASURE the frame transform (sizes follow the note range)
+    };
+
+    // Frame-major constant-Q magnitude matrix. Bin b is semitone minMidi + b / binsPerSemitone; the
+    // bins of one semitone sit symmetrically around the note, so with 1 or 3 bins per semitone one
+    // of them is exactly on it. Magnitudes are peak amplitudes in input units (a full-scale PCM16
+    // sine on a bin reads ~32767), so 20*log10(m/32768) is dBFS.
+    struct ConstantQFrames
+    {
+        int frames = 0;
+        int bins = 0;
+        int binsPerSemitone = 1;
+        int minMidi = 0;
+        double hopSeconds = 0.0;       // frame f is centred on f * hopSeconds
+        std::vector<double> values;    // frames * bins
+
+        int notes() const { return binsPerSemitone > 0 ? bins / binsPerSemitone : 0; }
+        int maxMidi() const { return minMidi + notes() - 1; }
+        double time(int f) const { return f * hopSeconds; }
+        const double* frame(int f) const { return values.data() + (std::size_t)f * (std::size_t)bins; }
+        double* frame(int f) { return values.data() + (std::size_t)f * (std::size_t)bins; }
+
+        // Strongest bin of every semitone of frame f (notes() values, minMidi first).
+        void note_magnitudes(int f, double* out) const;
+    };
+
+    // Equal-tempered frequency of a (fractional) MIDI note, A4 = 440 Hz.
+    double midi_to_hz(double midi);
+
+    // Q of 12 bins per octave (~16.8): just resolves neighbouring semitones. With 24 or 36 bins per
+    // octave it keeps the kernels (and the FFT) 2-3x shorter than their own Q would.
+    double semitone_q();
+
+    // -------------------------
+    // Sparse-kernel constant-Q transform (Brown & Puckette, 1992)
+    // -------------------------
+    // Every bin's kernel is a Hamming-windowed complex exponential, Q cycles long, centred in one
+    // frame the length of the longest (lowest) kernel. The kernels are transformed once and their
+    // spectra pruned to the few FFT bins around each centre frequency, so a frame costs one real
+    // FFT plus a sparse complex product of ~bins * (a few) terms, whatever the bin count.
+    //
+    // The input is first decimated by the largest power of two that keeps the top bin below 0.4x
+    // the new rate, which shrinks the FFT for bass-only ranges the same way. Frames are centred
+    // on f * hop and zero-padded past either end of the signal. With a pool, batches of frames go to
+    // different threads through run_batched_r2c, the loop BatchedStft uses.
+    class ConstantQ
+    {
+    public:
+        ConstantQ() = default;
+        explicit ConstantQ(const ConstantQConfig& config) { init(config); }
+
+        void init(const ConstantQConfig& config);
+
+        const ConstantQConfig& config() const { return m_config; }
+        int bins() const { return (int)m_frequencies.size(); }
+        int bins_per_semitone() const { return m_config.binsPerOctave / 12; }
+        double bin_frequency(int b) const { return m_frequencies[(std::size_t)b]; }
+        int fft_size() const { return m_fftSize; }
+        int decimation() const { return m_decimation; }
+        double hop_seconds() const { return (double)m_hop * m_decimation / m_config.sampleRate; }
+        std::size_t kernel_nonzeros() const { return m_columns.size(); }
+
+        // Frames for `samples` input samples at config().sampleRate.
+        int frame_count(std::size_t samples) const;
+
+        // Mono downmix of the view. maxFrames < 0 analyzes every frame.
+        void analyze(const audiofile::AudioView& audio, ConstantQFrames& out,
+            threading::WorkerPool* pool = nullptr, int maxFrames = -1) const;
+        void analyze(const float* samples, std::size_t count, ConstantQFrames& out,
+            threading::WorkerPool* pool = nullptr, int maxFrames = -1) const;
+
+    private:
+        void transform(const float* samples, std::size_t count, int frames, ConstantQFrames& out,
+            threading::WorkerPool* pool) const;
+
+        ConstantQConfig m_config;
+        int m_decimation = 1;
+        int m_hop = 1;                      // at sampleRate / m_decimation
+        int m_fftSize = 0;
+        std::vector<double> m_frequencies;
+
+        // Sparse kernel, compressed rows: bin b uses FFT bins m_columns[m_rowStart[b] .. m_rowStart[b+1]).
+        std::vector<int> m_rowStart;
+        std::vector<int> m_columns;
+        std::vector<fft_real> m_kernelRe;   // conj(K) / N, so a row sum is the bin's complex value
+        std::vector<fft_real> m_kernelIm;
+    };
+}
@@ -6,12 +6,15 @@
 #include <cstring>
 #include <mutex>
 
+#include "Profiler.h"
+#include "RollingStats.h"
+
 namespace dsp
 {
     static constexpr double PI = 3.141592653589793238462643383279502884;
     static constexpr double EPS = 1e-20;
 
-    static std::mutex& fftw_plan_mutex()
+    std::mutex& fftw_plan_mutex()
     {
         static std::mutex m;
         return m;
@@ -112,19 +115,22 @@ namespace dsp
     }
 
     // -------------------------
-    // FftwR2C
+    // BasicFftwR2C
     // -------------------------
-    FftwR2C::~FftwR2C()
+    template <typename Real>
+    BasicFftwR2C<Real>::~BasicFftwR2C()
     {
         destroy();
     }
 
-    FftwR2C::FftwR2C(FftwR2C&& other) noexcept
+    template <typename Real>
+    BasicFftwR2C<Real>::BasicFftwR2C(BasicFftwR2C&& other) noexcept
     {
         *this = std::move(other);
     }
 
-    FftwR2C& FftwR2C::operator=(FftwR2C&& other) noexcept
+    template <typename Real>
+    BasicFftwR2C<Real>& BasicFftwR2C<Real>::operator=(BasicFftwR2C&& other) noexcept
     {
         if (this == &other) return *this;
 
@@ -143,7 +149,8 @@ namespace dsp
         return *this;
     }
 
-    void FftwR2C::init(int nfft)
+    template <typename Real>
+    void BasicFftwR2C<Real>::init(int nfft)
     {
         if (nfft <= 0) nfft = 1024;
         if (nfft == m_nfft && m_plan) return;
@@ -151,34 +158,31 @@ namespace dsp
         destroy();
 
         m_nfft = nfft;
-        m_in = (double*)fftw_malloc(sizeof(double) * (std::size_t)m_nfft);
-        m_out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * (std::size_t)(m_nfft / 2 + 1));
+        m_in = (Real*)fftw_malloc(sizeof(Real) * (std::size_t)m_nfft);
+        m_out = (Complex*)fftw_malloc(sizeof(Complex) * (std::size_t)(m_nfft / 2 + 1));
 
-        // FFTW_ESTIMATE is fast to create; good for interactive UI. (MEASURE can stall.)
-        {
-            std::lock_guard<std::mutex> lock(fftw_plan_mutex());
-            m_plan = fftw_plan_dft_r2c_1d(m_nfft, m_in, m_out, FFTW_ESTIMATE);
-        }
+        // Shared with every other FftwR2C of this size; measured once, then loaded from wisdom.
+        m_plan = FftwPlanCache::instance().plan<Real>(FftKind::R2C, m_nfft, m_in, m_out);
     }
 
-    void FftwR2C::destroy()
+    template <typename Real>
+    void BasicFftwR2C<Real>::destroy()
     {
-        if (m_plan)
-        {
-            std::lock_guard<std::mutex> lock(fftw_plan_mutex());
-            fftw_destroy_plan(m_plan);
-            m_plan = nullptr;
-        }
+        m_plan = nullptr; // owned by FftwPlanCache
         if (m_out) { fftw_free(m_out); m_out = nullptr; }
         if (m_in) { fftw_free(m_in); m_in = nullptr; }
         m_nfft = 0;
     }
 
-    void FftwR2C::execute()
+    template <typename Real>
+    void BasicFftwR2C<Real>::execute()
     {
-        if (m_plan) fftw_execute(m_plan);
+        if (m_plan) FftwApi<Real>::execute_r2c(m_plan, m_in, m_out);
     }
 
+    template class BasicFftwR2C<double>;
+    template class BasicFftwR2C<float>;
+
     // -------------------------
     // StftBandAnalyzer
     // -------------------------
@@ -204,6 +208,7 @@ namespace dsp
         std::size_t centerIndex,
         const BandConfig& cfg)
     {
+        WAVEOUT_PROFILE_SCOPE("dsp.stftBands");
         BandEnergies out{};
 
         if (!samples || totalSamples == 0 || m_fft.nfft() <= 0)
@@ -214,7 +219,7 @@ namespace dsp
         const long long segStart = (long long)centerIndex - half;
 
         // Fill windowed FFT input
-        double* in = m_fft.in();
+        fft_real* in = m_fft.in();
         for (int i = 0; i < nfft; ++i)
         {
             long long idx = segStart + i;
@@ -222,12 +227,12 @@ namespace dsp
             if (idx >= 0 && (std::size_t)idx < totalSamples)
                 s = (double)samples[(std::size_t)idx] / 32768.0;
 
-            in[i] = s * m_window[(std::size_t)i];
+            in[i] = (fft_real)(s * m_window[(std::size_t)i]);
         }
 
         m_fft.execute();
 
-        const fftw_complex* X = m_fft.out();
+        const FftwR2C::Complex* X = m_fft.out();
 
         const double lowMax = std::max(1.0, cfg.lowMaxHz);
         const double midMax = std::max(lowMax + 1.0, cfg.midMaxHz);
@@ -264,6 +269,7 @@ namespace dsp
         std::vector<short>& outMaxS,
         std::vector<uint32_t>& outColorref)
     {
+        WAVEOUT_PROFILE_SCOPE("dsp.buildWaveformCache");
         outMinS.clear();
         outMaxS.clear();
         outColorref.clear();
@@ -290,26 +296,12 @@ namespace dsp
             const std::size_t start = (std::size_t)x * (std::size_t)samplesPerPx;
             const std::size_t end = std::min(totalSamples, start + (std::size_t)samplesPerPx);
 
-            // min/max in this pixel column
-            short mn = SHRT_MAX;
-            short mx = SHRT_MIN;
-
-            if (start < end)
-            {
-                for (std::size_t i = start; i < end; ++i)
-                {
-                    short v = samples[i];
-                    if (v < mn) mn = v;
-                    if (v > mx) mx = v;
-                }
-            }
-            else
-            {
-                mn = 0; mx = 0;
-            }
-
-            outMinS[(std::size_t)x] = mn;
-            outMaxS[(std::size_t)x] = mx;
+            // min/max in this pixel column (0/0 past the end)
+            MinMax<short> column;
+            for (std::size_t i = start; i < end; ++i)
+                column.push(samples[i]);
+            outMinS[(std::size_t)x] = column.min_or_zero();
+            outMaxS[(std::size_t)x] = column.max_or_zero();
 
             // spectral features centered in the column
             const std::size_t center = (start + end) / 2;
@@ -339,6 +331,7 @@ namespace dsp
         std::vector<short>& outMaxS,
         std::vector<uint32_t>& outColorref)
     {
+        WAVEOUT_PROFILE_SCOPE("dsp.buildWaveformCacheChunks");
         outMinS.clear();
         outMaxS.clear();
         outColorref.clear();
@@ -379,15 +372,11 @@ namespace dsp
                 continue;
             }
 
-            short mn = samples[chunkStart];
-            short mx = samples[chunkStart];
-            for (std::size_t i = chunkStart + 1; i < chunkEnd; ++i)
-            {
-                mn = (std::min)(mn, samples[i]);
-                mx = (std::max)(mx, samples[i]);
-            }
-            outMinS[(std::size_t)x] = mn;
-            outMaxS[(std::size_t)x] = mx;
+            MinMax<short> chunk;
+            for (std::size_t i = chunkStart; i < chunkEnd; ++i)
+                chunk.push(samples[i]);
+            outMinS[(std::size_t)x] = chunk.min_or_zero();
+            outMaxS[(std::size_t)x] = chunk.max_or_zero();
 
             energies[(std::size_t)x] = analyzer.analyzeCenteredPcm16(
                 samples + chunkStart,
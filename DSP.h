@@ -1,13 +1,27 @@
 // dsp.h
 #pragma once
 
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <vector>
 #include <fftw3.h>
 
+#include "FftwPlanCache.h"
+
 namespace dsp
 {
+    // Sample type of the spectral stages (FftwR2C, StftBandAnalyzer, the spectrum windows and the
+    // default for BatchedStft / BandSplitter). 16-bit sources lose nothing audible in float32 (see
+    // `--bench=precision`), and float doubles the SIMD width and halves the memory traffic. Build
+    // with WAVEOUT_DOUBLE_PRECISION_FFT to run them in double instead.
+#ifdef WAVEOUT_DOUBLE_PRECISION_FFT
+    using fft_real = double;
+#else
+    using fft_real = float;
+#endif
+
     // -------------------------
     // Small structs
     // -------------------------
@@ -45,16 +59,37 @@ namespace dsp
     // -------------------------
     double clamp(double x, double lo, double hi);
 
+    // FFTW's planner is not thread-safe; plan creation/destruction in dsp goes through this lock.
+    std::mutex& fftw_plan_mutex();
+
     double hann(int i, int N);
 
     double energy(const float* x, std::size_t n, std::size_t stride = 1);
     double rms(const float* x, std::size_t n, std::size_t stride = 1);
 
+    // PCM16 <-> float use one scale both ways (1 / 32768), so a round trip is exact. Full-scale
+    // positive input clamps to 32767; non-finite input becomes silence.
     inline float pcm16_to_float(short s)
     {
         return (float)((double)s / 32768.0);
     }
 
+    // Clamped in double before rounding, so unnormalized input clips instead of overflowing.
+    inline short float_to_pcm16(double x)
+    {
+        if (!std::isfinite(x)) return 0;
+        const double s = x * 32768.0;
+        return (short)std::lround(s < -32768.0 ? -32768.0 : (s > 32767.0 ? 32767.0 : s));
+    }
+
+    // Same convention at 24 bits (1 / 2^23), e.g. for PCM24 WAV output.
+    inline std::int32_t float_to_pcm24(double x)
+    {
+        if (!std::isfinite(x)) return 0;
+        const double s = x * 8388608.0;
+        return (std::int32_t)std::lround(s < -8388608.0 ? -8388608.0 : (s > 8388607.0 ? 8388607.0 : s));
+    }
+
     // Spectral-color mapping (band ratios -> RGB) with brightness driven by total energy
     RGB8 color_from_bands(double low, double mid, double high,
         double total, double maxTotal,
@@ -85,38 +120,43 @@ namespace dsp
     };
 
     // -------------------------
-    // FFTW reusable R2C plan
+    // FFTW reusable R2C plan (double or float)
     // -------------------------
-    class FftwR2C
+    template <typename Real>
+    class BasicFftwR2C
     {
     public:
-        FftwR2C() = default;
-        explicit FftwR2C(int nfft) { init(nfft); }
-        ~FftwR2C();
+        using Complex = typename FftwApi<Real>::Complex;
 
-        FftwR2C(const FftwR2C&) = delete;
-        FftwR2C& operator=(const FftwR2C&) = delete;
+        BasicFftwR2C() = default;
+        explicit BasicFftwR2C(int nfft) { init(nfft); }
+        ~BasicFftwR2C();
 
-        FftwR2C(FftwR2C&& other) noexcept;
-        FftwR2C& operator=(FftwR2C&& other) noexcept;
+        BasicFftwR2C(const BasicFftwR2C&) = delete;
+        BasicFftwR2C& operator=(const BasicFftwR2C&) = delete;
+
+        BasicFftwR2C(BasicFftwR2C&& other) noexcept;
+        BasicFftwR2C& operator=(BasicFftwR2C&& other) noexcept;
 
         void init(int nfft);      // (re)create plan/buffers
         void destroy();
 
         int nfft() const { return m_nfft; }
-        double* in() { return m_in; }
-        fftw_complex* out() { return m_out; } // length nfft/2 + 1
-        const fftw_complex* out() const { return m_out; }
+        Real* in() { return m_in; }
+        Complex* out() { return m_out; } // length nfft/2 + 1
+        const Complex* out() const { return m_out; }
 
         void execute();
 
     private:
         int m_nfft = 0;
-        double* m_in = nullptr;
-        fftw_complex* m_out = nullptr;
-        fftw_plan m_plan = nullptr;
+        Real* m_in = nullptr;
+        Complex* m_out = nullptr;
+        typename FftwApi<Real>::Plan m_plan = nullptr;
     };
 
+    using FftwR2C = BasicFftwR2C<fft_real>;
+
     // -------------------------
     // STFT band analyzer (centered window)
     // -------------------------
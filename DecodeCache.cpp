@@ -0,0 +1,255 @@
+#include "DecodeCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+#include <windows.h>
+
+namespace audiofile
+{
+    namespace
+    {
+        static void SetError(std::string* outErr, const std::string& msg)
+        {
+            if (outErr) *outErr = msg;
+        }
+
+        static void Fnv1a64MixBytes(std::uint64_t& h, const void* data, std::size_t n)
+        {
+            const auto* p = static_cast<const unsigned char*>(data);
+            constexpr std::uint64_t kPrime = 1099511628211ull;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                h ^= static_cast<std::uint64_t>(p[i]);
+                h *= kPrime;
+            }
+        }
+
+        template <typename T>
+        static void Fnv1a64MixValue(std::uint64_t& h, const T& v)
+        {
+            Fnv1a64MixBytes(h, &v, sizeof(T));
+        }
+
+        static void put_u16le(unsigned char* p, std::uint16_t v)
+        {
+            p[0] = static_cast<unsigned char>(v & 0xFF);
+            p[1] = static_cast<unsigned char>((v >> 8) & 0xFF);
+        }
+
+        static void put_u32le(unsigned char* p, std::uint32_t v)
+        {
+            p[0] = static_cast<unsigned char>(v & 0xFF);
+            p[1] = static_cast<unsigned char>((v >> 8) & 0xFF);
+            p[2] = static_cast<unsigned char>((v >> 16) & 0xFF);
+            p[3] = static_cast<unsigned char>((v >> 24) & 0xFF);
+        }
+
+        // Bumped whenever the decoder output for the same source could change.
+        constexpr std::uint32_t kDecodeCacheVersion = 1;
+    }
+
+    DecodeCache::DecodeCache(std::filesystem::path directory, std::uint64_t maxBytes)
+        : m_directory(std::move(directory)), m_maxBytes(maxBytes)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(m_directory, ec);
+    }
+
+    std::filesystem::path DecodeCache::DefaultDirectory()
+    {
+        wchar_t tmpPath[MAX_PATH] = {};
+        if (!GetTempPathW(MAX_PATH, tmpPath))
+            return std::filesystem::current_path() / L"decode_cache";
+        return std::filesystem::path(tmpPath) / L"waveOut" / L"decode_cache";
+    }
+
+    bool DecodeCache::Caches(const std::string& sourcePath)
+    {
+        std::string ext = std::filesystem::path(sourcePath).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext != ".wav" && ext != ".wave";
+    }
+
+    bool DecodeCache::EntryPathFor(const std::string& sourcePath, std::filesystem::path& outPath) const
+    {
+        const std::wstring source = std::filesystem::path(sourcePath).wstring();
+
+        WIN32_FILE_ATTRIBUTE_DATA fad{};
+        if (!GetFileAttributesExW(source.c_str(), GetFileExInfoStandard, &fad) ||
+            (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            return false;
+
+        // Normalize to absolute path when possible to reduce misses from relative-path spelling.
+        std::wstring sourcePathForKey = source;
+        wchar_t fullBuf[MAX_PATH] = {};
+        DWORD fullLen = GetFullPathNameW(source.c_str(), MAX_PATH, fullBuf, nullptr);
+        if (fullLen > 0 && fullLen < MAX_PATH)
+            sourcePathForKey.assign(fullBuf, fullLen);
+
+        std::uint64_t h = 1469598103934665603ull; // FNV-1a 64 offset basis
+        Fnv1a64MixValue(h, kDecodeCacheVersion);
+        Fnv1a64MixBytes(h, sourcePathForKey.data(), sourcePathForKey.size() * sizeof(wchar_t));
+        Fnv1a64MixValue(h, fad.nFileSizeHigh);
+        Fnv1a64MixValue(h, fad.nFileSizeLow);
+        Fnv1a64MixValue(h, fad.ftLastWriteTime.dwHighDateTime);
+        Fnv1a64MixValue(h, fad.ftLastWriteTime.dwLowDateTime);
+
+        char fileName[64] = {};
+        std::snprintf(fileName, sizeof(fileName), "pcm_%016llx.wav", static_cast<unsigned long long>(h));
+        outPath = m_directory / fileName;
+        return true;
+    }
+
+    bool DecodeCache::TryOpen(const std::string& sourcePath, MappedWavFile& out) const
+    {
+        if (!Caches(sourcePath))
+            return false;
+
+        std::filesystem::path entry;
+        if (!EntryPathFor(sourcePath, entry))
+            return false;
+
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(entry, ec))
+            return false;
+
+        // Refresh recency before mapping; eviction is ordered by last-write time.
+        std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), ec);
+
+        if (!out.Open(entry))
+        {
+            // Corrupt or truncated entry; drop it so the next run re-decodes.
+            std::filesystem::remove(entry, ec);
+            return false;
+        }
+        return true;
+    }
+
+    bool DecodeCache::Store(const std::string& sourcePath, const DecodedPcm16& pcm, std::string* errorMessage)
+    {
+        if (!Caches(sourcePath))
+        {
+            SetError(errorMessage, "WAV sources are not cached: " + sourcePath);
+            return false;
+        }
+        if (pcm.samples.empty() || pcm.channels <= 0 || pcm.sampleRate <= 0)
+        {
+            SetError(errorMessage, "Nothing to cache for: " + sourcePath);
+            return false;
+        }
+
+        std::filesystem::path entry;
+        if (!EntryPathFor(sourcePath, entry))
+        {
+            SetError(errorMessage, "Cannot stat source for decode cache key: " + sourcePath);
+            return false;
+        }
+
+        const std::uint64_t dataBytes = static_cast<std::uint64_t>(pcm.samples.size()) * sizeof(short);
+        if (dataBytes > 0xFFFFFFFFull - 36ull)
+        {
+            SetError(errorMessage, "Decoded audio too large for the decode cache: " + sourcePath);
+            return false;
+        }
+
+        unsigned char hdr[44] = {};
+        const std::uint16_t ch = static_cast<std::uint16_t>(pcm.channels);
+        const std::uint32_t sr = static_cast<std::uint32_t>(pcm.sampleRate);
+        std::memcpy(hdr + 0, "RIFF", 4);
+        put_u32le(hdr + 4, static_cast<std::uint32_t>(36ull + dataBytes));
+        std::memcpy(hdr + 8, "WAVE", 4);
+        std::memcpy(hdr + 12, "fmt ", 4);
+        put_u32le(hdr + 16, 16);
+        put_u16le(hdr + 20, 1); // PCM
+        put_u16le(hdr + 22, ch);
+        put_u32le(hdr + 24, sr);
+        put_u32le(hdr + 28, sr * ch * 2u);
+        put_u16le(hdr + 32, static_cast<std::uint16_t>(ch * 2u));
+        put_u16le(hdr + 34, 16);
+        std::memcpy(hdr + 36, "data", 4);
+        put_u32le(hdr + 40, static_cast<std::uint32_t>(dataBytes));
+
+        std::error_code ec;
+        std::filesystem::create_directories(m_directory, ec);
+        std::filesystem::path tmpPath = entry;
+        tmpPath += L".tmp";
+
+        bool ok = false;
+        {
+            std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+            if (f)
+            {
+                f.write(reinterpret_cast<const char*>(hdr), sizeof(hdr));
+                f.write(reinterpret_cast<const char*>(pcm.samples.data()), static_cast<std::streamsize>(dataBytes));
+                ok = static_cast<bool>(f);
+            }
+        }
+
+        if (!ok)
+        {
+            std::filesystem::remove(tmpPath, ec);
+            SetError(errorMessage, "Failed to write decode cache entry: " + tmpPath.string());
+            return false;
+        }
+
+        std::filesystem::remove(entry, ec);
+        std::filesystem::rename(tmpPath, entry, ec);
+        if (ec)
+        {
+            std::filesystem::remove(tmpPath, ec);
+            SetError(errorMessage, "Failed to publish decode cache entry: " + entry.string());
+            return false;
+        }
+
+        EvictToLimit();
+        return true;
+    }
+
+    void DecodeCache::EvictToLimit()
+    {
+        std::lock_guard<std::mutex> lock(m_evictMutex);
+
+        struct Entry
+        {
+            std::filesystem::path path;
+            std::uint64_t bytes = 0;
+            std::filesystem::file_time_type lastUse{};
+        };
+
+        std::vector<Entry> entries;
+        std::uint64_t total = 0;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(m_directory, ec), end; !ec && it != end; it.increment(ec))
+        {
+            const std::filesystem::path& p = it->path();
+            if (p.extension() != L".wav" || p.filename().wstring().rfind(L"pcm_", 0) != 0)
+                continue;
+            std::error_code sizeEc, timeEc;
+            const std::uint64_t bytes = it->file_size(sizeEc);
+            const auto lastUse = it->last_write_time(timeEc);
+            if (sizeEc || timeEc)
+                continue;
+            entries.push_back({ p, bytes, lastUse });
+            total += bytes;
+        }
+
+        if (total <= m_maxBytes)
+            return;
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+        for (const Entry& e : entries)
+        {
+            if (total <= m_maxBytes)
+                break;
+            std::error_code rmEc;
+            if (std::filesystem::remove(e.path, rmEc))
+                total -= e.bytes;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+#include "AudioFileLoader.h"
+#include "MappedFile.h"
+
+namespace audiofile
+{
+    // On-disk cache of decoded PCM for compressed sources (MP3/FLAC/...).
+    //
+    // Entries are keyed like the waveform envelope cache: absolute source path + file size +
+    // last-write time, hashed with FNV-1a 64. Each entry is stored as a plain PCM16 WAV so a
+    // warm start memory-maps it through MappedWavFile and skips decoding entirely.
+    // Entries are written to a temp file and renamed into place, and the directory is trimmed
+    // to maxBytes by evicting least-recently-used entries (a hit refreshes the entry's mtime).
+    class DecodeCache
+    {
+    public:
+        static constexpr std::uint64_t kDefaultMaxBytes = 4ull * 1024ull * 1024ull * 1024ull;
+
+        explicit DecodeCache(std::filesystem::path directory = DefaultDirectory(), std::uint64_t maxBytes = kDefaultMaxBytes);
+
+        // %TEMP%/waveOut/decode_cache
+        static std::filesystem::path DefaultDirectory();
+
+        // WAV sources are never cached: they are already PCM, and a copy in the cache would only
+        // duplicate them on disk. Only compressed sources (MP3/FLAC/...) qualify.
+        static bool Caches(const std::string& sourcePath);
+
+        // Maps the cached decode of sourcePath. Returns false on a miss, a stale/corrupt entry or a
+        // source that is not cached (see Caches).
+        bool TryOpen(const std::string& sourcePath, MappedWavFile& out) const;
+
+        // Writes a decoded source into the cache, then evicts down to the size limit.
+        bool Store(const std::string& sourcePath, const DecodedPcm16& pcm, std::string* errorMessage = nullptr);
+
+        // Deletes least-recently-used entries until the cache fits in maxBytes.
+        // Entries that are currently mapped cannot be deleted and are skipped.
+        void EvictToLimit();
+
+        const std::filesystem::path& Directory() const { return m_directory; }
+        std::uint64_t MaxBytes() const { return m_maxBytes; }
+
+    private:
+        bool EntryPathFor(const std::string& sourcePath, std::filesystem::path& outPath) const;
+
+        std::filesystem::path m_directory;
+        std::uint64_t m_maxBytes = kDefaultMaxBytes;
+        std::mutex m_evictMutex;
+    };
+}
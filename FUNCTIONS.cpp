@@ -2,6 +2,8 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <utility>
 
 using namespace std;
 
@@ -17,17 +19,37 @@ using namespace std;
 
 	vector<short> FUNCTIONS::double_to_short(vector<double> &data)
 	{
-		return vector<short>();
+		vector<short> audio_short(data.size());
+		std::transform(data.begin(), data.end(), audio_short.begin(), [](double val) {
+			return static_cast<short>(std::clamp(std::round(val), -32768.0, 32767.0));
+			});
+		return audio_short;
 	}
 
+	//Interleaved stereo -> (left, right)
 	std::pair<vector<short>, vector<short>> FUNCTIONS::split_audio(vector<short> &data)
 	{
-		return std::pair<vector<short>, vector<short>>();
+		const size_t frames = data.size() / 2;
+		vector<short> left(frames);
+		vector<short> right(frames);
+		for (size_t i = 0; i < frames; i++)
+		{
+			left[i] = data[2 * i];
+			right[i] = data[2 * i + 1];
+		}
+		return std::make_pair(std::move(left), std::move(right));
 	}
 
+	//(left, right) -> mono average
 	vector<short> FUNCTIONS::consolidate(vector<short> &left, vector<short> &right)
 	{
-		return vector<short>();
+		const size_t frames = std::min(left.size(), right.size());
+		vector<short> mono(frames);
+		for (size_t i = 0; i < frames; i++)
+		{
+			mono[i] = static_cast<short>((left[i] + right[i]) / 2);
+		}
+		return mono;
 	}
 
 
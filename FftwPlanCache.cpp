@@ -0,0 +1,253 @@
+// FftwPlanCache.cpp
+#include "FftwPlanCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <system_error>
+
+#include "DSP.h"
+#include "Profiler.h"
+
+namespace dsp
+{
+    FftwPlanCache& FftwPlanCache::instance()
+    {
+        static FftwPlanCache cache;
+        return cache;
+    }
+
+    FftwPlanCache::FftwPlanCache()
+    {
+        // Best effort: a missing or stale wisdom file only means the first plans get measured again.
+        load_wisdom(default_wisdom_path());
+    }
+
+    template <>
+    std::map<FftwPlanCache::Key, fftw_plan>& FftwPlanCache::plan_map<double>()
+    {
+        return m_plans;
+    }
+
+    template <>
+    std::map<FftwPlanCache::Key, fftwf_plan>& FftwPlanCache::plan_map<float>()
+    {
+        return m_plansF;
+    }
+
+    template <typename Real>
+    typename FftwApi<Real>::Plan FftwPlanCache::plan_many(FftKind kind, int n, int howmany, const void* in, const void* out, unsigned flags)
+    {
+        using Api = FftwApi<Real>;
+        if (n <= 0 || howmany <= 0 || !in || !out) return nullptr;
+
+        const bool inPlace = (in == out);
+        const int alignIn = Api::alignment_of(in);
+        const int alignOut = inPlace ? alignIn : Api::alignment_of(out);
+
+        // Planning is not thread-safe in FFTW, so lookups share the planner's lock; once a size has
+        // been planned this is just a map lookup.
+        std::lock_guard<std::mutex> lock(fftw_plan_mutex());
+        if (flags == DEFAULT_FLAGS) flags = m_flags;
+        const Key key{ (int)kind, n, howmany, inPlace, alignIn, alignOut, flags };
+
+        auto& plans = plan_map<Real>();
+        auto it = plans.find(key);
+        if (it != plans.end()) return it->second;
+
+        typename Api::Plan p = create_plan<Real>(kind, n, howmany, inPlace, alignIn, alignOut, flags);
+        if (p)
+        {
+            plans.emplace(key, p);
+            m_dirty = true;
+        }
+        return p;
+    }
+
+    template <typename Real>
+    typename FftwApi<Real>::Plan FftwPlanCache::create_plan(FftKind kind, int n, int howmany, bool inPlace, int alignIn, int alignOut, unsigned flags)
+    {
+        WAVEOUT_PROFILE_SCOPE("fftw.createPlan");
+        using Api = FftwApi<Real>;
+        using Complex = typename Api::Complex;
+
+        // Scratch arrays with the caller's alignment offset. MEASURE/PATIENT scribble over them,
+        // which is why plans are never made on the caller's data.
+        const int bins = n / 2 + 1;
+        const int realDist = inPlace ? 2 * bins : n;
+        const int complexDist = (kind == FftKind::R2C || kind == FftKind::C2R) ? bins : n;
+        const std::size_t realBytes = sizeof(Real) * (std::size_t)realDist * (std::size_t)howmany;
+        const std::size_t complexBytes = sizeof(Complex) * (std::size_t)complexDist * (std::size_t)howmany;
+        std::size_t inBytes = 0;
+        std::size_t outBytes = 0;
+        switch (kind)
+        {
+        case FftKind::R2C:
+            inBytes = inPlace ? complexBytes : realBytes;
+            outBytes = complexBytes;
+            break;
+        case FftKind::C2R:
+            inBytes = complexBytes;
+            outBytes = inPlace ? complexBytes : realBytes;
+            break;
+        case FftKind::C2CForward:
+        case FftKind::C2CBackward:
+            inBytes = outBytes = complexBytes;
+            break;
+        }
+
+        static constexpr std::size_t SLACK = 64; // >= any SIMD alignment FFTW cares about
+        char* inMem = (char*)fftw_malloc(inBytes + SLACK);
+        char* outMem = inPlace ? inMem : (char*)fftw_malloc(outBytes + SLACK);
+        if (!inMem || !outMem)
+        {
+            if (inMem) fftw_free(inMem);
+            if (outMem && outMem != inMem) fftw_free(outMem);
+            return nullptr;
+        }
+        void* in = inMem + alignIn;
+        void* out = outMem + alignOut;
+
+        // A batch of one is planned exactly like the plain 1-D transform.
+        typename Api::Plan p = nullptr;
+        switch (kind)
+        {
+        case FftKind::R2C:
+            p = Api::plan_many_r2c(n, howmany, (Real*)in, realDist, (Complex*)out, complexDist, flags);
+            break;
+        case FftKind::C2R:
+            p = Api::plan_many_c2r(n, howmany, (Complex*)in, complexDist, (Real*)out, realDist, flags);
+            break;
+        case FftKind::C2CForward:
+            p = Api::plan_many_c2c(n, howmany, (Complex*)in, (Complex*)out, complexDist, FFTW_FORWARD, flags);
+            break;
+        case FftKind::C2CBackward:
+            p = Api::plan_many_c2c(n, howmany, (Complex*)in, (Complex*)out, complexDist, FFTW_BACKWARD, flags);
+            break;
+        }
+
+        if (outMem != inMem) fftw_free(outMem);
+        fftw_free(inMem);
+        return p;
+    }
+
+    template fftw_plan FftwPlanCache::plan_many<double>(FftKind, int, int, const void*, const void*, unsigned);
+    template fftwf_plan FftwPlanCache::plan_many<float>(FftKind, int, int, const void*, const void*, unsigned);
+
+    void FftwPlanCache::r2c(int n, double* in, fftw_complex* out)
+    {
+        if (fftw_plan p = plan<double>(FftKind::R2C, n, in, out)) fftw_execute_dft_r2c(p, in, out);
+    }
+
+    void FftwPlanCache::r2c(int n, float* in, fftwf_complex* out)
+    {
+        if (fftwf_plan p = plan<float>(FftKind::R2C, n, in, out)) fftwf_execute_dft_r2c(p, in, out);
+    }
+
+    void FftwPlanCache::c2r(int n, fftw_complex* in, double* out)
+    {
+        if (fftw_plan p = plan<double>(FftKind::C2R, n, in, out)) fftw_execute_dft_c2r(p, in, out);
+    }
+
+    void FftwPlanCache::c2r(int n, fftwf_complex* in, float* out)
+    {
+        if (fftwf_plan p = plan<float>(FftKind::C2R, n, in, out)) fftwf_execute_dft_c2r(p, in, out);
+    }
+
+    void FftwPlanCache::c2c(int n, fftw_complex* in, fftw_complex* out, int sign)
+    {
+        const FftKind kind = (sign == FFTW_BACKWARD) ? FftKind::C2CBackward : FftKind::C2CForward;
+        if (fftw_plan p = plan<double>(kind, n, in, out)) fftw_execute_dft(p, in, out);
+    }
+
+    void FftwPlanCache::c2c(int n, fftwf_complex* in, fftwf_complex* out, int sign)
+    {
+        const FftKind kind = (sign == FFTW_BACKWARD) ? FftKind::C2CBackward : FftKind::C2CForward;
+        if (fftwf_plan p = plan<float>(kind, n, in, out)) fftwf_execute_dft(p, in, out);
+    }
+
+    void FftwPlanCache::set_planner_flags(unsigned flags)
+    {
+        std::lock_guard<std::mutex> lock(fftw_plan_mutex());
+        m_flags = flags;
+    }
+
+    unsigned FftwPlanCache::planner_flags() const
+    {
+        std::lock_guard<std::mutex> lock(fftw_plan_mutex());
+        return m_flags;
+    }
+
+    bool FftwPlanCache::parse_planner_flags(const std::string& name, unsigned& flags)
+    {
+        std::string s = name;
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        if (s == "estimate") { flags = FFTW_ESTIMATE; return true; }
+        if (s == "measure") { flags = FFTW_MEASURE; return true; }
+        if (s == "patient") { flags = FFTW_PATIENT; return true; }
+        return false;
+    }
+
+    std::filesystem::path FftwPlanCache::default_wisdom_path()
+    {
+        std::error_code ec;
+        std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+        if (ec) dir = ".";
+        return dir / "waveOut" / "fftw.wisdom";
+    }
+
+    std::filesystem::path FftwPlanCache::float_wisdom_path(const std::filesystem::path& path)
+    {
+        std::filesystem::path p = path;
+        p.replace_filename(path.stem().string() + "f" + path.extension().string());
+        return p;
+    }
+
+    bool FftwPlanCache::load_wisdom(const std::filesystem::path& path, std::string* errorMessage)
+    {
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec))
+        {
+            if (errorMessage) *errorMessage = "No FFTW wisdom at " + path.string();
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(fftw_plan_mutex());
+        if (!FftwApi<double>::import_wisdom(path.string().c_str()))
+        {
+            if (errorMessage) *errorMessage = "Failed to import FFTW wisdom from " + path.string();
+            return false;
+        }
+        // Float wisdom is optional: older wisdom directories only have the double file.
+        const std::filesystem::path floatPath = float_wisdom_path(path);
+        if (std::filesystem::exists(floatPath, ec))
+            FftwApi<float>::import_wisdom(floatPath.string().c_str());
+        return true;
+    }
+
+    bool FftwPlanCache::save_wisdom(const std::filesystem::path& path, std::string* errorMessage)
+    {
+        std::lock_guard<std::mutex> lock(fftw_plan_mutex());
+        if (!m_dirty) return true;
+
+        std::error_code ec;
+        if (path.has_parent_path())
+            std::filesystem::create_directories(path.parent_path(), ec);
+
+        const std::filesystem::path floatPath = float_wisdom_path(path);
+        if (!FftwApi<double>::export_wisdom(path.string().c_str()) ||
+            !FftwApi<float>::export_wisdom(floatPath.string().c_str()))
+        {
+            if (errorMessage) *errorMessage = "Failed to write FFTW wisdom to " + path.string();
+            return false;
+        }
+        m_dirty = false;
+        return true;
+    }
+
+    std::size_t FftwPlanCache::size() const
+    {
+        std::lock_guard<std::mutex> lock(fftw_plan_mutex());
+        return m_plans.size() + m_plansF.size();
+    }
+}
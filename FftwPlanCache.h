@@ -0,0 +1,209 @@
+// FftwPlanCache.h
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <tuple>
+#include <fftw3.h>
+
+namespace dsp
+{
+    // -------------------------
+    // fftw_* / fftwf_* by sample type, so double and float code can share one implementation
+    // -------------------------
+    template <typename Real>
+    struct FftwApi;
+
+    template <>
+    struct FftwApi<double>
+    {
+        using Complex = fftw_complex;
+        using Plan = fftw_plan;
+
+        static int alignment_of(const void* p) { return fftw_alignment_of((double*)p); }
+        static Plan plan_many_r2c(int n, int howmany, double* in, int idist, Complex* out, int odist, unsigned flags)
+        {
+            return fftw_plan_many_dft_r2c(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+        }
+        static Plan plan_many_c2r(int n, int howmany, Complex* in, int idist, double* out, int odist, unsigned flags)
+        {
+            return fftw_plan_many_dft_c2r(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+        }
+        static Plan plan_many_c2c(int n, int howmany, Complex* in, Complex* out, int dist, int sign, unsigned flags)
+        {
+            return fftw_plan_many_dft(1, &n, howmany, in, nullptr, 1, dist, out, nullptr, 1, dist, sign, flags);
+        }
+        static void execute_r2c(Plan p, double* in, Complex* out) { fftw_execute_dft_r2c(p, in, out); }
+        static void execute_c2r(Plan p, Complex* in, double* out) { fftw_execute_dft_c2r(p, in, out); }
+        static void execute_c2c(Plan p, Complex* in, Complex* out) { fftw_execute_dft(p, in, out); }
+        static int import_wisdom(const char* path) { return fftw_import_wisdom_from_filename(path); }
+        static int export_wisdom(const char* path) { return fftw_export_wisdom_to_filename(path); }
+    };
+
+    template <>
+    struct FftwApi<float>
+    {
+        using Complex = fftwf_complex;
+        using Plan = fftwf_plan;
+
+        static int alignment_of(const void* p) { return fftwf_alignment_of((float*)p); }
+        static Plan plan_many_r2c(int n, int howmany, float* in, int idist, Complex* out, int odist, unsigned flags)
+        {
+            return fftwf_plan_many_dft_r2c(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+        }
+        static Plan plan_many_c2r(int n, int howmany, Complex* in, int idist, float* out, int odist, unsigned flags)
+        {
+            return fftwf_plan_many_dft_c2r(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+        }
+        static Plan plan_many_c2c(int n, int howmany, Complex* in, Complex* out, int dist, int sign, unsigned flags)
+        {
+            return fftwf_plan_many_dft(1, &n, howmany, in, nullptr, 1, dist, out, nullptr, 1, dist, sign, flags);
+        }
+        static void execute_r2c(Plan p, float* in, Complex* out) { fftwf_execute_dft_r2c(p, in, out); }
+        static void execute_c2r(Plan p, Complex* in, float* out) { fftwf_execute_dft_c2r(p, in, out); }
+        static void execute_c2c(Plan p, Complex* in, Complex* out) { fftwf_execute_dft(p, in, out); }
+        static int import_wisdom(const char* path) { return fftwf_import_wisdom_from_filename(path); }
+        static int export_wisdom(const char* path) { return fftwf_export_wisdom_to_filename(path); }
+    };
+
+    enum class FftKind
+    {
+        R2C,         // n reals -> n/2+1 complex
+        C2R,         // n/2+1 complex -> n reals (destroys its input)
+        C2CForward,
+        C2CBackward,
+    };
+
+    // -------------------------
+    // Process-wide FFTW plan cache
+    // -------------------------
+    // Plans are keyed by (kind, size, in-place, alignment of in/out) and created once, against
+    // scratch buffers, with the configured planner flags (FFTW_MEASURE unless changed). Callers then
+    // run them on their own buffers through the new-array execute functions, which FFTW allows from
+    // any thread as long as the buffers match the plan's alignment and in-placeness - hence the key.
+    // Plans live until the process exits.
+    //
+    // Double (fftw_*) and float (fftwf_*) plans are cached separately; pick one with the Real
+    // template argument. Wisdom is imported from disk on first use and written back by
+    // save_wisdom() when new plans were measured, so a size is only ever measured once per machine.
+    class FftwPlanCache
+    {
+    public:
+        static FftwPlanCache& instance();
+
+        FftwPlanCache(const FftwPlanCache&) = delete;
+        FftwPlanCache& operator=(const FftwPlanCache&) = delete;
+
+        static constexpr unsigned DEFAULT_FLAGS = ~0u;
+
+        // Plan usable with any in/out buffers that have the same alignment and aliasing as these.
+        template <typename Real = double>
+        typename FftwApi<Real>::Plan plan(FftKind kind, int n, const void* in, const void* out,
+            unsigned flags = DEFAULT_FLAGS)
+        {
+            return plan_many<Real>(kind, n, 1, in, out, flags);
+        }
+
+        // howmany transforms of size n stored back to back: complex arrays n/2+1 apart for R2C/C2R
+        // (n for C2C), real arrays n apart (2*(n/2+1) when in == out, FFTW's padded in-place layout).
+        // flags overrides the planner flags for this plan, e.g. FFTW_ESTIMATE for sizes that change
+        // from track to track and are not worth measuring.
+        template <typename Real = double>
+        typename FftwApi<Real>::Plan plan_many(FftKind kind, int n, int howmany, const void* in, const void* out,
+            unsigned flags = DEFAULT_FLAGS);
+
+        void r2c(int n, double* in, fftw_complex* out);
+        void r2c(int n, float* in, fftwf_complex* out);
+        void c2r(int n, fftw_complex* in, double* out);
+        void c2r(int n, fftwf_complex* in, float* out);
+        void c2c(int n, fftw_complex* in, fftw_complex* out, int sign); // FFTW_FORWARD / FFTW_BACKWARD
+        void c2c(int n, fftwf_complex* in, fftwf_complex* out, int sign);
+
+        // FFTW_ESTIMATE, FFTW_MEASURE or FFTW_PATIENT; applies to plans created afterwards.
+        void set_planner_flags(unsigned flags);
+        unsigned planner_flags() const;
+
+        // "estimate" / "measure" / "patient" -> flags; false for anything else.
+        static bool parse_planner_flags(const std::string& name, unsigned& flags);
+
+        // <temp>/waveOut/fftw.wisdom
+        static std::filesystem::path default_wisdom_path();
+        // Single-precision wisdom lives next to the double file: fftw.wisdom -> fftwf.wisdom.
+        static std::filesystem::path float_wisdom_path(const std::filesystem::path& path);
+
+        bool load_wisdom(const std::filesystem::path& path, std::string* errorMessage = nullptr);
+        // Only writes if plans were created since the last load/save.
+        bool save_wisdom(const std::filesystem::path& path = default_wisdom_path(), std::string* errorMessage = nullptr);
+
+        std::size_t size() const;
+
+    private:
+        FftwPlanCache();
+
+        using Key = std::tuple<int, int, int, bool, int, int, unsigned>; // kind, n, howmany, inPlace, alignIn, alignOut, flags
+
+        template <typename Real>
+        typename FftwApi<Real>::Plan create_plan(FftKind kind, int n, int howmany, bool inPlace, int alignIn, int alignOut, unsigned flags);
+        template <typename Real>
+        std::map<Key, typename FftwApi<Real>::Plan>& plan_map();
+
+        std::map<Key, fftw_plan> m_plans;
+        std::map<Key, fftwf_plan> m_plansF;
+        unsigned m_flags = FFTW_MEASURE;
+        bool m_dirty = false;
+    };
+
+    // -------------------------
+    // fftw_malloc'd buffer (SIMD aligned, so it always hits the alignment-0 plans; fine for float too)
+    // -------------------------
+    template <typename T>
+    class FftwBuffer
+    {
+    public:
+        FftwBuffer() = default;
+        explicit FftwBuffer(std::size_t count) { resize(count); }
+        ~FftwBuffer() { if (m_data) fftw_free(m_data); }
+
+        FftwBuffer(const FftwBuffer&) = delete;
+        FftwBuffer& operator=(const FftwBuffer&) = delete;
+
+        FftwBuffer(FftwBuffer&& other) noexcept : m_data(other.m_data), m_size(other.m_size)
+        {
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+        FftwBuffer& operator=(FftwBuffer&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (m_data) fftw_free(m_data);
+                m_data = other.m_data;
+                m_size = other.m_size;
+                other.m_data = nullptr;
+                other.m_size = 0;
+            }
+            return *this;
+        }
+
+        // Contents are not preserved.
+        void resize(std::size_t count)
+        {
+            if (count == m_size) return;
+            if (m_data) fftw_free(m_data);
+            m_data = count ? static_cast<T*>(fftw_malloc(sizeof(T) * count)) : nullptr;
+            m_size = m_data ? count : 0;
+        }
+
+        T* data() { return m_data; }
+        const T* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+        T& operator[](std::size_t i) { return m_data[i]; }
+        const T& operator[](std::size_t i) const { return m_data[i]; }
+
+    private:
+        T* m_data = nullptr;
+        std::size_t m_size = 0;
+    };
+}
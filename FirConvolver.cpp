@@ -0,0 +1,334 @@
+// FirConvolver.cpp
+#include "FirConvolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "DSP.h"
+#include "FftwPlanCache.h"
+#include "Profiler.h"
+
+namespace dsp
+{
+    static constexpr double FIR_PI = 3.141592653589793238462643383279502884;
+
+    static int next_pow2(int n)
+    {
+        int p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    // -------------------------
+    // FIR design
+    // -------------------------
+    int fir_taps_for_transition(double sampleRate, double transitionHz, int maxTaps)
+    {
+        if (sampleRate <= 0.0 || transitionHz <= 0.0) return 3;
+        // Blackman: transition width ~ 5.5 * fs / taps.
+        double t = std::ceil(5.5 * sampleRate / transitionHz);
+        int taps = (int)(std::min)(t, (double)(std::max)(3, maxTaps));
+        if ((taps & 1) == 0) ++taps;
+        if (taps > maxTaps && maxTaps >= 3) taps -= 2;
+        return (std::max)(3, taps);
+    }
+
+    std::vector<double> design_lowpass_fir(double sampleRate, double cutoffHz, int taps)
+    {
+        if (taps < 1) taps = 1;
+        if ((taps & 1) == 0) ++taps;
+
+        std::vector<double> h((std::size_t)taps, 0.0);
+        if (sampleRate <= 0.0) { h[(std::size_t)taps / 2] = 1.0; return h; }
+
+        const double fc = clamp(cutoffHz / sampleRate, 0.0, 0.5); // cycles/sample
+        const int M = taps / 2;
+        double sum = 0.0;
+        for (int n = 0; n < taps; ++n)
+        {
+            const int k = n - M;
+            const double ideal = (k == 0) ? 2.0 * fc : std::sin(2.0 * FIR_PI * fc * (double)k) / (FIR_PI * (double)k);
+            const double w = (taps == 1) ? 1.0
+                : 0.42 - 0.5 * std::cos(2.0 * FIR_PI * (double)n / (double)(taps - 1))
+                       + 0.08 * std::cos(4.0 * FIR_PI * (double)n / (double)(taps - 1));
+            h[(std::size_t)n] = ideal * w;
+            sum += h[(std::size_t)n];
+        }
+        if (std::fabs(sum) > 1e-12)
+        {
+            for (double& v : h) v /= sum;
+        }
+        return h;
+    }
+
+    std::vector<double> design_highpass_fir(double sampleRate, double cutoffHz, int taps)
+    {
+        std::vector<double> h = design_lowpass_fir(sampleRate, cutoffHz, taps);
+        for (double& v : h) v = -v;
+        h[h.size() / 2] += 1.0;
+        return h;
+    }
+
+    // -------------------------
+    // OverlapSaveConvolver
+    // -------------------------
+    template <typename Real>
+    BasicOverlapSaveConvolver<Real>::~BasicOverlapSaveConvolver()
+    {
+        destroy();
+    }
+
+    template <typename Real>
+    BasicOverlapSaveConvolver<Real>::BasicOverlapSaveConvolver(BasicOverlapSaveConvolver&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    template <typename Real>
+    BasicOverlapSaveConvolver<Real>& BasicOverlapSaveConvolver<Real>::operator=(BasicOverlapSaveConvolver&& other) noexcept
+    {
+        if (this == &other) return *this;
+
+        destroy();
+
+        m_taps = other.m_taps;
+        m_nfft = other.m_nfft;
+        m_hop = other.m_hop;
+        m_fill = other.m_fill;
+        m_block = other.m_block;
+        m_result = other.m_result;
+        m_spec = other.m_spec;
+        m_work = other.m_work;
+        m_kernels = std::move(other.m_kernels);
+        m_fwd = other.m_fwd;
+        m_inv = other.m_inv;
+
+        other.m_taps = other.m_nfft = other.m_hop = 0;
+        other.m_fill = 0;
+        other.m_block = other.m_result = nullptr;
+        other.m_spec = other.m_work = nullptr;
+        other.m_kernels.clear();
+        other.m_fwd = other.m_inv = nullptr;
+
+        return *this;
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::init(const std::vector<double>& kernel, int fftSize)
+    {
+        init_bank(std::vector<std::vector<double>>{ kernel }, fftSize);
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::init_bank(const std::vector<std::vector<double>>& kernels, int fftSize)
+    {
+        destroy();
+        if (kernels.empty() || kernels[0].empty()) return;
+        for (const auto& k : kernels)
+        {
+            if (k.size() != kernels[0].size()) return;
+        }
+
+        m_taps = (int)kernels[0].size();
+        const int minSize = (fftSize > 0) ? (std::max)(fftSize, 2 * m_taps) : (std::max)(1024, 4 * m_taps);
+        m_nfft = next_pow2(minSize);
+        m_hop = m_nfft - m_taps + 1;
+
+        const std::size_t bins = (std::size_t)m_nfft / 2 + 1;
+        m_block = (Real*)fftw_malloc(sizeof(Real) * (std::size_t)m_nfft);
+        m_result = (Real*)fftw_malloc(sizeof(Real) * (std::size_t)m_nfft);
+        m_spec = (Complex*)fftw_malloc(sizeof(Complex) * bins);
+        m_work = (Complex*)fftw_malloc(sizeof(Complex) * bins);
+        WAVEOUT_PROFILE_BYTES(sizeof(Real) * 2 * (std::size_t)m_nfft + sizeof(Complex) * (2 + kernels.size()) * bins);
+
+        FftwPlanCache& plans = FftwPlanCache::instance();
+        m_fwd = plans.plan<Real>(FftKind::R2C, m_nfft, m_block, m_spec);
+        m_inv = plans.plan<Real>(FftKind::C2R, m_nfft, m_work, m_result);
+
+        // Kernel spectra, with the 1/N of the unnormalized inverse folded in. They are computed in
+        // double whatever Real is, so a float convolver only rounds each kernel bin once.
+        const double scale = 1.0 / (double)m_nfft;
+        FftwBuffer<double> kernelBlock((std::size_t)m_nfft);
+        FftwBuffer<fftw_complex> kernelSpec(bins);
+        for (const auto& kernel : kernels)
+        {
+            std::fill(kernelBlock.data(), kernelBlock.data() + m_nfft, 0.0);
+            std::copy(kernel.begin(), kernel.end(), kernelBlock.data());
+            FftwPlanCache::instance().r2c(m_nfft, kernelBlock.data(), kernelSpec.data());
+            Complex* K = (Complex*)fftw_malloc(sizeof(Complex) * bins);
+            for (std::size_t k = 0; k < bins; ++k)
+            {
+                K[k][0] = (Real)(kernelSpec[k][0] * scale);
+                K[k][1] = (Real)(kernelSpec[k][1] * scale);
+            }
+            m_kernels.push_back(K);
+        }
+
+        reset();
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::destroy()
+    {
+        m_fwd = nullptr; // plans are owned by FftwPlanCache
+        m_inv = nullptr;
+        for (Complex* K : m_kernels) fftw_free(K);
+        m_kernels.clear();
+        if (m_work) { fftw_free(m_work); m_work = nullptr; }
+        if (m_spec) { fftw_free(m_spec); m_spec = nullptr; }
+        if (m_result) { fftw_free(m_result); m_result = nullptr; }
+        if (m_block) { fftw_free(m_block); m_block = nullptr; }
+        m_taps = m_nfft = m_hop = 0;
+        m_fill = 0;
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::reset()
+    {
+        if (m_block) std::memset(m_block, 0, sizeof(Real) * (std::size_t)m_nfft);
+        m_fill = 0;
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::run_block(std::size_t emit, std::vector<Real>* outs)
+    {
+        FftwApi<Real>::execute_r2c(m_fwd, m_block, m_spec);
+
+        const std::size_t bins = (std::size_t)m_nfft / 2 + 1;
+        for (std::size_t b = 0; b < m_kernels.size(); ++b)
+        {
+            const Complex* K = m_kernels[b];
+            for (std::size_t k = 0; k < bins; ++k)
+            {
+                m_work[k][0] = m_spec[k][0] * K[k][0] - m_spec[k][1] * K[k][1];
+                m_work[k][1] = m_spec[k][0] * K[k][1] + m_spec[k][1] * K[k][0];
+            }
+            FftwApi<Real>::execute_c2r(m_inv, m_work, m_result);
+
+            // The first taps-1 results are circularly aliased; the rest are the linear convolution.
+            const Real* valid = m_result + (m_taps - 1);
+            outs[b].insert(outs[b].end(), valid, valid + emit);
+        }
+
+        // Slide: the last taps-1 inputs become the next block's history.
+        std::memmove(m_block, m_block + m_hop, sizeof(Real) * (std::size_t)(m_taps - 1));
+        m_fill = 0;
+    }
+
+    template <typename Real>
+    template <typename Sample>
+    void BasicOverlapSaveConvolver<Real>::push(const Sample* in, std::size_t count, std::size_t stride, std::vector<Real>* outs)
+    {
+        if (!valid() || !in) return;
+
+        Real* dst = m_block + (m_taps - 1);
+        std::size_t i = 0;
+        while (i < count)
+        {
+            const std::size_t n = (std::min)(count - i, (std::size_t)m_hop - m_fill);
+            for (std::size_t j = 0; j < n; ++j)
+                dst[m_fill + j] = (Real)in[(i + j) * stride];
+            m_fill += n;
+            i += n;
+            if (m_fill == (std::size_t)m_hop)
+                run_block((std::size_t)m_hop, outs);
+        }
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::process(const Real* in, std::size_t count, std::vector<Real>& out)
+    {
+        if (m_kernels.size() == 1) push(in, count, 1, &out);
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::process(const short* in, std::size_t count, std::size_t stride, std::vector<Real>& out)
+    {
+        if (m_kernels.size() == 1) push(in, count, stride, &out);
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::process_bank(const short* in, std::size_t count, std::size_t stride, std::vector<Real>* outs)
+    {
+        push(in, count, stride, outs);
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::flush(std::vector<Real>& out)
+    {
+        if (m_kernels.size() == 1) flush_bank(&out);
+    }
+
+    template <typename Real>
+    void BasicOverlapSaveConvolver<Real>::flush_bank(std::vector<Real>* outs)
+    {
+        if (!valid()) return;
+
+        std::size_t need = m_fill + (std::size_t)(m_taps - 1);
+        while (need > 0)
+        {
+            Real* tail = m_block + (m_taps - 1) + m_fill;
+            std::memset(tail, 0, sizeof(Real) * ((std::size_t)m_hop - m_fill));
+            const std::size_t emit = (std::min)(need, (std::size_t)m_hop);
+            run_block(emit, outs);
+            need -= emit;
+        }
+        reset();
+    }
+
+    template <typename Real>
+    void fir_filter_aligned(BasicOverlapSaveConvolver<Real>& conv, const short* src, std::size_t frames,
+        std::size_t srcStride, float* dst)
+    {
+        if (conv.kernel_count() != 1) return;
+        fir_filter_bank_aligned(conv, src, frames, srcStride, &dst);
+    }
+
+    template <typename Real>
+    void fir_filter_bank_aligned(BasicOverlapSaveConvolver<Real>& conv, const short* src, std::size_t frames,
+        std::size_t srcStride, float* const* dst)
+    {
+        WAVEOUT_PROFILE_SCOPE("dsp.firFilterAligned");
+        if (!conv.valid() || !src || !dst || frames == 0) return;
+
+        conv.reset();
+        const std::size_t bands = (std::size_t)conv.kernel_count();
+        const std::size_t delay = (std::size_t)conv.groupDelay();
+        const std::size_t hop = (std::size_t)conv.hopSize();
+
+        std::vector<std::vector<Real>> produced(bands);
+        for (auto& p : produced) p.reserve(hop + (std::size_t)conv.taps());
+        std::size_t emitted = 0; // causal outputs seen so far (per kernel)
+        std::size_t written = 0; // aligned outputs stored in each dst[k]
+
+        auto drain = [&]() {
+            const std::size_t n = produced[0].size();
+            for (std::size_t i = 0; i < n; ++i, ++emitted)
+            {
+                if (emitted < delay || written >= frames) continue;
+                for (std::size_t b = 0; b < bands; ++b)
+                    dst[b][written] = (float)produced[b][i];
+                ++written;
+            }
+            for (auto& p : produced) p.clear();
+        };
+
+        for (std::size_t pos = 0; pos < frames; pos += hop)
+        {
+            const std::size_t n = (std::min)(hop, frames - pos);
+            conv.process_bank(src + pos * srcStride, n, srcStride, produced.data());
+            drain();
+        }
+        conv.flush_bank(produced.data());
+        drain();
+    }
+
+    template class BasicOverlapSaveConvolver<double>;
+    template class BasicOverlapSaveConvolver<float>;
+    template void fir_filter_aligned(OverlapSaveConvolver&, const short*, std::size_t, std::size_t, float*);
+    template void fir_filter_aligned(OverlapSaveConvolverF&, const short*, std::size_t, std::size_t, float*);
+    template void fir_filter_bank_aligned(OverlapSaveConvolver&, const short*, std::size_t, std::size_t, float* const*);
+    template void fir_filter_bank_aligned(OverlapSaveConvolverF&, const short*, std::size_t, std::size_t, float* const*);
+}
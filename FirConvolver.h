@@ -0,0 +1,121 @@
+// FirConvolver.h
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <fftw3.h>
+
+#include "FftwPlanCache.h"
+
+namespace dsp
+{
+    // -------------------------
+    // Windowed-sinc FIR design (Blackman window, linear phase, odd length)
+    // -------------------------
+
+    // Odd tap count whose Blackman transition band is about transitionHz wide, capped at maxTaps.
+    int fir_taps_for_transition(double sampleRate, double transitionHz, int maxTaps = 16383);
+
+    // Unity gain at DC.
+    std::vector<double> design_lowpass_fir(double sampleRate, double cutoffHz, int taps);
+
+    // Spectral inversion of the low-pass; unity gain at Nyquist.
+    std::vector<double> design_highpass_fir(double sampleRate, double cutoffHz, int taps);
+
+    // -------------------------
+    // Overlap-save FFT convolver
+    // -------------------------
+    // Convolves a stream with a fixed FIR kernel in blocks of fftSize using real FFTs. Each block
+    // keeps taps-1 samples of history and yields hopSize() = fftSize - taps + 1 new outputs, so the
+    // cost is O(n log fftSize) and the working memory is O(fftSize) regardless of input length.
+    //
+    // The output is the plain causal convolution y[n] = sum_k h[k] x[n-k]; for a linear-phase
+    // kernel it lags the input by groupDelay() samples. Outputs are released a hop at a time, and
+    // output n is only released after input n has been consumed, so filtering a buffer in place is
+    // safe.
+    //
+    // A convolver can also hold a bank of equal-length kernels (init_bank). Each block is then
+    // transformed forward once and multiplied/inverted per kernel, which is how BandSplitter gets
+    // all of its bands out of a single pass over the input.
+    //
+    // Real picks the FFT precision (fftw_* for double, fftwf_* for float); kernels are always
+    // designed in double and rounded once when their spectra are stored.
+    template <typename Real>
+    class BasicOverlapSaveConvolver
+    {
+    public:
+        using Complex = typename FftwApi<Real>::Complex;
+
+        BasicOverlapSaveConvolver() = default;
+        explicit BasicOverlapSaveConvolver(const std::vector<double>& kernel, int fftSize = 0) { init(kernel, fftSize); }
+        ~BasicOverlapSaveConvolver();
+
+        BasicOverlapSaveConvolver(const BasicOverlapSaveConvolver&) = delete;
+        BasicOverlapSaveConvolver& operator=(const BasicOverlapSaveConvolver&) = delete;
+
+        BasicOverlapSaveConvolver(BasicOverlapSaveConvolver&& other) noexcept;
+        BasicOverlapSaveConvolver& operator=(BasicOverlapSaveConvolver&& other) noexcept;
+
+        // fftSize 0 picks the smallest power of two >= 4 * taps (at least 1024). An explicit
+        // fftSize is rounded up to a power of two and to at least 2 * taps.
+        void init(const std::vector<double>& kernel, int fftSize = 0);
+        // All kernels must have the same length; an empty or ragged bank leaves the convolver invalid.
+        void init_bank(const std::vector<std::vector<double>>& kernels, int fftSize = 0);
+        void destroy();
+
+        // Forget the stream history (keeps kernels and plans).
+        void reset();
+
+        bool valid() const { return m_fwd != nullptr; }
+        int kernel_count() const { return (int)m_kernels.size(); }
+        int taps() const { return m_taps; }
+        int fftSize() const { return m_nfft; }
+        int hopSize() const { return m_hop; }
+        int groupDelay() const { return (m_taps - 1) / 2; }
+
+        // Single-kernel convolvers: consume count samples and append every output that became
+        // available to out.
+        void process(const Real* in, std::size_t count, std::vector<Real>& out);
+        void process(const short* in, std::size_t count, std::size_t stride, std::vector<Real>& out);
+
+        // Any convolver: outs points at kernel_count() vectors, one per kernel.
+        void process_bank(const short* in, std::size_t count, std::size_t stride, std::vector<Real>* outs);
+
+        // Zero-pad the stream so all remaining outputs (including the kernel tail of taps-1
+        // samples) are appended, then reset().
+        void flush(std::vector<Real>& out);
+        void flush_bank(std::vector<Real>* outs);
+
+    private:
+        template <typename Sample>
+        void push(const Sample* in, std::size_t count, std::size_t stride, std::vector<Real>* outs);
+        void run_block(std::size_t emit, std::vector<Real>* outs);
+
+        int m_taps = 0;
+        int m_nfft = 0;
+        int m_hop = 0;
+        std::size_t m_fill = 0;           // new samples in the current block
+
+        Real* m_block = nullptr;          // [taps-1 history | hop new samples]
+        Real* m_result = nullptr;         // inverse transform of one block
+        Complex* m_spec = nullptr;        // forward transform of the block, nfft/2 + 1
+        Complex* m_work = nullptr;        // spectrum times one kernel (consumed by the inverse)
+        std::vector<Complex*> m_kernels;  // kernel spectra, pre-scaled by 1/nfft
+        typename FftwApi<Real>::Plan m_fwd = nullptr;
+        typename FftwApi<Real>::Plan m_inv = nullptr;
+    };
+
+    using OverlapSaveConvolver = BasicOverlapSaveConvolver<double>;
+    using OverlapSaveConvolverF = BasicOverlapSaveConvolver<float>;
+
+    // Filter one channel (frames samples, stride apart) and return it aligned with the input: the
+    // kernel's group delay is removed and the result has exactly `frames` samples.
+    template <typename Real>
+    void fir_filter_aligned(BasicOverlapSaveConvolver<Real>& conv, const short* src, std::size_t frames,
+        std::size_t srcStride, float* dst);
+
+    // Same for every kernel of a bank: dst[k] receives the aligned output of kernel k.
+    template <typename Real>
+    void fir_filter_bank_aligned(BasicOverlapSaveConvolver<Real>& conv, const short* src, std::size_t frames,
+        std::size_t srcStride, float* const* dst);
+}
@@ -0,0 +1,407 @@
+// FirFilter.cpp
+#include "FirFilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "FirConvolver.h"
+#include "Profiler.h"
+#include "TaskGraph.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WAVEOUT_FIR_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define WAVEOUT_FIR_NEON 1
+#include <arm_neon.h>
+#endif
+
+// MSVC accepts AVX2 intrinsics in any function; GCC/Clang need the target enabled per function.
+#if defined(WAVEOUT_FIR_X86) && !defined(_MSC_VER)
+#define WAVEOUT_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define WAVEOUT_TARGET_AVX2
+#endif
+
+namespace dsp
+{
+    namespace
+    {
+        // Direct-form kernels compute outputs [0, valid) for one channel (Pair == false) or two
+        // channels that share the coefficient stream (Pair == true), and return how many they
+        // did; the scalar loop finishes the remainder.
+        using DirectFn = std::size_t(*)(const float* h, int taps, const float* a, const float* b, std::size_t valid,
+            double* outA, std::size_t strideA, double* outB, std::size_t strideB);
+
+        inline void store_lanes(const float* lanes, int count, double* out, std::size_t stride)
+        {
+            for (int k = 0; k < count; ++k)
+                out[(std::size_t)k * stride] = (double)lanes[k];
+        }
+
+        template <bool Pair>
+        std::size_t direct_scalar(const float* h, int taps, const float* a, const float* b, std::size_t valid,
+            double* outA, std::size_t strideA, double* outB, std::size_t strideB)
+        {
+            for (std::size_t i = 0; i < valid; ++i)
+            {
+                float accA = 0.0f;
+                float accB = 0.0f;
+                for (int j = 0; j < taps; ++j)
+                {
+                    accA += h[j] * a[i + (std::size_t)j];
+                    if (Pair) accB += h[j] * b[i + (std::size_t)j];
+                }
+                outA[i * strideA] = (double)accA;
+                if (Pair) outB[i * strideB] = (double)accB;
+            }
+            return valid;
+        }
+
+#if defined(WAVEOUT_FIR_X86)
+        template <bool Pair>
+        WAVEOUT_TARGET_AVX2 std::size_t direct_avx2(const float* h, int taps, const float* a, const float* b, std::size_t valid,
+            double* outA, std::size_t strideA, double* outB, std::size_t strideB)
+        {
+            alignas(32) float lanes[8];
+            std::size_t i = 0;
+            // 16 outputs per channel per pass: two independent FMA chains each.
+            for (; i + 16 <= valid; i += 16)
+            {
+                __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+                __m256 b0 = _mm256_setzero_ps(), b1 = _mm256_setzero_ps();
+                for (int j = 0; j < taps; ++j)
+                {
+                    const __m256 hv = _mm256_broadcast_ss(h + j);
+                    const float* pa = a + i + (std::size_t)j;
+                    a0 = _mm256_fmadd_ps(hv, _mm256_loadu_ps(pa), a0);
+                    a1 = _mm256_fmadd_ps(hv, _mm256_loadu_ps(pa + 8), a1);
+                    if (Pair)
+                    {
+                        const float* pb = b + i + (std::size_t)j;
+                        b0 = _mm256_fmadd_ps(hv, _mm256_loadu_ps(pb), b0);
+                        b1 = _mm256_fmadd_ps(hv, _mm256_loadu_ps(pb + 8), b1);
+                    }
+                }
+                _mm256_store_ps(lanes, a0); store_lanes(lanes, 8, outA + i * strideA, strideA);
+                _mm256_store_ps(lanes, a1); store_lanes(lanes, 8, outA + (i + 8) * strideA, strideA);
+                if (Pair)
+                {
+                    _mm256_store_ps(lanes, b0); store_lanes(lanes, 8, outB + i * strideB, strideB);
+                    _mm256_store_ps(lanes, b1); store_lanes(lanes, 8, outB + (i + 8) * strideB, strideB);
+                }
+            }
+            for (; i + 8 <= valid; i += 8)
+            {
+                __m256 a0 = _mm256_setzero_ps();
+                __m256 b0 = _mm256_setzero_ps();
+                for (int j = 0; j < taps; ++j)
+                {
+                    const __m256 hv = _mm256_broadcast_ss(h + j);
+                    a0 = _mm256_fmadd_ps(hv, _mm256_loadu_ps(a + i + (std::size_t)j), a0);
+                    if (Pair) b0 = _mm256_fmadd_ps(hv, _mm256_loadu_ps(b + i + (std::size_t)j), b0);
+                }
+                _mm256_store_ps(lanes, a0); store_lanes(lanes, 8, outA + i * strideA, strideA);
+                if (Pair) { _mm256_store_ps(lanes, b0); store_lanes(lanes, 8, outB + i * strideB, strideB); }
+            }
+            return i;
+        }
+
+        template <bool Pair>
+        std::size_t direct_sse2(const float* h, int taps, const float* a, const float* b, std::size_t valid,
+            double* outA, std::size_t strideA, double* outB, std::size_t strideB)
+        {
+            alignas(16) float lanes[4];
+            std::size_t i = 0;
+            for (; i + 8 <= valid; i += 8)
+            {
+                __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+                __m128 b0 = _mm_setzero_ps(), b1 = _mm_setzero_ps();
+                for (int j = 0; j < taps; ++j)
+                {
+                    const __m128 hv = _mm_set1_ps(h[j]);
+                    const float* pa = a + i + (std::size_t)j;
+                    a0 = _mm_add_ps(a0, _mm_mul_ps(hv, _mm_loadu_ps(pa)));
+                    a1 = _mm_add_ps(a1, _mm_mul_ps(hv, _mm_loadu_ps(pa + 4)));
+                    if (Pair)
+                    {
+                        const float* pb = b + i + (std::size_t)j;
+                        b0 = _mm_add_ps(b0, _mm_mul_ps(hv, _mm_loadu_ps(pb)));
+                        b1 = _mm_add_ps(b1, _mm_mul_ps(hv, _mm_loadu_ps(pb + 4)));
+                    }
+                }
+                _mm_store_ps(lanes, a0); store_lanes(lanes, 4, outA + i * strideA, strideA);
+                _mm_store_ps(lanes, a1); store_lanes(lanes, 4, outA + (i + 4) * strideA, strideA);
+                if (Pair)
+                {
+                    _mm_store_ps(lanes, b0); store_lanes(lanes, 4, outB + i * strideB, strideB);
+                    _mm_store_ps(lanes, b1); store_lanes(lanes, 4, outB + (i + 4) * strideB, strideB);
+                }
+            }
+            return i;
+        }
+
+        bool cpu_has_avx2_fma()
+        {
+#if defined(_MSC_VER)
+            int r[4];
+            __cpuid(r, 0);
+            if (r[0] < 7) return false;
+            __cpuid(r, 1);
+            const bool fma = (r[2] & (1 << 12)) != 0;
+            const bool osxsave = (r[2] & (1 << 27)) != 0;
+            const bool avx = (r[2] & (1 << 28)) != 0;
+            if (!fma || !osxsave || !avx) return false;
+            if ((_xgetbv(0) & 6) != 6) return false; // OS saves YMM state
+            __cpuidex(r, 7, 0);
+            return (r[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+        }
+#endif
+
+#if defined(WAVEOUT_FIR_NEON)
+        template <bool Pair>
+        std::size_t direct_neon(const float* h, int taps, const float* a, const float* b, std::size_t valid,
+            double* outA, std::size_t strideA, double* outB, std::size_t strideB)
+        {
+            float lanes[4];
+            std::size_t i = 0;
+            for (; i + 8 <= valid; i += 8)
+            {
+                float32x4_t a0 = vdupq_n_f32(0.0f), a1 = vdupq_n_f32(0.0f);
+                float32x4_t b0 = vdupq_n_f32(0.0f), b1 = vdupq_n_f32(0.0f);
+                for (int j = 0; j < taps; ++j)
+                {
+                    const float* pa = a + i + (std::size_t)j;
+                    a0 = vmlaq_n_f32(a0, vld1q_f32(pa), h[j]);
+                    a1 = vmlaq_n_f32(a1, vld1q_f32(pa + 4), h[j]);
+                    if (Pair)
+                    {
+                        const float* pb = b + i + (std::size_t)j;
+                        b0 = vmlaq_n_f32(b0, vld1q_f32(pb), h[j]);
+                        b1 = vmlaq_n_f32(b1, vld1q_f32(pb + 4), h[j]);
+                    }
+                }
+                vst1q_f32(lanes, a0); store_lanes(lanes, 4, outA + i * strideA, strideA);
+                vst1q_f32(lanes, a1); store_lanes(lanes, 4, outA + (i + 4) * strideA, strideA);
+                if (Pair)
+                {
+                    vst1q_f32(lanes, b0); store_lanes(lanes, 4, outB + i * strideB, strideB);
+                    vst1q_f32(lanes, b1); store_lanes(lanes, 4, outB + (i + 4) * strideB, strideB);
+                }
+            }
+            return i;
+        }
+#endif
+
+        struct DirectKernels
+        {
+            DirectFn single;
+            DirectFn pair;
+            const char* name;
+        };
+
+        const DirectKernels& direct_kernels()
+        {
+            static const DirectKernels kernels = []() {
+#if defined(WAVEOUT_FIR_X86)
+                if (cpu_has_avx2_fma())
+                    return DirectKernels{ &direct_avx2<false>, &direct_avx2<true>, "avx2" };
+                return DirectKernels{ &direct_sse2<false>, &direct_sse2<true>, "sse2" };
+#elif defined(WAVEOUT_FIR_NEON)
+                return DirectKernels{ &direct_neon<false>, &direct_neon<true>, "neon" };
+#else
+                return DirectKernels{ &direct_scalar<false>, &direct_scalar<true>, "scalar" };
+#endif
+            }();
+            return kernels;
+        }
+
+        std::size_t valid_outputs(std::size_t frames, int taps)
+        {
+            return (frames + 1 > (std::size_t)taps) ? frames + 1 - (std::size_t)taps : 0;
+        }
+
+        void zero_tail(const FirChannel& ch, std::size_t valid)
+        {
+            for (std::size_t i = valid; i < ch.in.Frames(); ++i)
+                ch.out[i * ch.outStride] = 0.0;
+        }
+
+        void run_direct(const FirChannel* channels, int channelCount, const std::vector<double>& h)
+        {
+            WAVEOUT_PROFILE_SCOPE("dsp.firDirect");
+            const int taps = (int)h.size();
+            const std::vector<float> hf(h.begin(), h.end());
+            const DirectKernels& k = direct_kernels();
+
+            std::vector<float> bufA;
+            std::vector<float> bufB;
+            for (int c = 0; c < channelCount;)
+            {
+                const FirChannel& A = channels[c];
+                const bool pair = c + 1 < channelCount && channels[c + 1].in.Frames() == A.in.Frames();
+                const std::size_t frames = A.in.Frames();
+                const std::size_t valid = valid_outputs(frames, taps);
+
+                bufA.resize(frames);
+                A.in.CopyChannel(0, bufA.data());
+                if (pair)
+                {
+                    const FirChannel& B = channels[c + 1];
+                    bufB.resize(frames);
+                    B.in.CopyChannel(0, bufB.data());
+                    const std::size_t done = k.pair(hf.data(), taps, bufA.data(), bufB.data(), valid, A.out, A.outStride, B.out, B.outStride);
+                    direct_scalar<true>(hf.data(), taps, bufA.data() + done, bufB.data() + done, valid - done,
+                        A.out + done * A.outStride, A.outStride, B.out + done * B.outStride, B.outStride);
+                    zero_tail(B, valid);
+                }
+                else
+                {
+                    const std::size_t done = k.single(hf.data(), taps, bufA.data(), nullptr, valid, A.out, A.outStride, nullptr, 0);
+                    direct_scalar<false>(hf.data(), taps, bufA.data() + done, nullptr, valid - done,
+                        A.out + done * A.outStride, A.outStride, nullptr, 0);
+                }
+                zero_tail(A, valid);
+                c += pair ? 2 : 1;
+            }
+        }
+
+        void run_fft(const FirChannel* channels, int channelCount, const std::vector<double>& h)
+        {
+            WAVEOUT_PROFILE_SCOPE("dsp.firFft");
+            const std::size_t taps = h.size();
+            // Correlation with h is convolution with h reversed, delayed by taps-1.
+            OverlapSaveConvolver conv(std::vector<double>(h.rbegin(), h.rend()));
+            const std::size_t hop = (std::size_t)conv.hopSize();
+
+            std::vector<double> produced;
+            for (int c = 0; c < channelCount; ++c)
+            {
+                const FirChannel& ch = channels[c];
+                const std::size_t frames = ch.in.Frames();
+                const std::size_t valid = valid_outputs(frames, (int)taps);
+                zero_tail(ch, valid);
+                if (valid == 0) continue;
+
+                conv.reset();
+                std::size_t emitted = 0;
+                auto drain = [&]() {
+                    for (double z : produced)
+                    {
+                        if (emitted >= taps - 1 && emitted - (taps - 1) < valid)
+                            ch.out[(emitted - (taps - 1)) * ch.outStride] = z;
+                        ++emitted;
+                    }
+                    produced.clear();
+                };
+                for (std::size_t pos = 0; pos < frames; pos += hop)
+                {
+                    const std::size_t n = (std::min)(hop, frames - pos);
+                    conv.process(ch.in.data() + pos * ch.in.Stride(), n, ch.in.Stride(), produced);
+                    drain();
+                }
+                conv.flush(produced);
+                drain();
+            }
+        }
+
+        int measure_crossover()
+        {
+            const std::size_t frames = std::size_t(1) << 15;
+            std::vector<short> pcm(frames * 2);
+            std::uint32_t seed = 0x12345678u;
+            for (short& s : pcm)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                s = (short)(seed >> 16);
+            }
+            const audiofile::AudioView view = audiofile::AudioView::Interleaved(pcm, 2);
+            std::vector<double> out(frames * 2);
+
+            auto bestOf2 = [&](const std::vector<double>& h, FirMethod m) {
+                double best = 1e30;
+                for (int rep = 0; rep < 2; ++rep)
+                {
+                    const auto t0 = std::chrono::steady_clock::now();
+                    fir_correlate_valid(view, h, out.data(), m);
+                    best = (std::min)(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+                }
+                return best;
+            };
+
+            for (int taps = 8; taps <= 1024; taps *= 2)
+            {
+                const std::vector<double> h((std::size_t)taps, 1.0 / taps);
+                if (bestOf2(h, FirMethod::Fft) < bestOf2(h, FirMethod::Direct))
+                    return taps;
+            }
+            return 2048;
+        }
+    }
+
+    void fir_correlate_valid(const FirChannel* channels, int channelCount, const std::vector<double>& h, FirMethod method,
+        threading::WorkerPool* pool)
+    {
+        if (!channels || channelCount <= 0 || h.empty()) return;
+
+        if (method == FirMethod::Auto)
+            method = ((int)h.size() >= fir_fft_crossover_taps()) ? FirMethod::Fft : FirMethod::Direct;
+
+        auto run = [&h, method](const FirChannel* first, int count) {
+            if (method == FirMethod::Fft)
+                run_fft(first, count, h);
+            else
+                run_direct(first, count, h);
+        };
+
+        if (!pool || channelCount == 1)
+        {
+            run(channels, channelCount);
+            return;
+        }
+
+        // Channels write disjoint outputs and each task builds its own convolver/scratch.
+        threading::TaskGraph graph;
+        for (int c = 0; c < channelCount; ++c)
+            graph.Add("fir channel " + std::to_string(c), [&run, channels, c]() { run(channels + c, 1); });
+        graph.RunOrThrow(pool);
+    }
+
+    void fir_correlate_valid(const audiofile::AudioView& audio, const std::vector<double>& h, double* out, FirMethod method,
+        threading::WorkerPool* pool)
+    {
+        if (audio.empty() || !out) return;
+
+        const int channelCount = audio.Channels();
+        std::vector<FirChannel> channels((std::size_t)channelCount);
+        for (int c = 0; c < channelCount; ++c)
+        {
+            channels[(std::size_t)c].in = audio.Channel(c);
+            channels[(std::size_t)c].out = out + c;
+            channels[(std::size_t)c].outStride = (std::size_t)channelCount;
+        }
+        fir_correlate_valid(channels.data(), channelCount, h, method, pool);
+    }
+
+    int fir_fft_crossover_taps()
+    {
+        static const int crossover = measure_crossover();
+        return crossover;
+    }
+
+    const char* fir_direct_isa()
+    {
+        return direct_kernels().name;
+    }
+}
@@ -0,0 +1,56 @@
+// FirFilter.h
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "AudioView.h"
+
+namespace threading
+{
+    class WorkerPool;
+}
+
+namespace dsp
+{
+    // -------------------------
+    // Time-domain FIR for arbitrary kernels
+    // -------------------------
+    // Computes the "valid" correlation used by filter::yLapply_high_pass_filter:
+    //   y[i] = sum_j h[j] * x[i + j]   for i + taps <= frames, and 0 for the last taps-1 outputs.
+    //
+    // Short kernels run a direct-form loop vectorized over output samples (AVX2+FMA when the CPU
+    // has it, otherwise SSE2 / NEON / scalar), with two channels sharing every coefficient load.
+    // Long kernels go through OverlapSaveConvolver. Auto picks between them using a crossover
+    // measured once per process on this machine.
+    //
+    // With a pool the channels are filtered concurrently, one task each (the direct path then
+    // gives up sharing coefficient loads between channel pairs, which two cores more than repay).
+    enum class FirMethod
+    {
+        Auto,
+        Direct,
+        Fft,
+    };
+
+    struct FirChannel
+    {
+        audiofile::AudioView in;    // one channel (Channels() == 1), any stride
+        double* out = nullptr;      // in.Frames() outputs ...
+        std::size_t outStride = 1;  // ... this far apart
+    };
+
+    void fir_correlate_valid(const FirChannel* channels, int channelCount, const std::vector<double>& h,
+        FirMethod method = FirMethod::Auto, threading::WorkerPool* pool = nullptr);
+
+    // Every channel of an interleaved view; out holds Frames() * Channels() interleaved samples.
+    void fir_correlate_valid(const audiofile::AudioView& audio, const std::vector<double>& h, double* out,
+        FirMethod method = FirMethod::Auto, threading::WorkerPool* pool = nullptr);
+
+    // Smallest tap count at which the FFT path beat the direct path in a short timing run
+    // (measured on first use, then cached).
+    int fir_fft_crossover_taps();
+
+    // "avx2", "sse2", "neon" or "scalar": the direct-form kernel this machine runs.
+    const char* fir_direct_isa();
+}
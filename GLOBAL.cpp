@@ -4,24 +4,25 @@
 
 using namespace std;
 
-int GLOBAL::sampleRate = 0;
-float GLOBAL::qBeatDuration = 0;
-float GLOBAL::twoBeatDuration = 0;
-Key GLOBAL::MUSICAL_KEY = Key::NO_KEY;
-bool GLOBAL::isMonophonic = false;
-int GLOBAL::chordVoices = 0;
-float GLOBAL::SONG_LENGTH = 0;
-
-bool GLOBAL::Init()
+const vector<Keys>* GLOBAL::getScale(Key key)
 {
-    if (isMonophonic && chordVoices > 1)
-    {
-        return false;
-    }
-    else
+    switch (key)
     {
-        return true;
+    case Key::C_MAJOR: return &cMajor;
+    case Key::C_SHARP_MAJOR: return &cSharpMajor;
+    case Key::D_MAJOR: return &dMajor;
+    case Key::D_SHARP_MAJOR: return &dSharpMajor;
+    case Key::E_MAJOR: return &eMajor;
+    case Key::F_MAJOR: return &fMajor;
+    case Key::F_SHARP_MAJOR: return &fSharpMajor;
+    case Key::G_MAJOR: return &gMajor;
+    case Key::G_SHARP_MAJOR: return &gSharpMajor;
+    case Key::A_MAJOR: return &aMajor;
+    case Key::A_SHARP_MAJOR: return &aSharpMajor;
+    case Key::B_MAJOR: return &bMajor;
+    case Key::NO_KEY: break;
     }
+    return nullptr;
 }
 
 vector<Keys> GLOBAL::cMajor = {
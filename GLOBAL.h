@@ -4,15 +4,13 @@
 #include <string>
 #include <utility>
 
+#include "Keys.h"
+
+// Read-only lookup tables. Per-song settings (sample rate, beat durations, key, length)
+// live in analysis::AnalysisContext.
 class GLOBAL
 {
 public:
-	static float qBeatDuration;
-    static int sampleRate;
-	static float twoBeatDuration;
-	static Key MUSICAL_KEY;
-	static bool isMonophonic;
-	static int chordVoices;
 	static std::vector<Keys> cMajor;
 	static std::vector<Keys> cSharpMajor;
 	static std::vector<Keys> dMajor;
@@ -25,12 +23,12 @@ public:
 	static std::vector<Keys> aMajor;
 	static std::vector<Keys> aSharpMajor;
 	static std::vector<Keys> bMajor;
-	static float SONG_LENGTH;
 	static std::vector<std::pair<std::string, int>> keysString;
 
 	static std::vector<std::pair<std::string, int>> keyString;
 
-	static bool Init();
+	// Notes of the given major scale, or nullptr for Key::NO_KEY.
+	static const std::vector<Keys>* getScale(Key key);
 
 
 
@@ -1,4 +1,5 @@
 ﻿#include "KeyDetection.h"
+#include "Profiler.h"
 
 #include <fftw3.h>
 #include <cmath>
@@ -53,6 +54,7 @@ namespace KeyDetection {
 
     Key getKey(const std::vector<double>& pcmData, int sampleRate,  KeyFinder::KeyFinder& f)
     {
+        WAVEOUT_PROFILE_SCOPE("key.getKey");
         KeyFinder::AudioData a;
         a.setFrameRate(sampleRate);
         a.setChannels(1);
@@ -67,6 +69,34 @@ namespace KeyDetection {
         
     }
 
+    Key getKey(const audiofile::AudioView& audio, int sampleRate, KeyFinder::KeyFinder& f)
+    {
+        WAVEOUT_PROFILE_SCOPE("key.getKey");
+        KeyFinder::AudioData a;
+        a.setFrameRate(sampleRate);
+        a.setChannels(1);
+        a.addToSampleCount(static_cast<unsigned int>(audio.Frames()));
+        for (unsigned int i = 0; i < static_cast<unsigned int>(audio.Frames()); ++i) {
+            a.setSample(i, audio.Mono(i));
+        }
+        return mapKeyfinderToMajorKeyEnum(f.keyOfAudio(a));
+    }
+
+    Key getKey(const analysis::AnalysisSignal& signal, KeyFinder::KeyFinder& f)
+    {
+        WAVEOUT_PROFILE_SCOPE("key.getKey");
+        if (signal.empty()) return Key::NO_KEY;
+        KeyFinder::AudioData a;
+        a.setFrameRate(static_cast<unsigned int>(signal.sampleRate));
+        a.setChannels(1);
+        a.addToSampleCount(static_cast<unsigned int>(signal.CropSize()));
+        const float* mono = signal.CropData();
+        for (unsigned int i = 0; i < static_cast<unsigned int>(signal.CropSize()); ++i) {
+            a.setSample(i, mono[i]);
+        }
+        return mapKeyfinderToMajorKeyEnum(f.keyOfAudio(a));
+    }
+
  
  }
 
@@ -4,7 +4,14 @@
 #include <string>
 #include <keyfinder/keyfinder.h>
 #include "Keys.h"
+#include "AnalysisFrontEnd.h"
+#include "AudioView.h"
 namespace KeyDetection {
     Key getKey(const std::vector<double>& pcmData, int sampleRate, KeyFinder::KeyFinder& f);
+    // Reads a mono downmix of `audio` straight into libKeyFinder's buffer (no intermediate vectors).
+    Key getKey(const audiofile::AudioView& audio, int sampleRate, KeyFinder::KeyFinder& f);
+    // Runs on the front end's crop window at its (decimated) rate; libKeyFinder only looks below
+    // ~2 kHz, so an 11 kHz input gives the same chromagram for a quarter of its filtering work.
+    Key getKey(const analysis::AnalysisSignal& signal, KeyFinder::KeyFinder& f);
 
 } 
\ No newline at end of file
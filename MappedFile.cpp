@@ -0,0 +1,230 @@
+#include "MappedFile.h"
+
+#include <cstring>
+#include <sstream>
+#include <utility>
+#include <windows.h>
+
+namespace audiofile
+{
+    namespace
+    {
+        static void SetError(std::string* outErr, const std::string& msg)
+        {
+            if (outErr) *outErr = msg;
+        }
+
+        static inline unsigned int read_u32le(const std::uint8_t* p)
+        {
+            return (unsigned int)p[0] |
+                ((unsigned int)p[1] << 8) |
+                ((unsigned int)p[2] << 16) |
+                ((unsigned int)p[3] << 24);
+        }
+
+        static inline unsigned short read_u16le(const std::uint8_t* p)
+        {
+            return (unsigned short)(p[0] | (p[1] << 8));
+        }
+
+        constexpr unsigned short kWaveFormatPcm = 1;
+        constexpr unsigned short kWaveFormatExtensible = 0xFFFE;
+    }
+
+    // ---------------- MappedFile ----------------
+
+    MappedFile::MappedFile() = default;
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : m_file(other.m_file), m_mapping(other.m_mapping), m_data(other.m_data), m_size(other.m_size)
+    {
+        other.m_file = nullptr;
+        other.m_mapping = nullptr;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            std::swap(m_file, other.m_file);
+            std::swap(m_mapping, other.m_mapping);
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+        }
+        return *this;
+    }
+
+    bool MappedFile::Open(const std::filesystem::path& path, std::string* errorMessage)
+    {
+        Close();
+
+        HANDLE h = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (h == INVALID_HANDLE_VALUE)
+        {
+            std::ostringstream oss;
+            oss << "CreateFileW failed (" << GetLastError() << ") for: " << path.string();
+            SetError(errorMessage, oss.str());
+            return false;
+        }
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(h, &size) || size.QuadPart <= 0)
+        {
+            CloseHandle(h);
+            SetError(errorMessage, "File is empty or its size could not be read: " + path.string());
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingW(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            std::ostringstream oss;
+            oss << "CreateFileMappingW failed (" << GetLastError() << ") for: " << path.string();
+            CloseHandle(h);
+            SetError(errorMessage, oss.str());
+            return false;
+        }
+
+        const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view)
+        {
+            std::ostringstream oss;
+            oss << "MapViewOfFile failed (" << GetLastError() << ") for: " << path.string();
+            CloseHandle(mapping);
+            CloseHandle(h);
+            SetError(errorMessage, oss.str());
+            return false;
+        }
+
+        m_file = h;
+        m_mapping = mapping;
+        m_data = static_cast<const std::uint8_t*>(view);
+        m_size = static_cast<std::size_t>(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(static_cast<HANDLE>(m_mapping));
+        if (m_file)
+            CloseHandle(static_cast<HANDLE>(m_file));
+        m_file = nullptr;
+        m_mapping = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    // ---------------- MappedWavFile ----------------
+
+    bool MappedWavFile::Open(const std::filesystem::path& path, std::string* errorMessage)
+    {
+        Close();
+
+        if (!m_file.Open(path, errorMessage))
+            return false;
+
+        const std::uint8_t* base = m_file.Data();
+        const std::size_t size = m_file.Size();
+        auto fail = [&](const std::string& msg)
+        {
+            Close();
+            SetError(errorMessage, msg + ": " + path.string());
+            return false;
+        };
+
+        if (size < 12 || std::memcmp(base + 0, "RIFF", 4) != 0 || std::memcmp(base + 8, "WAVE", 4) != 0)
+            return fail("Not a RIFF/WAVE file");
+
+        bool gotFmt = false;
+        bool gotData = false;
+        unsigned short fmtAudioFormat = 0;
+        unsigned short fmtChannels = 0;
+        unsigned int fmtSampleRate = 0;
+        unsigned short fmtBitsPerSample = 0;
+        std::size_t dataOffset = 0;
+        std::size_t dataBytes = 0;
+
+        std::size_t pos = 12;
+        while (pos + 8 <= size && !(gotFmt && gotData))
+        {
+            const std::uint8_t* chdr = base + pos;
+            const std::size_t chunkSize = read_u32le(chdr + 4);
+            const std::size_t chunkDataPos = pos + 8;
+            const std::size_t avail = size - chunkDataPos;
+
+            if (std::memcmp(chdr, "fmt ", 4) == 0)
+            {
+                if (chunkSize < 16 || chunkSize > avail)
+                    return fail("Malformed fmt chunk");
+                const std::uint8_t* fmt = base + chunkDataPos;
+                fmtAudioFormat = read_u16le(fmt + 0);
+                fmtChannels = read_u16le(fmt + 2);
+                fmtSampleRate = read_u32le(fmt + 4);
+                fmtBitsPerSample = read_u16le(fmt + 14);
+                // WAVE_FORMAT_EXTENSIBLE: the real format tag is the first word of the SubFormat GUID.
+                if (fmtAudioFormat == kWaveFormatExtensible && chunkSize >= 26)
+                    fmtAudioFormat = read_u16le(fmt + 24);
+                gotFmt = true;
+            }
+            else if (std::memcmp(chdr, "data", 4) == 0)
+            {
+                dataOffset = chunkDataPos;
+                // Writers that stream (or crash) may leave 0 / 0xFFFFFFFF here; trust the file size instead.
+                dataBytes = (chunkSize == 0 || chunkSize > avail) ? avail : chunkSize;
+                gotData = true;
+            }
+
+            if (chunkSize > avail)
+                break;
+            pos = chunkDataPos + chunkSize + (chunkSize & 1u);
+        }
+
+        if (!gotFmt || !gotData)
+            return fail("Missing fmt or data chunk");
+        if (fmtAudioFormat != kWaveFormatPcm || fmtBitsPerSample != 16)
+            return fail("Only 16-bit PCM WAV can be memory-mapped");
+        if (fmtChannels == 0 || fmtSampleRate == 0)
+            return fail("Invalid channel count or sample rate");
+
+        const std::size_t frameBytes = static_cast<std::size_t>(fmtChannels) * sizeof(short);
+        const std::size_t frames = dataBytes / frameBytes;
+        const std::uint8_t* data = base + dataOffset;
+        if (reinterpret_cast<std::uintptr_t>(data) % alignof(short) != 0)
+        {
+            // A writer that skipped the pad byte after an odd-sized chunk leaves the samples at an
+            // odd offset; reading shorts there is misaligned, so serve a copy instead.
+            m_copy.resize(frames * fmtChannels);
+            std::memcpy(m_copy.data(), data, m_copy.size() * sizeof(short));
+            m_samples = Pcm16Span(m_copy);
+        }
+        else
+        {
+            m_samples = Pcm16Span(reinterpret_cast<const short*>(data), frames * fmtChannels);
+        }
+        m_sampleRate = static_cast<int>(fmtSampleRate);
+        m_channels = static_cast<int>(fmtChannels);
+        return true;
+    }
+
+    void MappedWavFile::Close()
+    {
+        m_file.Close();
+        m_samples = {};
+        m_copy.clear();
+        m_copy.shrink_to_fit();
+        m_sampleRate = 0;
+        m_channels = 0;
+    }
+}
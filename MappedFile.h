@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "AudioFileLoader.h"
+
+namespace audiofile
+{
+    // Read-only memory mapping of a whole file. Pages are faulted in on demand and
+    // backed by the OS page cache, so opening is O(1) regardless of file size.
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        bool Open(const std::filesystem::path& path, std::string* errorMessage = nullptr);
+        void Close();
+        bool IsOpen() const { return m_data != nullptr; }
+
+        const std::uint8_t* Data() const { return m_data; }
+        std::size_t Size() const { return m_size; }
+
+    private:
+        void* m_file = nullptr;    // HANDLE
+        void* m_mapping = nullptr; // HANDLE
+        const std::uint8_t* m_data = nullptr;
+        std::size_t m_size = 0;
+    };
+
+    // PCM16 RIFF/WAVE file exposed as a zero-copy view of its "data" chunk.
+    // Chunks are walked properly (LIST/JUNK/bext etc. are skipped), unlike the old
+    // byte-by-byte "LIST" scan in getData(). A data chunk at an odd file offset (a writer that
+    // skipped a pad byte) is copied out rather than read through a misaligned short*.
+    class MappedWavFile
+    {
+    public:
+        bool Open(const std::filesystem::path& path, std::string* errorMessage = nullptr);
+        void Close();
+        bool IsOpen() const { return m_file.IsOpen(); }
+
+        // Interleaved samples; valid for as long as this object stays open.
+        Pcm16Span Samples() const { return m_samples; }
+        int SampleRate() const { return m_sampleRate; }
+        int Channels() const { return m_channels; }
+        std::size_t FrameCount() const { return m_channels > 0 ? m_samples.size() / static_cast<std::size_t>(m_channels) : 0; }
+
+    private:
+        MappedFile m_file;
+        Pcm16Span m_samples;
+        std::vector<short> m_copy; // only used when the data chunk is not 2-byte aligned
+        int m_sampleRate = 0;
+        int m_channels = 0;
+    };
+}
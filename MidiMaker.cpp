@@ -1,14 +1,20 @@
 #include "MidiMaker.h"
 #include "Keys.h"
 #include "Chunk.h"
+#include "ChunkStore.h"
 #include <string>
 #include <iostream>
-#include <fftw3.h>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include "BatchedStft.h"
+#include "ConstantQ.h"
 #include "Functions.h"
-#include "GLOBAL.h"
 #include <iomanip>
 #include "MidiFile.h"
+#include "MidiEventList.h"
 #include "Options.h"
+#include "Profiler.h"
 
 using namespace std;
 using namespace smf;
@@ -29,285 +35,387 @@ FILE* Init(string filename)
     return file;
 }
 
-vector<Chunk> MidiMaker::lowPass(vector<short int> lowPassData)
+// Note ranges of the constant-Q analysis per band. The split is at ~200 Hz, so each side reaches
+// a few semitones past it to cover the filter skirt.
+static const int LOW_MIDI_MIN = 24;  // C1
+static const int LOW_MIDI_MAX = 59;  // B3
+static const int BAND_MIDI_MIN = 48; // C3
+static const int BAND_MIDI_MAX = 96; // C7
+static const int HIGH_MIDI_MIN = 52; // E3
+static const int HIGH_MIDI_MAX = 108; // C8
+
+// Same times Chunk::getStart()/getEnd() report.
+static void chunkTimes(const analysis::AnalysisContext& ctx, float chunkSeconds, int i, float& start, float& end)
 {
-    int sampleSize = GLOBAL::twoBeatDuration * GLOBAL::sampleRate;
-    int numOfChunks = lowPassData.size() / (sampleSize);
-
-    vector<vector<double>> sampleChunks;
-    sampleChunks.resize(numOfChunks);
-    vector<Chunk> chunkData;
-    for (int i = 0; i < numOfChunks;i++)
+    start = chunkSeconds * i;
+    end = chunkSeconds * (i + 1);
+    if (ctx.songLength > 0 && end > ctx.songLength)
     {
-        for (int j = 0;j < sampleSize;j++)
-        {
-            sampleChunks[i].push_back(lowPassData[(i * sampleSize) + j]);
-        }
+        end = ctx.songLength;
     }
-    //Do FFT
-    for (int i = 0; i < numOfChunks;i++)
+}
+
+// Constant-Q version of the chunking below: semitone-spaced bins from minMidi to maxMidi, analyzed
+// every ~10 ms, so a chunk's notes come from several short frames instead of one long FFT whose
+// bins are too coarse for the bass. Each chunk keeps the `peaks` notes with the highest average
+// magnitude over the frames centred inside it, at their equal-tempered frequencies.
+static analysis::ChunkStore analyzeChunksConstantQ(const audiofile::AudioView& audio, const analysis::AnalysisContext& ctx,
+    float chunkSeconds, int peaks, int minMidi, int maxMidi, threading::WorkerPool* pool)
+{
+    const int sampleSize = chunkSeconds * ctx.sampleRate;
+    const int chunks = sampleSize > 0 ? (int)(audio.Frames() / sampleSize) : 0;
+    analysis::ChunkStore chunkData(peaks);
+    if (chunks == 0)
     {
-        int N = sampleChunks[i].size();
-        fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
+        return chunkData;
+    }
 
-        for (int j = 0;j < N;j++)
+    dsp::ConstantQConfig config;
+    config.sampleRate = ctx.sampleRate;
+    config.minMidi = minMidi;
+    config.maxMidi = maxMidi;
+    config.binsPerOctave = ctx.pitchBinsPerOctave;
+    config.q = dsp::semitone_q();
+    config.hop = (std::max)(1, (std::min)(ctx.sampleRate / 100, sampleSize / 4));
+    dsp::ConstantQ cq(config);
+    dsp::ConstantQFrames frames;
+    cq.analyze(audio, frames, pool);
+
+    const int notes = frames.notes();
+    peaks = (std::min)(peaks, notes);
+    vector<double> noteMagnitudes(notes);
+    vector<double> mean(notes);
+    vector<int> order(notes);
+    vector<double> Frequencies(chunkData.PeaksPerChunk(), 0.0);
+    vector<double> mag(chunkData.PeaksPerChunk(), 0.0);
+    chunkData.Reserve(chunks);
+    for (int i = 0; i < chunks; i++)
+    {
+        // Frames centred in [i, i + 1) chunk lengths; at least the nearest one for very short chunks.
+        const double t0 = (double)sampleSize * i / ctx.sampleRate;
+        const double t1 = (double)sampleSize * (i + 1) / ctx.sampleRate;
+        int f0 = (int)std::ceil(t0 / frames.hopSeconds);
+        int f1 = (int)std::ceil(t1 / frames.hopSeconds);
+        f0 = (std::min)(f0, frames.frames - 1);
+        f1 = (std::max)(f0 + 1, (std::min)(f1, frames.frames));
+
+        std::fill(mean.begin(), mean.end(), 0.0);
+        for (int f = f0; f < f1; f++)
         {
-            in[j][0] = sampleChunks[i][j];
-            in[j][1] = 0;
-        }
-        fftw_plan plan = fftw_plan_dft_1d(N, in, in, FFTW_FORWARD, FFTW_ESTIMATE);
-        fftw_execute(plan);
-
-        double highestMagnitudes[3] = { 0.0 };
-        unsigned int maxIndices[3] = { 0 };
-
-        for (unsigned int l = 0; l < N; ++l) {
-            double magnitude = sqrt(in[l][0] * in[l][0] + in[l][1] * in[l][1]);
-
-            // Check if the magnitude is higher than any of the current top three
-            for (int i = 0; i < 3; ++i) {
-                if (magnitude > highestMagnitudes[i]) {
-                    // Shift the current values down the array to make room for the new magnitude
-                    for (int j = 2; j > i; --j) {
-                        highestMagnitudes[j] = highestMagnitudes[j - 1];
-                        maxIndices[j] = maxIndices[j - 1];
-                    }
-
-                    // Store the new magnitude and index
-                    highestMagnitudes[i] = magnitude;
-                    maxIndices[i] = l;
-
-                    break;  // No need to check the remaining elements
-                }
+            frames.note_magnitudes(f, noteMagnitudes.data());
+            for (int n = 0; n < notes; n++)
+            {
+                mean[n] += noteMagnitudes[n];
             }
         }
-
-        int sampleRate = GLOBAL::sampleRate;
-
-        
-
-
-        /*for (int ja = 0; ja < 3; ++ja) 
+        for (int n = 0; n < notes; n++)
         {
-            double frequency = static_cast<double>(maxIndices[ja]) * sampleRate / N;
-            cout << i<<" Frequency " << ja + 1 << ": " << frequency << " Hz, Magnitude: " << highestMagnitudes[ja] << endl;
-        }*/
-        vector<double> Frequencies;
-        vector<double> mag;
-        for (int a = 0;a < 3;a++)
+            mean[n] /= (f1 - f0);
+            order[n] = n;
+        }
+        std::partial_sort(order.begin(), order.begin() + peaks, order.end(),
+            [&mean](int a, int b) { return mean[a] > mean[b]; });
+        for (int a = 0; a < peaks; a++)
         {
-            double freq = (double)maxIndices[a] * sampleRate / N;
-            if (freq > sampleRate / 2)
-            {
-                freq = abs(freq - sampleRate);
-                Frequencies.push_back(freq);
-                mag.push_back(highestMagnitudes[a]);
-            }
-            else
-            {
-                Frequencies.push_back(freq);
-                mag.push_back(highestMagnitudes[a]);
-            }
-
+            Frequencies[a] = dsp::midi_to_hz(frames.minMidi + order[a]);
+            mag[a] = mean[order[a]];
         }
-        Chunk c = Chunk(Frequencies, mag, i,GLOBAL::twoBeatDuration);
-        c.Init();
-        chunkData.push_back(c);
-    }
 
-    std::cout << "This is the size of lowpass chunk vector: " << chunkData.size()<<endl;
+        float start, end;
+        chunkTimes(ctx, chunkSeconds, i, start, end);
+        chunkData.Append(i, start, end, Frequencies.data(), mag.data());
+    }
+    chunkData.ClampToKey(analysis::KeyClampTable::ForKey(ctx.musicalKey));
     return chunkData;
-
 }
 
-vector<Chunk> MidiMaker::bandPass(vector<short int> bandPassData)
+// Splits audio into back-to-back chunks of chunkSeconds, takes the magnitude spectrum of every chunk
+// with one batched STFT, keeps the `peaks` strongest bins of each and clamps them to the key.
+// With ctx.pitchBinsPerOctave > 0 the constant-Q analysis above is used instead.
+static analysis::ChunkStore analyzeChunks(const audiofile::AudioView& audio, const analysis::AnalysisContext& ctx,
+    float chunkSeconds, int peaks, int minMidi, int maxMidi, threading::WorkerPool* pool)
 {
-    int sampleSize = GLOBAL::qBeatDuration * GLOBAL::sampleRate;
-    int numOfChunks = bandPassData.size() / (sampleSize);
-    vector<vector<double>> sampleChunks;
-    sampleChunks.resize(numOfChunks);
-    vector<Chunk> chunkData;
-    for (int i = 0; i < numOfChunks;i++)
+    if (ctx.pitchBinsPerOctave > 0)
     {
-        for (int j = 0;j < sampleSize;j++)
-        {
-            sampleChunks[i].push_back(bandPassData[(i * sampleSize) + j]);
-        }
+        return analyzeChunksConstantQ(audio, ctx, chunkSeconds, peaks, minMidi, maxMidi, pool);
     }
-    //Do FFT
-    for (int i = 0; i < numOfChunks;i++)
-    {
-        int N = sampleChunks[i].size();
-        fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
-
-        for (int j = 0;j < N;j++)
-        {
-            in[j][0] = sampleChunks[i][j];
-            in[j][1] = 0;
-        }
-        fftw_plan plan = fftw_plan_dft_1d(N, in, in, FFTW_FORWARD, FFTW_ESTIMATE);
-        fftw_execute(plan);
-
-        double highestMagnitudes[6] = { 0.0 };
-        unsigned int maxIndices[6] = { 0 };
 
-        for (unsigned int l = 0; l < N; ++l) {
-            double magnitude = sqrt(in[l][0] * in[l][0] + in[l][1] * in[l][1]);
+    int sampleSize = chunkSeconds * ctx.sampleRate;
+    if (sampleSize <= 0)
+    {
+        return analysis::ChunkStore(peaks);
+    }
 
-            // Check if the magnitude is higher than any of the current top three
-            for (int i = 0; i < 6; ++i) {
-                if (magnitude > highestMagnitudes[i]) {
+    dsp::StftConfig config;
+    config.frameSize = sampleSize;
+    config.hop = sampleSize;
+    config.window = dsp::StftWindow::Rectangular;
+    config.measurePlan = false; // the chunk length follows the tempo, so measuring rarely pays off
+    dsp::StftMagnitudes spectra;
+    dsp::BatchedStft(config).analyze(audio, spectra, pool); //downmixed on the fly
+
+    const int N = sampleSize;
+    const int sampleRate = ctx.sampleRate;
+    analysis::ChunkStore chunkData(peaks);
+    chunkData.Reserve(spectra.frames);
+    vector<double> highestMagnitudes(peaks);
+    vector<unsigned int> maxIndices(peaks);
+    vector<double> Frequencies(peaks);
+    for (int i = 0; i < spectra.frames; i++)
+    {
+        const double* magnitudes = spectra.frame(i);
+        std::fill(highestMagnitudes.begin(), highestMagnitudes.end(), 0.0);
+        std::fill(maxIndices.begin(), maxIndices.end(), 0u);
+
+        // Scan the full (mirrored) spectrum like the complex transform this replaced, so a peak
+        // and its alias above Nyquist still both count.
+        for (unsigned int l = 0; l < (unsigned int)N; ++l) {
+            double magnitude = magnitudes[l <= (unsigned int)N / 2 ? l : N - l];
+
+            // Check if the magnitude is higher than any of the current top ones
+            for (int p = 0; p < peaks; ++p) {
+                if (magnitude > highestMagnitudes[p]) {
                     // Shift the current values down the array to make room for the new magnitude
-                    for (int j = 2; j > i; --j) {
+                    for (int j = peaks - 1; j > p; --j) {
                         highestMagnitudes[j] = highestMagnitudes[j - 1];
                         maxIndices[j] = maxIndices[j - 1];
                     }
 
                     // Store the new magnitude and index
-                    highestMagnitudes[i] = magnitude;
-                    maxIndices[i] = l;
+                    highestMagnitudes[p] = magnitude;
+                    maxIndices[p] = l;
 
                     break;  // No need to check the remaining elements
                 }
             }
         }
 
-        int sampleRate = GLOBAL::sampleRate;
-
-
-
-
-        /*for (int ja = 0; ja < 3; ++ja)
-        {
-            double frequency = static_cast<double>(maxIndices[ja]) * sampleRate / N;
-            cout << i<<" Frequency " << ja + 1 << ": " << frequency << " Hz, Magnitude: " << highestMagnitudes[ja] << endl;
-        }*/
-        vector<double> Frequencies;
-        vector<double> mag;
-        for (int a = 0;a < 6;a++)
+        for (int a = 0;a < peaks;a++)
         {
             double freq = (double)maxIndices[a] * sampleRate / N;
             if (freq > sampleRate / 2)
             {
                 freq = abs(freq - sampleRate);
-                Frequencies.push_back(freq);
-                mag.push_back(highestMagnitudes[a]);
             }
-            else
-            {
-                Frequencies.push_back(freq);
-                mag.push_back(highestMagnitudes[a]);
-            }
-
+            Frequencies[a] = freq;
+            // 2 / N turns a rectangular-window bin into the sinusoid's peak amplitude, the scale
+            // the constant-Q path reports and velocityOf expects.
+            highestMagnitudes[a] *= 2.0 / N;
         }
-        Chunk c = Chunk(Frequencies, mag, i,GLOBAL::qBeatDuration);
-        c.Init();
-        chunkData.push_back(c);
+
+        float start, end;
+        chunkTimes(ctx, chunkSeconds, i, start, end);
+        chunkData.Append(i, start, end, Frequencies.data(), highestMagnitudes.data());
     }
+    chunkData.ClampToKey(analysis::KeyClampTable::ForKey(ctx.musicalKey));
+    return chunkData;
+}
 
-    std::cout << "This is the size of bandpass chunk vector: " << chunkData.size() << endl;
+analysis::ChunkStore MidiMaker::lowPass(const audiofile::AudioView& lowPassData, const analysis::AnalysisContext& ctx, threading::WorkerPool* pool)
+{
+    WAVEOUT_PROFILE_SCOPE("midi.lowPass");
+    analysis::ChunkStore chunkData = analyzeChunks(lowPassData, ctx, ctx.twoBeatDuration, 3, LOW_MIDI_MIN, LOW_MIDI_MAX, pool);
+
+    std::cout << "This is the size of lowpass chunk vector: " << chunkData.Size()<<endl;
     return chunkData;
 
 }
 
-vector<Chunk> MidiMaker::highPass(vector<short int> highPassData)
+analysis::ChunkStore MidiMaker::bandPass(const audiofile::AudioView& bandPassData, const analysis::AnalysisContext& ctx, threading::WorkerPool* pool)
 {
-    int sampleSize = GLOBAL::qBeatDuration * GLOBAL::sampleRate;
-    cout << "THIS IS SAMPLE SIZE HIGH PASS MIDI: " << sampleSize << endl;
-    int numOfChunks = static_cast<long long>(highPassData.size()) / (sampleSize);
-    cout << "THIS IS THE numOFChunks For HighPass: " << numOfChunks << endl;
-    cout << "THIS IS THE size of highPassData: " << highPassData.size() << endl;
-
-    vector<vector<double>> sampleChunks;
-    sampleChunks.resize(numOfChunks);
-    vector<Chunk> chunkData;
-    for (int i = 0; i < numOfChunks;i++)
-    {
-        for (int j = 0;j < sampleSize;j++)
-        {
-            sampleChunks[i].push_back(highPassData[(i * sampleSize) + j]);
-        }
-    }
-    //Do FFT
-    for (int i = 0; i < numOfChunks;i++)
-    {
-        int N = sampleChunks[i].size();
-        fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
-
-        for (int j = 0;j < N;j++)
-        {
-            in[j][0] = sampleChunks[i][j];
-            in[j][1] = 0;
-        }
-        fftw_plan plan = fftw_plan_dft_1d(N, in, in, FFTW_FORWARD, FFTW_ESTIMATE);
-        fftw_execute(plan);
+    WAVEOUT_PROFILE_SCOPE("midi.bandPass");
+    analysis::ChunkStore chunkData = analyzeChunks(bandPassData, ctx, ctx.qBeatDuration, 6, BAND_MIDI_MIN, BAND_MIDI_MAX, pool);
 
-        double highestMagnitudes[6] = { 0.0 };
-        unsigned int maxIndices[6] = { 0 };
+    std::cout << "This is the size of bandpass chunk vector: " << chunkData.Size() << endl;
+    return chunkData;
 
-        for (unsigned int l = 0; l < N; ++l) {
-            double magnitude = sqrt(in[l][0] * in[l][0] + in[l][1] * in[l][1]);
+}
 
-            // Check if the magnitude is higher than any of the current top three
-            for (int i = 0; i < 6; ++i) {
-                if (magnitude > highestMagnitudes[i]) {
-                    // Shift the current values down the array to make room for the new magnitude
-                    for (int j = 2; j > i; --j) {
-                        highestMagnitudes[j] = highestMagnitudes[j - 1];
-                        maxIndices[j] = maxIndices[j - 1];
-                    }
+analysis::ChunkStore MidiMaker::highPass(const audiofile::AudioView& highPassData, const analysis::AnalysisContext& ctx, threading::WorkerPool* pool)
+{
+    WAVEOUT_PROFILE_SCOPE("midi.highPass");
+    cout << "THIS IS SAMPLE SIZE HIGH PASS MIDI: " << static_cast<int>(ctx.qBeatDuration * ctx.sampleRate) << endl;
+    cout << "THIS IS THE size of highPassData: " << highPassData.Frames() << endl;
+    analysis::ChunkStore chunkData = analyzeChunks(highPassData, ctx, ctx.qBeatDuration, 6, HIGH_MIDI_MIN, HIGH_MIDI_MAX, pool);
 
-                    // Store the new magnitude and index
-                    highestMagnitudes[i] = magnitude;
-                    maxIndices[i] = l;
+    std::cout << "This is the size of highpass chunk vector: " << chunkData.Size() << endl;
+    return chunkData;
 
-                    break;  // No need to check the remaining elements
-                }
-            }
-        }
+}
 
-        int sampleRate = GLOBAL::sampleRate;
 
+namespace
+{
+    // A note-on or note-off before it becomes a MidiEvent. Sorting these small records once per
+    // track, then materializing the events in order, replaces a sort of MidiEvent pointers.
+    struct PendingNote
+    {
+        int tick;
+        uint8_t on;       // 0 sorts note-offs first, so a re-struck note is not cut short
+        uint8_t key;
+        uint8_t velocity;
 
+        bool operator<(const PendingNote& other) const
+        {
+            if (tick != other.tick) return tick < other.tick;
+            if (on != other.on) return on < other.on;
+            return key < other.key;
+        }
+    };
 
+    // Seconds -> ticks for the tempo map buildMidi writes: a lead-in quarter note of leadIn
+    // seconds, then bpm. leadIn == 0 means the whole file runs at bpm.
+    struct TickMap
+    {
+        int tpq;
+        double bpm;
+        double leadIn;
 
-        /*for (int ja = 0; ja < 3; ++ja)
+        int operator()(double seconds) const
         {
-            double frequency = static_cast<double>(maxIndices[ja]) * sampleRate / N;
-            cout << i<<" Frequency " << ja + 1 << ": " << frequency << " Hz, Magnitude: " << highestMagnitudes[ja] << endl;
-        }*/
-        vector<double> Frequencies;
-        vector<double> mag;
-        for (int a = 0;a < 6;a++)
+            if (seconds < leadIn)
+                return (int)std::lround(seconds / leadIn * tpq);
+            return (int)std::lround((leadIn > 0.0 ? tpq : 0) + (seconds - leadIn) * bpm / 60.0 * tpq);
+        }
+    };
+
+    // Magnitudes are peak amplitudes in PCM16 units: -60..0 dBFS -> velocity 1..127.
+    uint8_t velocityOf(double magnitude)
+    {
+        const double db = 20.0 * std::log10((std::max)(magnitude, 1e-9) / 32768.0);
+        return (uint8_t)(std::max)(1L, (std::min)(127L, std::lround(127.0 * (1.0 + db / 60.0))));
+    }
+
+    // Note runs of one stem. Only the notes sounding in the previous chunk are checked for an end,
+    // so a chunk costs O(peaks) rather than a pass over all 128 keys.
+    void collectNotes(const analysis::ChunkStore& chunks, const TickMap& ticks, vector<PendingNote>& out)
+    {
+        const int peaks = chunks.PeaksPerChunk();
+        long long lastSeen[128];
+        int runStart[128];
+        double runPeak[128];
+        std::fill(lastSeen, lastSeen + 128, -1LL);
+        std::fill(runStart, runStart + 128, -1);
+        std::fill(runPeak, runPeak + 128, 0.0);
+        vector<int> active;
+        active.reserve((std::size_t)peaks);
+
+        auto close = [&](int key, std::size_t lastChunk) {
+            const int on = ticks(chunks.StartSeconds((std::size_t)runStart[key]));
+            const int off = (std::max)(on + 1, ticks(chunks.EndSeconds(lastChunk)));
+            out.push_back({ on, 1, (uint8_t)key, velocityOf(runPeak[key]) });
+            out.push_back({ off, 0, (uint8_t)key, 0 });
+            runStart[key] = -1;
+            runPeak[key] = 0.0;
+        };
+
+        for (std::size_t c = 0; c < chunks.Size(); c++)
         {
-            double freq = (double)maxIndices[a] * sampleRate / N;
-            if (freq > sampleRate / 2)
+            const double* freqs = chunks.Frequencies(c);
+            const double* mags = chunks.Magnitudes(c);
+            const uint8_t* midi = chunks.MidiNotes(c);
+            for (int p = 0; p < peaks; p++)
             {
-                freq = abs(freq - sampleRate);
-                Frequencies.push_back(freq);
-                mag.push_back(highestMagnitudes[a]);
+                // Unclamped stores (no key) fall back to the nearest equal-tempered note.
+                const int key = chunks.IsClamped() ? midi[p]
+                    : (freqs[p] > 0.0 ? (int)std::lround(69.0 + 12.0 * std::log2(freqs[p] / 440.0)) : 0);
+                if (key <= 0 || key > 127) continue;
+                lastSeen[key] = (long long)c;
+                if (runStart[key] < 0)
+                {
+                    runStart[key] = (int)c;
+                    active.push_back(key);
+                }
+                runPeak[key] = (std::max)(runPeak[key], mags[p]);
             }
-            else
+            for (std::size_t i = 0; i < active.size();)
             {
-                Frequencies.push_back(freq);
-                mag.push_back(highestMagnitudes[a]);
+                if (lastSeen[active[i]] == (long long)c)
+                {
+                    i++;
+                    continue;
+                }
+                close(active[i], c - 1);
+                active[i] = active.back();
+                active.pop_back();
             }
-
         }
-        Chunk c = Chunk(Frequencies, mag, i,GLOBAL::qBeatDuration);
-        c.Init();
-        chunkData.push_back(c);
+        for (int key : active)
+        {
+            close(key, chunks.Size() - 1);
+        }
     }
+}
 
-    std::cout << "This is the size of highpass chunk vector: " << chunkData.size() << endl;
-    return chunkData;
+void MidiMaker::buildMidi(const vector<MidiStem>& stems, const BPMDetection::BeatGridEstimate& grid,
+    MidiFile& out, int ticksPerQuarter)
+{
+    WAVEOUT_PROFILE_SCOPE("midi.build");
+    const double bpm = grid.bpm > 0.0 ? grid.bpm : 120.0;
+    const double beat = 60.0 / bpm;
+    const double phase = grid.bpm > 0.0 ? std::fmod((std::max)(0.0, grid.t0), beat) : 0.0;
+    const TickMap ticks = { ticksPerQuarter, bpm, phase > 1e-3 ? beat + phase : 0.0 };
+
+    out.clear();
+    out.setTicksPerQuarterNote(ticksPerQuarter);
+    out.addTracks((int)stems.size());
+    out.addTrackName(0, 0, "Tempo");
+    out.addTimeSignature(0, 0, 4, 4);
+    if (ticks.leadIn > 0.0)
+    {
+        out.addTempo(0, 0, 60.0 / ticks.leadIn);
+        out.addTempo(0, ticksPerQuarter, bpm);
+    }
+    else
+    {
+        out.addTempo(0, 0, bpm);
+    }
 
+    vector<PendingNote> notes;
+    for (std::size_t s = 0; s < stems.size(); s++)
+    {
+        const MidiStem& stem = stems[s];
+        const int track = (int)s + 1;
+        const int channel = (std::max)(0, (std::min)(15, stem.channel));
+        out.addTrackName(track, 0, stem.name);
+        if (stem.program >= 0)
+            out.addPatchChange(track, 0, channel, (std::min)(127, stem.program));
+        if (!stem.chunks) continue;
+
+        // At most one run per peak per chunk, i.e. two events each.
+        notes.clear();
+        notes.reserve(2 * stem.chunks->Size() * (std::size_t)stem.chunks->PeaksPerChunk());
+        collectNotes(*stem.chunks, ticks, notes);
+        std::sort(notes.begin(), notes.end());
+
+        MidiEventList& events = out[track];
+        events.reserve(events.size() + (int)notes.size());
+        for (const PendingNote& n : notes)
+        {
+            MidiEvent* me = new MidiEvent;
+            if (n.on)
+                me->makeNoteOn(channel, n.key, n.velocity);
+            else
+                me->makeNoteOff(channel, n.key, 0);
+            me->tick = n.tick;
+            me->track = track;
+            events.push_back_no_copy(me);
+        }
+        WAVEOUT_PROFILE_BYTES(notes.size() * sizeof(MidiEvent));
+    }
 }
 
-
-void makeMidi(vector<vector<Chunk>> data)
+bool MidiMaker::makeMidi(const vector<MidiStem>& stems, const BPMDetection::BeatGridEstimate& grid,
+    const string& path, string* errorMessage)
 {
-
+    MidiFile midifile;
+    buildMidi(stems, grid, midifile);
+    if (!midifile.write(path))
+    {
+        if (errorMessage) *errorMessage = "could not write " + path;
+        return false;
+    }
+    return true;
 }
 
 
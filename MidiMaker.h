@@ -2,8 +2,31 @@
 #include <iostream>
 #include <vector>
 #include "Chunk.h"
+#include "ChunkStore.h"
+#include "AnalysisContext.h"
+#include "AudioView.h"
+#include "BPMDetection.h"
 using namespace std;
 
+namespace threading
+{
+	class WorkerPool;
+}
+
+namespace smf
+{
+	class MidiFile;
+}
+
+// One transcribed part of a song; becomes one MIDI track.
+struct MidiStem
+{
+	string name;
+	const analysis::ChunkStore* chunks = nullptr;
+	int channel = 0;  // 0-15 (9 is General MIDI percussion)
+	int program = -1; // General MIDI program, -1 = no patch change
+};
+
 class MidiMaker
 {
 public:
@@ -11,11 +34,19 @@ public:
 	{
 
 	}
-	static vector<Chunk> lowPass(vector<short int> lowPassData);
-	static vector<Chunk> bandPass(vector<short int> bandPassData);
-	static vector<Chunk> highPass(vector<short int> highPassData);
+	static analysis::ChunkStore lowPass(const audiofile::AudioView& lowPassData, const analysis::AnalysisContext& ctx, threading::WorkerPool* pool = nullptr);
+	static analysis::ChunkStore bandPass(const audiofile::AudioView& bandPassData, const analysis::AnalysisContext& ctx, threading::WorkerPool* pool = nullptr);
+	static analysis::ChunkStore highPass(const audiofile::AudioView& highPassData, const analysis::AnalysisContext& ctx, threading::WorkerPool* pool = nullptr);
 	static void doSomething();
 
+	// Track 0 carries the tempo map, then one track per stem. A note present in consecutive chunks
+	// becomes one note-on/note-off pair spanning them; velocity follows the run's loudest magnitude.
+	// The tempo comes from the grid, with a lead-in beat stretched so grid beats land on quarter notes.
+	static void buildMidi(const vector<MidiStem>& stems, const BPMDetection::BeatGridEstimate& grid,
+		smf::MidiFile& out, int ticksPerQuarter = 480);
+	static bool makeMidi(const vector<MidiStem>& stems, const BPMDetection::BeatGridEstimate& grid,
+		const string& path, string* errorMessage = nullptr);
+
 private:
 
 };
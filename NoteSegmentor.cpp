@@ -1,37 +1,214 @@
 #include "NoteSegmentor.h"
-#include "FUNCTIONS.h"
-std::vector<int> NoteSegmentor::getNoteStart(std::vector<short> derivativeData)
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Profiler.h"
+
+void NoteSegmentor::init(const OnsetConfig& config)
+{
+	m_config = config;
+	if (m_config.sampleRate < 1) m_config.sampleRate = 1;
+	if (m_config.frameSize < 16) m_config.frameSize = 16;
+	const double hop = std::isfinite(m_config.hopSeconds) ? std::round(m_config.hopSeconds * m_config.sampleRate) : 1.0;
+	m_hop = (int)(std::max)(1.0, (std::min)(hop, (double)m_config.frameSize));
+	m_config.lookaheadFrames = (std::max)(0, m_config.lookaheadFrames);
+	m_config.thresholdFrames = (std::max)((std::max)(1, m_config.lookaheadFrames), m_config.thresholdFrames);
+
+	const int N = m_config.frameSize;
+	m_fft.init(N);
+	m_window.resize((std::size_t)N);
+	double windowSum = 0.0;
+	for (int i = 0; i < N; i++)
+	{
+		m_window[(std::size_t)i] = dsp::hann(i, N);
+		windowSum += m_window[(std::size_t)i];
+	}
+	m_magnitudeScale = windowSum > 0.0 ? 2.0 / windowSum : 1.0; // a full-scale sine reads 1
+	m_input.assign((std::size_t)N, 0.0f);
+	m_previous.assign((std::size_t)(N / 2 + 1), 0.0);
+	m_flux.assign((std::size_t)(m_config.thresholdFrames + m_config.lookaheadFrames + 1), 0.0);
+	m_median.init(m_flux.size());
+	m_moments.init(m_flux.size());
+	reset();
+}
+
+void NoteSegmentor::reset()
 {
-	std::vector<short> temp(derivativeData.size());
-	std::vector<int> noteStartIndices;
-	for (int i = 0; i < derivativeData.size(); i++)
+	std::fill(m_input.begin(), m_input.end(), 0.0f);
+	std::fill(m_previous.begin(), m_previous.end(), 0.0);
+	std::fill(m_flux.begin(), m_flux.end(), 0.0);
+	// The threshold window starts out as silence, like the flux ring.
+	m_median.reset();
+	m_moments.reset();
+	for (std::size_t i = 0; i < m_flux.size(); i++)
 	{
-		temp[i] = derivativeData[i] * derivativeData[i];
+		m_median.push(0.0);
+		m_moments.push(0.0);
 	}
-	float sum = 0;
-	float aver = 0;
-	for (int j = 1; j < temp.size(); j++)
+	m_inputPos = 0;
+	m_pending = 0;
+	m_samples = 0;
+	m_frame = 0;
+	m_lastOnset = -1;
+}
+
+double NoteSegmentor::latencySeconds() const
+{
+	return (m_config.frameSize / 2.0 + (double)m_config.lookaheadFrames * m_hop) / m_config.sampleRate;
+}
+
+std::size_t NoteSegmentor::process(const float* samples, std::size_t count, std::vector<Onset>& out)
+{
+	const std::size_t before = out.size();
+	const std::size_t N = m_input.size();
+	while (count > 0)
 	{
-		sum += temp[j];
-		if (abs(aver - (sum / j)))
+		// Copy up to the next frame boundary straight into the ring.
+		std::size_t n = (std::min)(count, (std::size_t)(m_hop - m_pending));
+		m_samples += (long long)n;
+		m_pending += (int)n;
+		count -= n;
+		while (n > 0)
 		{
+			const std::size_t run = (std::min)(n, N - m_inputPos);
+			std::memcpy(m_input.data() + m_inputPos, samples, run * sizeof(float));
+			m_inputPos = (m_inputPos + run) % N;
+			samples += run;
+			n -= run;
+		}
+		if (m_pending == m_hop)
+		{
+			m_pending = 0;
+			analyzeFrame(out);
+		}
+	}
+	return out.size() - before;
+}
 
+std::size_t NoteSegmentor::process(const short* interleaved, std::size_t frames, int channels, std::vector<Onset>& out)
+{
+	constexpr std::size_t BLOCK = 1024;
+	float block[BLOCK];
+	const std::size_t before = out.size();
+	channels = (std::max)(1, channels);
+	const float scale = 1.0f / (32768.0f * (float)channels);
+	for (std::size_t pos = 0; pos < frames; pos += BLOCK)
+	{
+		const std::size_t n = (std::min)(BLOCK, frames - pos);
+		for (std::size_t i = 0; i < n; i++)
+		{
+			const short* frame = interleaved + (pos + i) * (std::size_t)channels;
+			int sum = 0;
+			for (int c = 0; c < channels; c++) sum += frame[c];
+			block[i] = (float)sum * scale;
 		}
+		process(block, n, out);
+	}
+	return out.size() - before;
+}
 
-		aver = sum / j;
+std::size_t NoteSegmentor::flush(std::vector<Onset>& out)
+{
+	const std::size_t before = out.size();
+	const std::vector<float> silence((std::size_t)m_hop, 0.0f);
+	if (m_pending > 0)
+		process(silence.data(), (std::size_t)(m_hop - m_pending), out);
+	for (int i = 0; i < m_config.lookaheadFrames; i++)
+		process(silence.data(), silence.size(), out);
+	return out.size() - before;
+}
 
+void NoteSegmentor::analyzeFrame(std::vector<Onset>& out)
+{
+	const int N = m_config.frameSize;
+	dsp::fft_real* in = m_fft.in();
+	for (int i = 0; i < N; i++)
+		in[i] = (dsp::fft_real)(m_input[(m_inputPos + (std::size_t)i) % (std::size_t)N] * m_window[(std::size_t)i]);
+	m_fft.execute();
+
+	const dsp::FftwR2C::Complex* X = m_fft.out();
+	const std::size_t bins = m_previous.size();
+	double rise = 0.0;
+	for (std::size_t k = 0; k < bins; k++)
+	{
+		double m = std::sqrt((double)X[k][0] * X[k][0] + (double)X[k][1] * X[k][1]) * m_magnitudeScale;
+		if (m_config.compression > 0.0) m = std::log1p(m_config.compression * m);
+		rise += (std::max)(0.0, m - m_previous[k]);
+		m_previous[k] = m;
 	}
-	return noteStartIndices;
+	const double flux = rise / (double)bins;
+
+	// Slide the threshold window: the oldest value leaves the ring, the median and the mean.
+	m_flux[(std::size_t)(m_frame % (long long)m_flux.size())] = flux;
+	m_median.push(flux);
+	m_moments.push(flux);
+	m_frame++;
+
+	pickPeak(out);
 }
 
-std::vector<int> NoteSegmentor::onsetDetection(std::vector<short> pcmData)
+void NoteSegmentor::pickPeak(std::vector<Onset>& out)
 {
-	std::vector<double> pcmDat = FUNCTIONS::short_to_double(pcmData);
+	// The window now holds frames [j - thresholdFrames, j + lookahead] around the candidate j.
+	const int L = m_config.lookaheadFrames;
+	const long long j = m_frame - 1 - L;
+	if (j < 1)
+		return;
 
+	const double value = history(j);
+	if (!(value > history(j - 1)))
+		return;
+	for (long long k = j - L; k <= j + L; k++)
+	{
+		if (k >= 0 && history(k) > value)
+			return;
+	}
 
+	const double mean = (std::max)(0.0, m_moments.mean());
+	const double threshold = m_config.delta + m_config.medianWeight * m_median.median() + m_config.meanWeight * mean;
+	if (value <= threshold)
+		return;
 
+	const long long minGapFrames = (long long)std::ceil(m_config.minGapSeconds * m_config.sampleRate / m_hop);
+	if (m_lastOnset >= 0 && j - m_lastOnset < minGapFrames)
+		return;
+	m_lastOnset = j;
 
+	// Frame j ends after hop j + 1; its centre is where the flux peaks for an onset.
+	Onset onset;
+	onset.sample = (std::max)(0LL, (j + 1) * (long long)m_hop - m_config.frameSize / 2);
+	onset.seconds = (double)onset.sample / m_config.sampleRate;
+	onset.strength = value - threshold;
+	out.push_back(onset);
+}
 
-	return std::vector<int>();
+std::vector<Onset> NoteSegmentor::detect(const float* samples, std::size_t count, const OnsetConfig& config)
+{
+	WAVEOUT_PROFILE_SCOPE("analysis.onsets");
+	std::vector<Onset> onsets;
+	NoteSegmentor segmentor(config);
+	segmentor.process(samples, count, onsets);
+	segmentor.flush(onsets);
+	return onsets;
 }
 
+std::vector<Onset> NoteSegmentor::detect(const audiofile::AudioView& audio, const OnsetConfig& config)
+{
+	WAVEOUT_PROFILE_SCOPE("analysis.onsets");
+	constexpr std::size_t BLOCK = 4096;
+	float block[BLOCK];
+	std::vector<Onset> onsets;
+	NoteSegmentor segmentor(config);
+	const std::size_t frames = audio.Frames();
+	for (std::size_t pos = 0; pos < frames; pos += BLOCK)
+	{
+		const std::size_t n = (std::min)(BLOCK, frames - pos);
+		for (std::size_t i = 0; i < n; i++)
+			block[i] = audio.Mono(pos + i) * (1.0f / 32768.0f);
+		segmentor.process(block, n, onsets);
+	}
+	segmentor.flush(onsets);
+	return onsets;
+}
@@ -1,9 +1,92 @@
 #pragma once
+#include <cstddef>
 #include <vector>
 
+#include "AudioView.h"
+#include "DSP.h"
+#include "RollingStats.h"
+
+struct OnsetConfig
+{
+	int sampleRate = 44100;
+	int frameSize = 2048;
+	double hopSeconds = 0.01;    // frame step; rounded to whole samples at sampleRate
+	double compression = 100.0;  // flux of log(1 + compression * |X|); 0 = plain magnitudes
+	int thresholdFrames = 16;    // past flux values the adaptive threshold follows
+	int lookaheadFrames = 2;     // a peak must also beat this many later frames; adds lookahead * hop latency
+	double medianWeight = 1.0;   // threshold = delta + medianWeight * median + meanWeight * mean
+	double meanWeight = 0.5;
+	double delta = 0.002;        // absolute floor, in flux units (mean per-bin log-magnitude rise)
+	double minGapSeconds = 0.05; // onsets closer than this to the previous one are dropped
+};
+
+struct Onset
+{
+	long long sample = 0; // input sample the onset is placed at (frame centre)
+	double seconds = 0.0;
+	double strength = 0.0; // flux above the threshold
+};
+
+// Spectral-flux onset detector that runs on a stream of samples.
+//
+// Every hop the last frameSize samples go through one Hann-windowed real FFT. The flux is the
+// mean positive rise of the log-compressed bin magnitudes since the previous frame. A frame is an
+// onset when its flux is the largest within lookaheadFrames on either side and clears a threshold
+// that adapts to the median and mean of the surrounding flux. Memory is fixed by the config (one
+// frame of input, one spectrum, W = thresholdFrames + lookaheadFrames + 1 flux values). Per hop,
+// whatever the length of the stream: one frameSize-point FFT, O(frameSize) for the flux,
+// O(lookaheadFrames) for the peak test and O(log W) for the threshold (dsp::SlidingMedian, plus
+// O(1) amortized for the dsp::SlidingMoments mean).
+//
+// Feed blocks of any size to process() as they arrive (for example while audio plays), then call
+// flush() once at the end of the stream. detect() does both for a whole buffer.
 class NoteSegmentor
 {
-	std::vector<int> getNoteStart(std::vector<short> derivativeData);
-	std::vector<int> onsetDetection(std::vector<short> pcmData);
+public:
+	NoteSegmentor() { init(OnsetConfig()); }
+	explicit NoteSegmentor(const OnsetConfig& config) { init(config); }
+
+	void init(const OnsetConfig& config);
+	void reset(); // forget the stream, keep the config
+
+	const OnsetConfig& config() const { return m_config; }
+	int hop() const { return m_hop; } // hopSeconds in samples at sampleRate
+
+	// Samples in [-1, 1). Appends every onset found so far to out; returns how many were added.
+	std::size_t process(const float* samples, std::size_t count, std::vector<Onset>& out);
+	// PCM16, downmixed to mono.
+	std::size_t process(const short* interleaved, std::size_t frames, int channels, std::vector<Onset>& out);
+	// Pushes silence through the lookahead so the last onsets are decided.
+	std::size_t flush(std::vector<Onset>& out);
+
+	// How long after an onset it is reported.
+	double latencySeconds() const;
+	long long samplesProcessed() const { return m_samples; }
+
+	// Offline: every onset of a whole buffer (mono downmix of the view).
+	static std::vector<Onset> detect(const audiofile::AudioView& audio, const OnsetConfig& config);
+	static std::vector<Onset> detect(const float* samples, std::size_t count, const OnsetConfig& config);
+
+private:
+	void analyzeFrame(std::vector<Onset>& out);
+	void pickPeak(std::vector<Onset>& out);
+	double history(long long frame) const { return m_flux[(std::size_t)(frame % (long long)m_flux.size())]; }
+
+	OnsetConfig m_config;
+	int m_hop = 1;
+	dsp::FftwR2C m_fft;
+	std::vector<double> m_window;
+	std::vector<float> m_input;       // ring of the last frameSize samples
+	std::size_t m_inputPos = 0;       // oldest sample in m_input
+	int m_pending = 0;                // samples since the last frame
+	long long m_samples = 0;
+
+	std::vector<double> m_previous;   // compressed magnitudes of the previous frame
+	double m_magnitudeScale = 1.0;
 
-};
\ No newline at end of file
+	long long m_frame = 0;            // frames analyzed
+	std::vector<double> m_flux;       // ring: flux of the last thresholdFrames + lookaheadFrames + 1 frames
+	dsp::SlidingMedian m_median;      // median and mean of the same window
+	dsp::SlidingMoments m_moments;
+	long long m_lastOnset = -1;       // frame of the last reported onset
+};
@@ -0,0 +1,87 @@
+#include "ParallelLoader.h"
+
+#include <exception>
+#include <utility>
+
+#include "Profiler.h"
+#include "Resampler.h"
+
+namespace audiofile
+{
+    LoadedAudio ParallelLoader::Load(const LoadRequest& request)
+    {
+        LoadedAudio out;
+        out.path = request.path;
+
+        try
+        {
+            if (request.mode != LoadMode::Decode)
+            {
+                std::string mapError;
+                if (out.mapped.Open(request.path, &mapError))
+                {
+                    out.ok = true;
+                    return out;
+                }
+                if (request.mode == LoadMode::MapWav)
+                {
+                    out.error = mapError;
+                    return out;
+                }
+            }
+
+            if (request.decodeCache && request.decodeCache->TryOpen(request.path, out.mapped))
+            {
+                out.ok = true;
+                return out;
+            }
+
+            std::string decodeError;
+            out.ok = AudioFileLoader::LoadPcm16(request.path, out.decoded, &decodeError);
+            if (!out.ok)
+                out.error = decodeError;
+            else if (request.decodeCache)
+                request.decodeCache->Store(request.path, out.decoded); // best effort
+        }
+        catch (const std::exception& e)
+        {
+            out.ok = false;
+            out.error = std::string("Exception while loading ") + request.path + ": " + e.what();
+        }
+        return out;
+    }
+
+    std::future<LoadedAudio> ParallelLoader::LoadAsync(threading::WorkerPool& pool, const LoadRequest& request)
+    {
+        return pool.Submit([request]() { return Load(request); });
+    }
+
+    std::vector<std::future<LoadedAudio>> ParallelLoader::LoadAllAsync(threading::WorkerPool& pool, const std::vector<LoadRequest>& requests)
+    {
+        std::vector<std::future<LoadedAudio>> futures;
+        futures.reserve(requests.size());
+        for (const auto& req : requests)
+            futures.push_back(LoadAsync(pool, req));
+        return futures;
+    }
+
+    void ParallelLoader::ConformSampleRate(LoadedAudio& audio, int sampleRate)
+    {
+        if (!audio.ok || sampleRate <= 0 || audio.SampleRate() <= 0 || audio.SampleRate() == sampleRate)
+            return;
+        WAVEOUT_PROFILE_SCOPE("load.conformRate");
+
+        const Pcm16Span src = audio.Samples();
+        const int channels = audio.Channels();
+        if (channels <= 0) return;
+
+        DecodedPcm16 conformed;
+        conformed.sampleRate = sampleRate;
+        conformed.channels = channels;
+        dsp::resample_pcm16(src.data(), src.size() / static_cast<std::size_t>(channels), channels,
+            audio.SampleRate(), sampleRate, conformed.samples);
+
+        audio.mapped.Close();
+        audio.decoded = std::move(conformed);
+    }
+}
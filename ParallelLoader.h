@@ -0,0 +1,59 @@
+#pragma once
+
+#include <future>
+#include <string>
+#include <vector>
+
+#include "AudioFileLoader.h"
+#include "DecodeCache.h"
+#include "MappedFile.h"
+#include "WorkerPool.h"
+
+namespace audiofile
+{
+    enum class LoadMode
+    {
+        Decode,     // full decode through miniaudio (MP3/FLAC/WAV)
+        MapWav,     // memory-map a PCM16 WAV, fail otherwise
+        MapOrDecode // memory-map when possible, fall back to a full decode (e.g. float/24-bit WAV)
+    };
+
+    struct LoadRequest
+    {
+        std::string path;
+        LoadMode mode = LoadMode::MapOrDecode;
+        DecodeCache* decodeCache = nullptr; // optional; consulted before decoding and filled after
+    };
+
+    // Result of one load. Exactly one of `decoded` / `mapped` backs Samples() when ok is true
+    // (`mapped` is also used for decode-cache hits).
+    // Failures are reported per file so one bad input does not abort the rest.
+    struct LoadedAudio
+    {
+        std::string path;
+        bool ok = false;
+        std::string error;
+        DecodedPcm16 decoded;
+        MappedWavFile mapped;
+
+        Pcm16Span Samples() const { return mapped.IsOpen() ? mapped.Samples() : Pcm16Span(decoded.samples); }
+        int SampleRate() const { return mapped.IsOpen() ? mapped.SampleRate() : decoded.sampleRate; }
+        int Channels() const { return mapped.IsOpen() ? mapped.Channels() : decoded.channels; }
+    };
+
+    class ParallelLoader
+    {
+    public:
+        // Loads a single file synchronously on the calling thread. Never throws.
+        static LoadedAudio Load(const LoadRequest& request);
+
+        // Queues one job per request on the pool; futures are returned in request order.
+        static std::future<LoadedAudio> LoadAsync(threading::WorkerPool& pool, const LoadRequest& request);
+        static std::vector<std::future<LoadedAudio>> LoadAllAsync(threading::WorkerPool& pool, const std::vector<LoadRequest>& requests);
+
+        // Resamples a loaded file to sampleRate (polyphase windowed sinc) so it can be mixed
+        // frame-for-frame with audio at that rate. A mapped file is replaced by the decoded copy.
+        // No-op when the rates already match or the load failed.
+        static void ConformSampleRate(LoadedAudio& audio, int sampleRate);
+    };
+}
@@ -0,0 +1,305 @@
+#include "Profiler.h"
+
+#if defined(WAVEOUT_ENABLE_PROFILING)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace profiling
+{
+    namespace
+    {
+        // Beyond this a thread stops recording trace events (long-running worker loops would grow it forever).
+        constexpr std::size_t kMaxEventsPerThread = std::size_t(1) << 21;
+
+        struct Event
+        {
+            const char* name;
+            std::uint64_t startNs;
+            std::uint64_t durationNs;
+            std::uint64_t bytes;
+        };
+
+        // One per thread that ever recorded something. The owning thread appends under its own
+        // (uncontended) mutex; dumping takes it briefly to copy the data out.
+        struct ThreadBuffer
+        {
+            std::uint32_t tid = 0;
+            std::mutex mutex;
+            std::vector<Event> events;
+            std::unordered_map<const char*, std::int64_t> counters;
+            std::uint64_t dropped = 0;
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> threads;
+            std::uint32_t nextTid = 1;
+            const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+        };
+
+        Registry& GetRegistry()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        std::uint64_t NowNs()
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - GetRegistry().origin).count());
+        }
+
+        ThreadBuffer& LocalBuffer()
+        {
+            // The registry keeps a reference too, so events survive the thread exiting.
+            thread_local std::shared_ptr<ThreadBuffer> local = []() {
+                auto buffer = std::make_shared<ThreadBuffer>();
+                Registry& r = GetRegistry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                buffer->tid = r.nextTid++;
+                r.threads.push_back(buffer);
+                return buffer;
+            }();
+            return *local;
+        }
+
+        thread_local ScopedTimer* t_currentScope = nullptr;
+
+        struct Snapshot
+        {
+            std::vector<std::pair<std::uint32_t, Event>> events;
+            std::map<std::string, std::int64_t> counters;
+            std::uint64_t dropped = 0;
+        };
+
+        Snapshot TakeSnapshot()
+        {
+            Snapshot snap;
+            Registry& r = GetRegistry();
+            std::lock_guard<std::mutex> registryLock(r.mutex);
+            for (const auto& thread : r.threads)
+            {
+                std::lock_guard<std::mutex> lock(thread->mutex);
+                for (const Event& e : thread->events)
+                    snap.events.emplace_back(thread->tid, e);
+                for (const auto& c : thread->counters)
+                    snap.counters[c.first] += c.second;
+                snap.dropped += thread->dropped;
+            }
+            return snap;
+        }
+
+        void AppendJsonString(std::string& out, const char* s)
+        {
+            out += '"';
+            for (; *s; ++s)
+            {
+                const unsigned char c = static_cast<unsigned char>(*s);
+                if (c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += static_cast<char>(c);
+                }
+                else if (c < 0x20)
+                {
+                    char esc[8];
+                    std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+                    out += esc;
+                }
+                else
+                {
+                    out += static_cast<char>(c);
+                }
+            }
+            out += '"';
+        }
+
+        double Percentile(const std::vector<std::uint64_t>& sorted, double p)
+        {
+            if (sorted.empty())
+                return 0.0;
+            const std::size_t idx = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+            return static_cast<double>(sorted[(std::min)(idx, sorted.size() - 1)]);
+        }
+    }
+
+    ScopedTimer::ScopedTimer(const char* name)
+        : m_name(name), m_startNs(NowNs()), m_parent(t_currentScope)
+    {
+        t_currentScope = this;
+    }
+
+    ScopedTimer::~ScopedTimer()
+    {
+        const std::uint64_t end = NowNs();
+        t_currentScope = m_parent;
+
+        ThreadBuffer& buffer = LocalBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if (buffer.events.size() >= kMaxEventsPerThread)
+        {
+            ++buffer.dropped;
+            return;
+        }
+        buffer.events.push_back(Event{ m_name, m_startNs, end - m_startNs, m_bytes });
+    }
+
+    void AddBytes(std::size_t bytes)
+    {
+        if (t_currentScope)
+            t_currentScope->m_bytes += bytes;
+    }
+
+    void AddCount(const char* name, std::int64_t delta)
+    {
+        ThreadBuffer& buffer = LocalBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.counters[name] += delta;
+    }
+
+    void Reset()
+    {
+        Registry& r = GetRegistry();
+        std::lock_guard<std::mutex> registryLock(r.mutex);
+        for (const auto& thread : r.threads)
+        {
+            std::lock_guard<std::mutex> lock(thread->mutex);
+            thread->events.clear();
+            thread->counters.clear();
+            thread->dropped = 0;
+        }
+    }
+
+    bool WriteChromeTrace(const std::filesystem::path& path, std::string* errorMessage)
+    {
+        const Snapshot snap = TakeSnapshot();
+
+        std::string json;
+        json.reserve(snap.events.size() * 96 + 64);
+        json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        char buf[160];
+        bool first = true;
+        for (const auto& entry : snap.events)
+        {
+            const Event& e = entry.second;
+            json += first ? "\n" : ",\n";
+            first = false;
+            json += "{\"name\":";
+            AppendJsonString(json, e.name);
+            std::snprintf(buf, sizeof(buf), ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%llu}}",
+                entry.first, static_cast<double>(e.startNs) / 1000.0, static_cast<double>(e.durationNs) / 1000.0,
+                static_cast<unsigned long long>(e.bytes));
+            json += buf;
+        }
+        json += "\n]}\n";
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            if (errorMessage)
+                *errorMessage = "Failed to open " + path.string() + " for writing";
+            return false;
+        }
+        out.write(json.data(), static_cast<std::streamsize>(json.size()));
+        if (!out)
+        {
+            if (errorMessage)
+                *errorMessage = "Failed to write " + path.string();
+            return false;
+        }
+        return true;
+    }
+
+    std::string FormatSummary()
+    {
+        const Snapshot snap = TakeSnapshot();
+
+        struct Row
+        {
+            std::string name;
+            std::vector<std::uint64_t> durations;
+            std::uint64_t totalNs = 0;
+            std::uint64_t bytes = 0;
+        };
+        std::map<std::string, Row> byName;
+        for (const auto& entry : snap.events)
+        {
+            Row& row = byName[entry.second.name];
+            row.durations.push_back(entry.second.durationNs);
+            row.totalNs += entry.second.durationNs;
+            row.bytes += entry.second.bytes;
+        }
+
+        std::vector<Row> rows;
+        rows.reserve(byName.size());
+        for (auto& kv : byName)
+        {
+            kv.second.name = kv.first;
+            std::sort(kv.second.durations.begin(), kv.second.durations.end());
+            rows.push_back(std::move(kv.second));
+        }
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.totalNs > b.totalNs; });
+
+        std::string out;
+        char line[320];
+        std::snprintf(line, sizeof(line), "  %-36s %9s %11s %10s %10s %10s %10s %10s %12s\n",
+            "scope", "calls", "total ms", "mean ms", "p50 ms", "p95 ms", "p99 ms", "max ms", "bytes");
+        out += line;
+        for (const Row& row : rows)
+        {
+            const double n = static_cast<double>(row.durations.size());
+            std::snprintf(line, sizeof(line), "  %-36.36s %9zu %11.3f %10.3f %10.3f %10.3f %10.3f %10.3f %12llu\n",
+                row.name.c_str(), row.durations.size(),
+                static_cast<double>(row.totalNs) / 1e6,
+                static_cast<double>(row.totalNs) / 1e6 / n,
+                Percentile(row.durations, 0.50) / 1e6,
+                Percentile(row.durations, 0.95) / 1e6,
+                Percentile(row.durations, 0.99) / 1e6,
+                static_cast<double>(row.durations.back()) / 1e6,
+                static_cast<unsigned long long>(row.bytes));
+            out += line;
+        }
+
+        if (!snap.counters.empty())
+        {
+            std::snprintf(line, sizeof(line), "\n  %-36s %14s\n", "counter", "value");
+            out += line;
+            for (const auto& c : snap.counters)
+            {
+                std::snprintf(line, sizeof(line), "  %-36.36s %14lld\n", c.first.c_str(), static_cast<long long>(c.second));
+                out += line;
+            }
+        }
+        if (snap.dropped > 0)
+        {
+            std::snprintf(line, sizeof(line), "\n  (%llu events dropped after the per-thread limit)\n", static_cast<unsigned long long>(snap.dropped));
+            out += line;
+        }
+        return out;
+    }
+
+    bool Dump(const std::filesystem::path& tracePath)
+    {
+        std::cout << "Profile summary:\n" << FormatSummary();
+        std::string err;
+        if (!WriteChromeTrace(tracePath, &err))
+        {
+            std::cerr << err << std::endl;
+            return false;
+        }
+        std::cout << "Profile trace written to " << tracePath.string() << std::endl;
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Lightweight scoped timers and counters for the analysis hot paths.
+//
+// Define WAVEOUT_ENABLE_PROFILING (project-wide; `msbuild /p:WaveOutProfiling=true`) to turn
+// them on. Without it every WAVEOUT_PROFILE_* macro expands to ((void)0) and nothing from this
+// header is referenced, so instrumented code costs nothing in normal builds. When enabled, scopes
+// and counters take a mutex and may allocate: keep them out of the real-time audio callback and
+// anything it calls.
+//
+//   WAVEOUT_PROFILE_SCOPE("filter.lowPass");   // times the enclosing block
+//   WAVEOUT_PROFILE_FUNCTION();                // same, named after the function
+//   WAVEOUT_PROFILE_BYTES(n * sizeof(double)); // charges an allocation to the innermost open scope
+//   WAVEOUT_PROFILE_COUNT("decode.frames", n); // bumps a named counter
+//   WAVEOUT_PROFILE_DUMP("waveout_trace.json");// writes the trace and prints the summary table
+//
+// Scope and counter names must be string literals (they are stored by pointer).
+
+#if defined(WAVEOUT_ENABLE_PROFILING)
+
+namespace profiling
+{
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(const char* name);
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        friend void AddBytes(std::size_t bytes);
+
+        const char* m_name;
+        std::uint64_t m_startNs;
+        std::uint64_t m_bytes = 0;
+        ScopedTimer* m_parent;
+    };
+
+    // Attributes bytes to the innermost ScopedTimer open on this thread (dropped if there is none).
+    void AddBytes(std::size_t bytes);
+
+    void AddCount(const char* name, std::int64_t delta);
+
+    // Discards everything recorded so far, on all threads.
+    void Reset();
+
+    // Chrome trace-event JSON ("X" complete events); open it in chrome://tracing or Perfetto.
+    bool WriteChromeTrace(const std::filesystem::path& path, std::string* errorMessage = nullptr);
+
+    // Per-scope count, total, mean, p50/p95/p99, max and bytes, sorted by total time, then counters.
+    std::string FormatSummary();
+
+    // WriteChromeTrace(path) and print FormatSummary() to stdout.
+    bool Dump(const std::filesystem::path& tracePath);
+}
+
+#define WAVEOUT_PROFILE_CONCAT_INNER(a, b) a##b
+#define WAVEOUT_PROFILE_CONCAT(a, b) WAVEOUT_PROFILE_CONCAT_INNER(a, b)
+#define WAVEOUT_PROFILE_SCOPE(name) ::profiling::ScopedTimer WAVEOUT_PROFILE_CONCAT(waveoutProfileScope_, __LINE__)(name)
+#define WAVEOUT_PROFILE_FUNCTION() WAVEOUT_PROFILE_SCOPE(__FUNCTION__)
+#define WAVEOUT_PROFILE_BYTES(bytes) ::profiling::AddBytes(static_cast<std::size_t>(bytes))
+#define WAVEOUT_PROFILE_COUNT(name, delta) ::profiling::AddCount((name), static_cast<std::int64_t>(delta))
+#define WAVEOUT_PROFILE_DUMP(tracePath) ((void)::profiling::Dump(tracePath))
+
+#else
+
+#define WAVEOUT_PROFILE_SCOPE(name) ((void)0)
+#define WAVEOUT_PROFILE_FUNCTION() ((void)0)
+#define WAVEOUT_PROFILE_BYTES(bytes) ((void)0)
+#define WAVEOUT_PROFILE_COUNT(name, delta) ((void)0)
+#define WAVEOUT_PROFILE_DUMP(tracePath) ((void)0)
+
+#endif
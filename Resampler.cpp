@@ -0,0 +1,353 @@
+// Resampler.cpp
+#include "Resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WAVEOUT_RESAMPLE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define WAVEOUT_RESAMPLE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace dsp
+{
+    static constexpr double RESAMPLE_PI = 3.141592653589793238462643383279502884;
+    static constexpr double KAISER_BETA = 9.0; // ~90 dB stopband
+    static constexpr int MAX_TAPS = 4096;
+
+    namespace
+    {
+        // Zeroth-order modified Bessel function of the first kind (power series).
+        double bessel_i0(double x)
+        {
+            const double q = 0.25 * x * x;
+            double term = 1.0;
+            double sum = 1.0;
+            for (int k = 1; k < 64; ++k)
+            {
+                term *= q / ((double)k * (double)k);
+                sum += term;
+                if (term < sum * 1e-17) break;
+            }
+            return sum;
+        }
+
+        // n is a multiple of 4 (the table is padded with zero taps).
+        inline float dot(const float* h, const float* x, int n)
+        {
+#if defined(WAVEOUT_RESAMPLE_SSE2)
+            __m128 acc0 = _mm_setzero_ps();
+            __m128 acc1 = _mm_setzero_ps();
+            int i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(h + i), _mm_loadu_ps(x + i)));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(h + i + 4), _mm_loadu_ps(x + i + 4)));
+            }
+            if (i < n)
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(h + i), _mm_loadu_ps(x + i)));
+            acc0 = _mm_add_ps(acc0, acc1);
+            acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+            acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+            return _mm_cvtss_f32(acc0);
+#elif defined(WAVEOUT_RESAMPLE_NEON)
+            float32x4_t acc0 = vdupq_n_f32(0.0f);
+            float32x4_t acc1 = vdupq_n_f32(0.0f);
+            int i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                acc0 = vmlaq_f32(acc0, vld1q_f32(h + i), vld1q_f32(x + i));
+                acc1 = vmlaq_f32(acc1, vld1q_f32(h + i + 4), vld1q_f32(x + i + 4));
+            }
+            if (i < n)
+                acc0 = vmlaq_f32(acc0, vld1q_f32(h + i), vld1q_f32(x + i));
+            return vaddvq_f32(vaddq_f32(acc0, acc1));
+#else
+            float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (int i = 0; i < n; i += 4)
+            {
+                acc[0] += h[i] * x[i];
+                acc[1] += h[i + 1] * x[i + 1];
+                acc[2] += h[i + 2] * x[i + 2];
+                acc[3] += h[i + 3] * x[i + 3];
+            }
+            return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+        }
+
+        inline float to_float(float v) { return v; }
+        inline float to_float(short v) { return (float)v * (1.0f / 32768.0f); }
+
+        inline short to_pcm16(float v)
+        {
+            const float s = std::round(v * 32768.0f);
+            if (s >= 32767.0f) return 32767;
+            if (s <= -32768.0f) return -32768;
+            return (short)s;
+        }
+
+        std::uint64_t output_frames(std::size_t frames, int inRate, int outRate)
+        {
+            const std::uint64_t g = (std::uint64_t)std::gcd(inRate, outRate);
+            const std::uint64_t L = (std::uint64_t)outRate / g;
+            const std::uint64_t M = (std::uint64_t)inRate / g;
+            return ((std::uint64_t)frames * L + M - 1) / M;
+        }
+    }
+
+    // -------------------------
+    // PolyphaseResampler
+    // -------------------------
+    bool PolyphaseResampler::init(int inRate, int outRate, int channels, int halfTaps, double cutoff)
+    {
+        m_channels = 0;
+        m_table.clear();
+        m_history.clear();
+        if (inRate <= 0 || outRate <= 0 || channels <= 0) return false;
+
+        const int g = std::gcd(inRate, outRate);
+        m_L = (std::uint32_t)(outRate / g);
+        m_M = (std::uint32_t)(inRate / g);
+        m_phases = (std::min)(m_L, MAX_PHASES);
+
+        // Kernel time is measured in input frames; decimating stretches it by M/L.
+        const double ratio = (std::min)(1.0, (double)m_L / (double)m_M);
+        halfTaps = (std::max)(2, (std::min)(halfTaps, 256));
+        cutoff = (std::min)((std::max)(cutoff, 0.1), 1.0);
+        int taps = 2 * (int)std::ceil((double)halfTaps / ratio);
+        taps = (std::min)((taps + 3) & ~3, MAX_TAPS);
+        m_taps = taps;
+
+        // Row r is the kernel for an output r/phases of a frame past the centre tap, evaluated at
+        // tau = r/phases + taps/2 - 1 - j for tap j. The extra last row (tau offset of a whole
+        // frame) is only reached when phases are rounded. Every row is normalized to unity DC gain.
+        const double fc = ratio * cutoff;
+        const double half = 0.5 * (double)taps;
+        const double invI0Beta = 1.0 / bessel_i0(KAISER_BETA);
+        m_table.assign((std::size_t)(m_phases + 1) * (std::size_t)taps, 0.0f);
+        std::vector<double> row((std::size_t)taps);
+        for (std::uint32_t r = 0; r <= m_phases; ++r)
+        {
+            const double frac = (double)r / (double)m_phases;
+            double sum = 0.0;
+            for (int j = 0; j < taps; ++j)
+            {
+                const double tau = frac + half - 1.0 - (double)j;
+                const double u = tau / half;
+                double v = 0.0;
+                if (std::fabs(u) < 1.0)
+                {
+                    const double x = RESAMPLE_PI * fc * tau;
+                    const double sinc = (std::fabs(x) < 1e-12) ? 1.0 : std::sin(x) / x;
+                    v = fc * sinc * bessel_i0(KAISER_BETA * std::sqrt(1.0 - u * u)) * invI0Beta;
+                }
+                row[(std::size_t)j] = v;
+                sum += v;
+            }
+            const double norm = (std::fabs(sum) > 1e-12) ? 1.0 / sum : 1.0;
+            float* dst = m_table.data() + (std::size_t)r * (std::size_t)taps;
+            for (int j = 0; j < taps; ++j)
+                dst[j] = (float)(row[(std::size_t)j] * norm);
+        }
+
+        m_channels = channels;
+        m_capacity = (std::size_t)taps + BLOCK_FRAMES;
+        m_history.assign(m_capacity * (std::size_t)channels, 0.0f);
+        reset();
+        return true;
+    }
+
+    void PolyphaseResampler::reset()
+    {
+        std::fill(m_history.begin(), m_history.end(), 0.0f);
+        // taps/2 - 1 frames of leading silence put the centre tap of output 0 on input frame 0.
+        m_fill = (std::size_t)(m_taps / 2 - 1);
+        m_start = 0;
+        m_phase = 0;
+        m_totalIn = 0;
+        m_totalOut = 0;
+    }
+
+    std::size_t PolyphaseResampler::max_output(std::size_t inFrames) const
+    {
+        return (std::size_t)((((std::uint64_t)inFrames + (std::uint64_t)m_taps) * m_L) / m_M + 2);
+    }
+
+    std::uint64_t PolyphaseResampler::expected_output() const
+    {
+        return (m_totalIn * m_L + m_M - 1) / m_M;
+    }
+
+    std::size_t PolyphaseResampler::drain(float* out, std::uint64_t limit)
+    {
+        const std::size_t taps = (std::size_t)m_taps;
+        const std::size_t channels = (std::size_t)m_channels;
+        std::size_t count = 0;
+        while (m_start + taps <= m_fill && count < limit)
+        {
+            const std::uint32_t r = (m_phases == m_L)
+                ? m_phase
+                : (std::uint32_t)(((std::uint64_t)m_phase * m_phases + m_L / 2) / m_L);
+            const float* h = m_table.data() + (std::size_t)r * taps;
+            for (std::size_t c = 0; c < channels; ++c)
+                out[count * channels + c] = dot(h, m_history.data() + c * m_capacity + m_start, m_taps);
+            ++count;
+
+            const std::uint64_t next = (std::uint64_t)m_phase + m_M;
+            m_start += (std::size_t)(next / m_L);
+            m_phase = (std::uint32_t)(next % m_L);
+        }
+        m_totalOut += count;
+        return count;
+    }
+
+    void PolyphaseResampler::compact()
+    {
+        const std::size_t shift = (std::min)(m_start, m_fill);
+        if (shift == 0) return;
+        const std::size_t keep = m_fill - shift;
+        for (int c = 0; c < m_channels; ++c)
+        {
+            float* h = m_history.data() + (std::size_t)c * m_capacity;
+            std::memmove(h, h + shift, keep * sizeof(float));
+        }
+        m_fill = keep;
+        m_start -= shift;
+    }
+
+    template <typename Sample>
+    std::size_t PolyphaseResampler::push(const Sample* in, std::size_t frames, float* out)
+    {
+        if (!valid() || !out) return 0;
+        const std::size_t channels = (std::size_t)m_channels;
+        std::size_t produced = 0;
+        std::size_t consumed = 0;
+        while (consumed < frames)
+        {
+            const std::size_t n = (std::min)(frames - consumed, m_capacity - m_fill);
+            for (std::size_t c = 0; c < channels; ++c)
+            {
+                float* h = m_history.data() + c * m_capacity + m_fill;
+                const Sample* src = in + consumed * channels + c;
+                for (std::size_t f = 0; f < n; ++f)
+                    h[f] = to_float(src[f * channels]);
+            }
+            m_fill += n;
+            consumed += n;
+            m_totalIn += n;
+
+            produced += drain(out + produced * channels, std::numeric_limits<std::uint64_t>::max());
+            compact();
+        }
+        return produced;
+    }
+
+    std::size_t PolyphaseResampler::process(const float* in, std::size_t frames, float* out)
+    {
+        return in ? push(in, frames, out) : 0;
+    }
+
+    std::size_t PolyphaseResampler::process(const short* in, std::size_t frames, float* out)
+    {
+        return in ? push(in, frames, out) : 0;
+    }
+
+    void PolyphaseResampler::process(const float* in, std::size_t frames, std::vector<float>& out)
+    {
+        const std::size_t base = out.size();
+        out.resize(base + max_output(frames) * (std::size_t)m_channels);
+        out.resize(base + process(in, frames, out.data() + base) * (std::size_t)m_channels);
+    }
+
+    void PolyphaseResampler::process(const short* in, std::size_t frames, std::vector<float>& out)
+    {
+        const std::size_t base = out.size();
+        out.resize(base + max_output(frames) * (std::size_t)m_channels);
+        out.resize(base + process(in, frames, out.data() + base) * (std::size_t)m_channels);
+    }
+
+    // Pads with silence until every output up to ceil(totalIn * L / M) has its full window.
+    std::size_t PolyphaseResampler::flush(float* out)
+    {
+        if (!valid() || !out) return 0;
+        const std::size_t channels = (std::size_t)m_channels;
+        const std::uint64_t target = expected_output();
+        std::size_t produced = 0;
+        while (m_totalOut < target)
+        {
+            const std::size_t n = m_capacity - m_fill;
+            for (std::size_t c = 0; c < channels; ++c)
+                std::fill_n(m_history.data() + c * m_capacity + m_fill, n, 0.0f);
+            m_fill += n;
+            produced += drain(out + produced * channels, target - m_totalOut);
+            compact();
+        }
+        return produced;
+    }
+
+    void PolyphaseResampler::flush(std::vector<float>& out)
+    {
+        const std::size_t base = out.size();
+        out.resize(base + max_output(0) * (std::size_t)m_channels);
+        out.resize(base + flush(out.data() + base) * (std::size_t)m_channels);
+    }
+
+    // -------------------------
+    // One-shot helpers
+    // -------------------------
+    void resample_pcm16(const short* in, std::size_t frames, int channels, int inRate, int outRate,
+        std::vector<short>& out, int halfTaps)
+    {
+        out.clear();
+        if (!in || frames == 0 || channels <= 0) return;
+        if (inRate == outRate || inRate <= 0 || outRate <= 0)
+        {
+            out.assign(in, in + frames * (std::size_t)channels);
+            return;
+        }
+
+        PolyphaseResampler rs(inRate, outRate, channels, halfTaps);
+        const std::size_t ch = (std::size_t)channels;
+        out.reserve((std::size_t)output_frames(frames, inRate, outRate) * ch);
+
+        // Chunked so the float intermediate stays small even for a whole song.
+        static constexpr std::size_t CHUNK_FRAMES = 1 << 16;
+        std::vector<float> scratch(rs.max_output(CHUNK_FRAMES) * ch);
+        const auto append = [&](std::size_t produced)
+        {
+            for (std::size_t i = 0; i < produced * ch; ++i)
+                out.push_back(to_pcm16(scratch[i]));
+        };
+        for (std::size_t pos = 0; pos < frames; pos += CHUNK_FRAMES)
+            append(rs.process(in + pos * ch, (std::min)(CHUNK_FRAMES, frames - pos), scratch.data()));
+        append(rs.flush(scratch.data()));
+    }
+
+    void resample_float(const float* in, std::size_t frames, int channels, int inRate, int outRate,
+        std::vector<float>& out, int halfTaps)
+    {
+        out.clear();
+        if (!in || frames == 0 || channels <= 0) return;
+        if (inRate == outRate || inRate <= 0 || outRate <= 0)
+        {
+            out.assign(in, in + frames * (std::size_t)channels);
+            return;
+        }
+
+        PolyphaseResampler rs(inRate, outRate, channels, halfTaps);
+        out.reserve((std::size_t)output_frames(frames, inRate, outRate) * (std::size_t)channels + rs.max_output(0) * (std::size_t)channels);
+        rs.process(in, frames, out);
+        rs.flush(out);
+    }
+
+    void decimate(const float* in, std::size_t n, int factor, std::vector<float>& out, int halfTaps)
+    {
+        resample_float(in, n, 1, (std::max)(1, factor), 1, out, halfTaps);
+    }
+}
@@ -0,0 +1,106 @@
+// Resampler.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dsp
+{
+    // -------------------------
+    // Polyphase windowed-sinc sample-rate converter
+    // -------------------------
+    // Converts by the exact rational ratio outRate/inRate (reduced by their gcd to L/M): output
+    // frame n sits at input time n*M/L, and is the dot product of `taps()` input frames with one
+    // of L precomputed Kaiser-windowed sinc phases. The lowpass is placed at `cutoff` times the
+    // lower of the two Nyquist rates, so the same object band-limits for decimation and removes
+    // images for interpolation. Ratios whose L would need an unreasonably large table
+    // (e.g. 44100 -> 47999) round the phase to the nearest of MAX_PHASES instead.
+    //
+    // Streaming: process() can be fed any number of frames at a time and output is aligned to
+    // input frame 0 (no latency to compensate); flush() then emits the tail so the total output
+    // is ceil(inFrames * L / M) frames. init() is the only call that allocates, so process() and
+    // reset() are usable from the real-time audio callback. Channels are interleaved on both
+    // sides, history is kept planar, and the dot products run four taps at a time (SSE / NEON).
+    class PolyphaseResampler
+    {
+    public:
+        static constexpr int DEFAULT_HALF_TAPS = 32;       // playback / stem conforming, ~90 dB
+        static constexpr int ANALYSIS_HALF_TAPS = 12;      // cheap decimation for detectors
+        static constexpr double DEFAULT_CUTOFF = 0.92;     // of the lower Nyquist
+        static constexpr std::uint32_t MAX_PHASES = 1024;
+
+        PolyphaseResampler() = default;
+        PolyphaseResampler(int inRate, int outRate, int channels, int halfTaps = DEFAULT_HALF_TAPS, double cutoff = DEFAULT_CUTOFF)
+        {
+            init(inRate, outRate, channels, halfTaps, cutoff);
+        }
+
+        // halfTaps counts taps on each side of the centre at the lower rate; decimation widens
+        // the kernel by M/L so the transition band stays the same relative to the output rate.
+        // False (and an unusable object) for non-positive rates or channel counts.
+        bool init(int inRate, int outRate, int channels, int halfTaps = DEFAULT_HALF_TAPS, double cutoff = DEFAULT_CUTOFF);
+
+        bool valid() const { return m_channels > 0; }
+        int channels() const { return m_channels; }
+        int taps() const { return m_taps; }
+        std::uint32_t interpolation() const { return m_L; }
+        std::uint32_t decimation() const { return m_M; }
+
+        // Clears the history, as if no input had been seen.
+        void reset();
+
+        // Upper bound on the frames a single process() call can write for inFrames input frames.
+        std::size_t max_output(std::size_t inFrames) const;
+
+        // Consumes frames interleaved input frames and writes up to max_output(frames) interleaved
+        // frames to out; returns the number written. PCM16 input is scaled to [-1, 1).
+        std::size_t process(const float* in, std::size_t frames, float* out);
+        std::size_t process(const short* in, std::size_t frames, float* out);
+
+        // Appending convenience for offline use.
+        void process(const float* in, std::size_t frames, std::vector<float>& out);
+        void process(const short* in, std::size_t frames, std::vector<float>& out);
+
+        // Emits the remaining frames (at most max_output(0)) and leaves the object ready for reset().
+        std::size_t flush(float* out);
+        void flush(std::vector<float>& out);
+
+    private:
+        static constexpr std::size_t BLOCK_FRAMES = 1024;
+
+        template <typename Sample>
+        std::size_t push(const Sample* in, std::size_t frames, float* out);
+        std::size_t drain(float* out, std::uint64_t limit);
+        void compact();
+        std::uint64_t expected_output() const;
+
+        int m_channels = 0;
+        int m_taps = 0;                 // per phase, a multiple of 4
+        std::uint32_t m_L = 1;
+        std::uint32_t m_M = 1;
+        std::uint32_t m_phases = 1;     // rows in m_table minus one (== L unless L > MAX_PHASES)
+        std::vector<float> m_table;     // [(phases + 1)][taps]
+
+        std::size_t m_capacity = 0;     // per channel
+        std::vector<float> m_history;   // [channel][capacity]
+        std::size_t m_fill = 0;         // frames in the history
+        std::size_t m_start = 0;        // first tap of the next output
+        std::uint32_t m_phase = 0;      // next output's position between frames, in 1/L
+        std::uint64_t m_totalIn = 0;
+        std::uint64_t m_totalOut = 0;
+    };
+
+    // -------------------------
+    // One-shot helpers
+    // -------------------------
+    // Whole-buffer conversions; out is resized to exactly ceil(frames * outRate / inRate) frames.
+    void resample_pcm16(const short* in, std::size_t frames, int channels, int inRate, int outRate,
+        std::vector<short>& out, int halfTaps = PolyphaseResampler::DEFAULT_HALF_TAPS);
+    void resample_float(const float* in, std::size_t frames, int channels, int inRate, int outRate,
+        std::vector<float>& out, int halfTaps = PolyphaseResampler::DEFAULT_HALF_TAPS);
+
+    // Anti-aliased mono decimation by an integer factor (4x / 8x for the analysis front end).
+    void decimate(const float* in, std::size_t n, int factor, std::vector<float>& out,
+        int halfTaps = PolyphaseResampler::ANALYSIS_HALF_TAPS);
+}
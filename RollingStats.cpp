@@ -0,0 +1,227 @@
+// RollingStats.cpp
+#include "RollingStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "DSP.h"
+
+namespace dsp
+{
+    // -------------------------
+    // RunningStats
+    // -------------------------
+    void RunningStats::reset()
+    {
+        *this = RunningStats();
+    }
+
+    void RunningStats::push(double x)
+    {
+        ++m_n;
+        const double delta = x - m_mean;
+        m_mean += delta / (double)m_n;
+        m_m2 += delta * (x - m_mean);
+        m_min = (std::min)(m_min, x);
+        m_max = (std::max)(m_max, x);
+    }
+
+    void RunningStats::merge(const RunningStats& other)
+    {
+        if (other.m_n == 0) return;
+        if (m_n == 0)
+        {
+            *this = other;
+            return;
+        }
+        // Chan et al.: combine the two partial sums of squared deviations.
+        const double n = (double)(m_n + other.m_n);
+        const double delta = other.m_mean - m_mean;
+        m_m2 += other.m_m2 + delta * delta * (double)m_n * (double)other.m_n / n;
+        m_mean += delta * (double)other.m_n / n;
+        m_n += other.m_n;
+        m_min = (std::min)(m_min, other.m_min);
+        m_max = (std::max)(m_max, other.m_max);
+    }
+
+    double RunningStats::stddev() const
+    {
+        return std::sqrt(variance());
+    }
+
+    // -------------------------
+    // SlidingMoments
+    // -------------------------
+    void SlidingMoments::init(std::size_t window)
+    {
+        m_ring.assign(window ? window : 1, 0.0);
+        reset();
+    }
+
+    void SlidingMoments::reset()
+    {
+        std::fill(m_ring.begin(), m_ring.end(), 0.0);
+        m_pos = 0;
+        m_count = 0;
+        m_mean = 0.0;
+        m_m2 = 0.0;
+    }
+
+    void SlidingMoments::push(double x)
+    {
+        if (m_ring.empty()) init(1);
+        const std::size_t W = m_ring.size();
+        if (m_count < W)
+        {
+            ++m_count;
+            const double delta = x - m_mean;
+            m_mean += delta / (double)m_count;
+            m_m2 += delta * (x - m_mean);
+        }
+        else
+        {
+            // Replace the oldest value: the mean moves by (x - old) / W and the squared deviations
+            // change by (x - old) * (x - newMean + old - oldMean).
+            const double old = m_ring[m_pos];
+            const double mean = m_mean + (x - old) / (double)W;
+            m_m2 += (x - old) * (x - mean + old - m_mean);
+            m_mean = mean;
+        }
+        m_ring[m_pos] = x;
+        m_pos = (m_pos + 1 == W) ? 0 : m_pos + 1;
+
+        // Once per window, recompute from the ring so rounding cannot build up over long streams;
+        // O(W) every W pushes keeps the step O(1) amortized.
+        if (m_pos == 0 && m_count == W)
+        {
+            double sum = 0.0;
+            for (double v : m_ring) sum += v;
+            m_mean = sum / (double)W;
+            double m2 = 0.0;
+            for (double v : m_ring) m2 += (v - m_mean) * (v - m_mean);
+            m_m2 = m2;
+        }
+    }
+
+    double SlidingMoments::variance() const
+    {
+        return m_count ? (std::max)(0.0, m_m2) / (double)m_count : 0.0;
+    }
+
+    double SlidingMoments::stddev() const
+    {
+        return std::sqrt(variance());
+    }
+
+    // -------------------------
+    // SlidingMedian
+    // -------------------------
+    void SlidingMedian::init(std::size_t window)
+    {
+        m_ring.assign(window ? window : 1, 0.0);
+        reset();
+    }
+
+    void SlidingMedian::reset()
+    {
+        m_pos = 0;
+        m_count = 0;
+        m_low.clear();
+        m_high.clear();
+    }
+
+    void SlidingMedian::erase(double x)
+    {
+        if (std::isnan(x)) return; // never entered the sets
+        if (!m_low.empty() && x <= *m_low.rbegin())
+        {
+            const auto it = m_low.find(x);
+            if (it != m_low.end()) m_low.erase(it);
+        }
+        else
+        {
+            const auto it = m_high.find(x);
+            if (it != m_high.end()) m_high.erase(it);
+        }
+    }
+
+    void SlidingMedian::rebalance()
+    {
+        while (m_low.size() > m_high.size() + 1)
+        {
+            auto top = std::prev(m_low.end());
+            m_high.insert(*top);
+            m_low.erase(top);
+        }
+        while (m_high.size() > m_low.size())
+        {
+            auto bottom = m_high.begin();
+            m_low.insert(*bottom);
+            m_high.erase(bottom);
+        }
+    }
+
+    void SlidingMedian::push(double x)
+    {
+        if (m_ring.empty()) init(1);
+        const std::size_t W = m_ring.size();
+        if (m_count == W)
+            erase(m_ring[m_pos]);
+        else
+            ++m_count;
+
+        // NaN has no rank, so it takes its slot in the ring but stays out of the ordered sets.
+        if (!std::isnan(x))
+        {
+            if (m_low.empty() || x <= *m_low.rbegin())
+                m_low.insert(x);
+            else
+                m_high.insert(x);
+        }
+        rebalance();
+
+        m_ring[m_pos] = x;
+        m_pos = (m_pos + 1 == W) ? 0 : m_pos + 1;
+    }
+
+    double SlidingMedian::median() const
+    {
+        if (m_low.empty()) return 0.0;
+        if (m_low.size() > m_high.size()) return *m_low.rbegin();
+        return 0.5 * (*m_low.rbegin() + *m_high.begin());
+    }
+
+    // -------------------------
+    // Block statistics
+    // -------------------------
+    std::vector<double> block_rms(const float* x, std::size_t n, std::size_t block)
+    {
+        std::vector<double> out;
+        if (!x || n == 0 || block == 0) return out;
+        out.reserve((n + block - 1) / block);
+        for (std::size_t start = 0; start < n; start += block)
+        {
+            out.push_back(rms(x + start, (std::min)(block, n - start)));
+        }
+        return out;
+    }
+
+    void block_min_max(const float* x, std::size_t n, std::size_t block, std::vector<float>& outMin, std::vector<float>& outMax)
+    {
+        outMin.clear();
+        outMax.clear();
+        if (!x || n == 0 || block == 0) return;
+        outMin.reserve((n + block - 1) / block);
+        outMax.reserve((n + block - 1) / block);
+        for (std::size_t start = 0; start < n; start += block)
+        {
+            const std::size_t len = (std::min)(block, n - start);
+            MinMax<float> m;
+            for (std::size_t i = 0; i < len; ++i)
+                m.push(x[start + i]);
+            outMin.push_back(m.min_or_zero());
+            outMax.push_back(m.max_or_zero());
+        }
+    }
+}
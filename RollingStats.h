@@ -0,0 +1,249 @@
+// RollingStats.h
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <set>
+#include <vector>
+
+namespace dsp
+{
+    // -------------------------
+    // Running statistics (Welford)
+    // -------------------------
+    // Count, mean, variance, min and max of everything pushed so far, in one pass and O(1) memory.
+    // Welford's update keeps the variance accurate where sum(x^2) - n*mean^2 cancels, e.g. for
+    // PCM with a large DC offset.
+    class RunningStats
+    {
+    public:
+        void reset();
+        void push(double x);
+        void merge(const RunningStats& other); // as if other's values had been pushed here
+
+        std::size_t count() const { return m_n; }
+        double mean() const { return m_mean; }
+        double variance() const { return m_n ? m_m2 / (double)m_n : 0.0; }     // population
+        double sample_variance() const { return m_n > 1 ? m_m2 / (double)(m_n - 1) : 0.0; }
+        double stddev() const;
+        double min_value() const { return m_min; }
+        double max_value() const { return m_max; }
+
+    private:
+        std::size_t m_n = 0;
+        double m_mean = 0.0;
+        double m_m2 = 0.0;
+        double m_min = std::numeric_limits<double>::infinity();
+        double m_max = -std::numeric_limits<double>::infinity();
+    };
+
+    // -------------------------
+    // Sliding mean / variance
+    // -------------------------
+    // Mean and population variance of the last `window` values. Each push replaces the oldest value
+    // with a Welford-style update, so a step costs O(1) whatever the window. Until the window has
+    // filled, the statistics cover the values pushed so far.
+    class SlidingMoments
+    {
+    public:
+        SlidingMoments() = default;
+        explicit SlidingMoments(std::size_t window) { init(window); }
+
+        void init(std::size_t window);
+        void reset();
+        void push(double x);
+
+        std::size_t window() const { return m_ring.size(); }
+        std::size_t count() const { return m_count; }  // values in the window
+        bool full() const { return m_count == m_ring.size(); }
+        double sum() const { return m_mean * (double)m_count; }
+        double mean() const { return m_mean; }
+        double variance() const;
+        double stddev() const;
+
+    private:
+        std::vector<double> m_ring;
+        std::size_t m_pos = 0;
+        std::size_t m_count = 0;
+        double m_mean = 0.0;
+        double m_m2 = 0.0;
+    };
+
+    // -------------------------
+    // Sliding min / max (monotonic deque)
+    // -------------------------
+    // Extremum of the last `window` values. The deque keeps only values that can still become the
+    // extremum (strictly better than everything pushed after them), so every value is added and
+    // removed once: O(1) amortized per push.
+    template <typename T, typename Better>
+    class SlidingExtremum
+    {
+    public:
+        SlidingExtremum() = default;
+        explicit SlidingExtremum(std::size_t window) { init(window); }
+
+        void init(std::size_t window)
+        {
+            m_window = window ? window : 1;
+            reset();
+        }
+
+        void reset()
+        {
+            m_deque.clear();
+            m_index = 0;
+        }
+
+        void push(T x)
+        {
+            while (!m_deque.empty() && !Better()(m_deque.back().value, x))
+                m_deque.pop_back();
+            m_deque.push_back({ m_index++, x });
+            if (m_deque.front().index + m_window <= m_index - 1)
+                m_deque.pop_front();
+        }
+
+        bool empty() const { return m_deque.empty(); }
+        T value() const { return m_deque.front().value; }
+
+    private:
+        struct Entry
+        {
+            std::size_t index;
+            T value;
+        };
+
+        std::deque<Entry> m_deque;
+        std::size_t m_window = 1;
+        std::size_t m_index = 0;
+    };
+
+    template <typename T>
+    using SlidingMin = SlidingExtremum<T, std::less<T>>;
+    template <typename T>
+    using SlidingMax = SlidingExtremum<T, std::greater<T>>;
+
+    // -------------------------
+    // Sliding median (two balanced multisets)
+    // -------------------------
+    // Median of the last `window` values: the lower half sits in one ordered set, the upper half in
+    // another, and the halves are rebalanced after every insert/erase. O(log window) per push. For
+    // an even count the median is the mean of the two middle values. A NaN still occupies its slot,
+    // so the window stays the last `window` pushes; the median is taken over the non-NaN values in
+    // it (0 when there are none).
+    class SlidingMedian
+    {
+    public:
+        SlidingMedian() = default;
+        explicit SlidingMedian(std::size_t window) { init(window); }
+
+        void init(std::size_t window);
+        void reset();
+        void push(double x);
+
+        std::size_t window() const { return m_ring.size(); }
+        std::size_t count() const { return m_count; }
+        double median() const;
+
+    private:
+        void erase(double x);
+        void rebalance();
+
+        std::vector<double> m_ring;
+        std::size_t m_pos = 0;
+        std::size_t m_count = 0;
+        std::multiset<double> m_low;   // the smaller ceil(count / 2) values
+        std::multiset<double> m_high;
+    };
+
+    // -------------------------
+    // Block min / max accumulator
+    // -------------------------
+    // Per-block (tumbling window) extremes, e.g. one waveform envelope column. An empty block reads 0.
+    template <typename T>
+    struct MinMax
+    {
+        T lo = (std::numeric_limits<T>::max)();
+        T hi = std::numeric_limits<T>::lowest();
+
+        void reset() { *this = MinMax(); }
+        void push(T x)
+        {
+            if (x < lo) lo = x;
+            if (x > hi) hi = x;
+        }
+        bool empty() const { return lo > hi; }
+        T min_or_zero() const { return empty() ? T(0) : lo; }
+        T max_or_zero() const { return empty() ? T(0) : hi; }
+    };
+
+    // -------------------------
+    // Batch APIs
+    // -------------------------
+    // out[i] covers the trailing window x[i - window + 1 .. i] (fewer values for i < window - 1).
+    // `out` arrays hold n values; n * O(1) (O(log window) for the median) in total.
+    template <typename In>
+    void sliding_mean_variance(const In* x, std::size_t n, std::size_t window, double* outMean, double* outVariance)
+    {
+        SlidingMoments m(window);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            m.push((double)x[i]);
+            if (outMean) outMean[i] = m.mean();
+            if (outVariance) outVariance[i] = m.variance();
+        }
+    }
+
+    template <typename In>
+    void sliding_min(const In* x, std::size_t n, std::size_t window, In* out)
+    {
+        SlidingMin<In> m(window);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            m.push(x[i]);
+            out[i] = m.value();
+        }
+    }
+
+    template <typename In>
+    void sliding_max(const In* x, std::size_t n, std::size_t window, In* out)
+    {
+        SlidingMax<In> m(window);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            m.push(x[i]);
+            out[i] = m.value();
+        }
+    }
+
+    template <typename In>
+    void sliding_median(const In* x, std::size_t n, std::size_t window, double* out)
+    {
+        SlidingMedian m(window);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            m.push((double)x[i]);
+            out[i] = m.median();
+        }
+    }
+
+    // Tumbling blocks: block b covers x[b * block .. (b + 1) * block), the last one may be short.
+    // Both return ceil(n / block) values.
+    std::vector<double> block_rms(const float* x, std::size_t n, std::size_t block);
+    void block_min_max(const float* x, std::size_t n, std::size_t block, std::vector<float>& outMin, std::vector<float>& outMax);
+
+    // Largest |x[i]| (0 for an empty array).
+    template <typename In>
+    double peak_abs(const In* x, std::size_t n)
+    {
+        double peak = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const double v = (double)x[i] < 0.0 ? -(double)x[i] : (double)x[i];
+            if (v > peak) peak = v;
+        }
+        return peak;
+    }
+}
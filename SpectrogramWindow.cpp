@@ -293,11 +293,11 @@ static void ComputeSpectrumDbAtFrame(SpectrogramThreadParam* tp, double centerFr
     for (int i = 0; i < nfft; ++i)
     {
         const double s = tp->analysisMono[static_cast<std::size_t>(i)] - mean; // remove DC offset before FFT
-        tp->fft.in()[i] = s * tp->window[static_cast<std::size_t>(i)];
+        tp->fft.in()[i] = static_cast<dsp::fft_real>(s * tp->window[static_cast<std::size_t>(i)]);
     }
     tp->fft.execute();
 
-    const fftw_complex* X = tp->fft.out();
+    const dsp::FftwR2C::Complex* X = tp->fft.out();
     const double nyquist = 0.5 * tp->sampleRate;
     const double fMin = std::max(1.0, tp->minFreqHz);
     const double fMax = std::clamp(tp->maxFreqHz, fMin + 1.0, nyquist);
@@ -1523,10 +1523,10 @@ static void ComputePianoSpectrogramColumn(PianoSpectrogramThreadParam* tp, doubl
     mean /= (double)nfft;
 
     for (int i = 0; i < nfft; ++i)
-        tp->fft.in()[i] = (tp->analysisMono[(std::size_t)i] - mean) * tp->window[(std::size_t)i];
+        tp->fft.in()[i] = (dsp::fft_real)((tp->analysisMono[(std::size_t)i] - mean) * tp->window[(std::size_t)i]);
     tp->fft.execute();
 
-    const fftw_complex* X = tp->fft.out();
+    const dsp::FftwR2C::Complex* X = tp->fft.out();
     if (!X) return;
 
     const double nyquist = 0.5 * (double)tp->sampleRate;
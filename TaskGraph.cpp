@@ -0,0 +1,207 @@
+#include "TaskGraph.h"
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+
+namespace threading
+{
+    struct TaskGraph::State
+    {
+        struct Node
+        {
+            std::function<void()> fn;
+            std::vector<TaskId> dependents;
+            std::size_t pendingDependencies = 0;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<StageTiming> timings;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<TaskId> ready;
+        std::size_t remaining = 0;
+        std::size_t helpersQueued = 0;
+        bool failed = false;
+        bool started = false;
+        std::string error;
+        std::chrono::steady_clock::time_point origin;
+        double totalMs = 0.0;
+
+        double MsSinceOrigin() const
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+        }
+
+        // Pops and runs one ready task. Returns false if nothing was ready.
+        bool RunOne(std::unique_lock<std::mutex>& lock)
+        {
+            if (ready.empty())
+                return false;
+
+            const TaskId id = ready.front();
+            ready.pop_front();
+            std::function<void()> fn = std::move(nodes[id].fn);
+
+            bool ok = true;
+            std::string taskError;
+            if (failed)
+            {
+                fn = nullptr;
+            }
+            else
+            {
+                lock.unlock();
+                const double start = MsSinceOrigin();
+                try
+                {
+                    fn();
+                }
+                catch (const std::exception& e)
+                {
+                    ok = false;
+                    taskError = e.what();
+                }
+                catch (...)
+                {
+                    ok = false;
+                    taskError = "unknown exception";
+                }
+                const double end = MsSinceOrigin();
+                fn = nullptr; // release captures before the caller can observe completion
+                lock.lock();
+
+                timings[id].ran = true;
+                timings[id].failed = !ok;
+                timings[id].startMs = start;
+                timings[id].durationMs = end - start;
+                if (!ok && !failed)
+                {
+                    failed = true;
+                    error = timings[id].name + ": " + taskError;
+                }
+            }
+
+            for (TaskId dep : nodes[id].dependents)
+            {
+                if (--nodes[dep].pendingDependencies == 0)
+                    ready.push_back(dep);
+            }
+            --remaining;
+            cv.notify_all();
+            return true;
+        }
+    };
+
+    TaskGraph::TaskGraph()
+        : m_state(std::make_shared<State>())
+    {
+    }
+
+    TaskGraph::TaskId TaskGraph::Add(std::string name, std::function<void()> fn, std::vector<TaskId> dependencies)
+    {
+        State& s = *m_state;
+        const TaskId id = s.nodes.size();
+        for (TaskId dep : dependencies)
+        {
+            if (dep >= id)
+                throw std::invalid_argument("TaskGraph: task '" + name + "' depends on a task that was not added yet");
+            s.nodes[dep].dependents.push_back(id);
+        }
+
+        State::Node node;
+        node.fn = std::move(fn);
+        node.pendingDependencies = dependencies.size();
+        s.nodes.push_back(std::move(node));
+
+        StageTiming timing;
+        timing.name = std::move(name);
+        s.timings.push_back(std::move(timing));
+        return id;
+    }
+
+    bool TaskGraph::Run(WorkerPool* pool, std::string* errorMessage)
+    {
+        std::shared_ptr<State> state = m_state;
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (state->started)
+        {
+            if (errorMessage)
+                *errorMessage = "TaskGraph: Run() called twice";
+            return false;
+        }
+        state->started = true;
+        state->origin = std::chrono::steady_clock::now();
+        state->remaining = state->nodes.size();
+        for (TaskId id = 0; id < state->nodes.size(); ++id)
+        {
+            if (state->nodes[id].pendingDependencies == 0)
+                state->ready.push_back(id);
+        }
+
+        // The calling thread takes one ready task itself; the rest are offered to the pool.
+        // Helpers are best effort: one that gets scheduled after the work is gone just returns.
+        // They hold the state by shared_ptr, so they may safely outlive Run() and the graph.
+        auto offerToPool = [&]() {
+            if (!pool)
+                return;
+            while (state->helpersQueued + 1 < state->ready.size())
+            {
+                ++state->helpersQueued;
+                pool->Submit([state]() {
+                    std::unique_lock<std::mutex> helperLock(state->mutex);
+                    --state->helpersQueued;
+                    while (state->RunOne(helperLock)) {}
+                });
+            }
+        };
+
+        while (state->remaining > 0)
+        {
+            offerToPool();
+            if (!state->RunOne(lock))
+            {
+                // Everything ready is taken; wait for a running task to finish or release more work.
+                state->cv.wait(lock, [&]() { return state->remaining == 0 || !state->ready.empty(); });
+            }
+        }
+
+        state->totalMs = state->MsSinceOrigin();
+        if (state->failed && errorMessage)
+            *errorMessage = state->error;
+        return !state->failed;
+    }
+
+    void TaskGraph::RunOrThrow(WorkerPool* pool)
+    {
+        std::string error;
+        if (!Run(pool, &error))
+            throw std::runtime_error(error);
+    }
+
+    std::vector<TaskGraph::StageTiming> TaskGraph::Timings() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->timings;
+    }
+
+    std::string TaskGraph::FormatTimings() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        std::string out;
+        char line[256];
+        for (const StageTiming& t : m_state->timings)
+        {
+            if (t.ran)
+                std::snprintf(line, sizeof(line), "  %-24s %9.1f ms  (at +%.1f ms)%s\n", t.name.c_str(), t.durationMs, t.startMs, t.failed ? "  FAILED" : "");
+            else
+                std::snprintf(line, sizeof(line), "  %-24s   skipped\n", t.name.c_str());
+            out += line;
+        }
+        std::snprintf(line, sizeof(line), "  %-24s %9.1f ms\n", "total (wall)", m_state->totalMs);
+        out += line;
+        return out;
+    }
+}
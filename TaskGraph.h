@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "WorkerPool.h"
+
+namespace threading
+{
+    // Small dependency-graph executor for pipeline stages.
+    //
+    // Each task names the tasks it consumes; a task becomes ready as soon as all of them have
+    // finished, so independent stages run side by side on the pool. Tasks can only depend on
+    // tasks added before them, which keeps the graph acyclic by construction.
+    //
+    // Run() also executes ready tasks on the calling thread and never blocks on queued pool
+    // work, so it is safe to call from inside a job of the same pool (batch mode does this).
+    // If a task throws, tasks that have not started yet are skipped and Run() returns false.
+    class TaskGraph
+    {
+    public:
+        using TaskId = std::size_t;
+
+        struct StageTiming
+        {
+            std::string name;
+            double startMs = 0.0;    // relative to the start of Run()
+            double durationMs = 0.0;
+            bool ran = false;        // false if skipped after an earlier failure
+            bool failed = false;
+        };
+
+        TaskGraph();
+
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        TaskId Add(std::string name, std::function<void()> fn, std::vector<TaskId> dependencies = {});
+
+        // pool may be null, in which case every task runs on the calling thread in dependency order.
+        // A graph can be run once.
+        bool Run(WorkerPool* pool, std::string* errorMessage = nullptr);
+
+        // Run() for data-parallel kernels without an error channel of their own: a failed task
+        // becomes a std::runtime_error carrying its message, as the serial path would have thrown.
+        void RunOrThrow(WorkerPool* pool);
+
+        // One entry per task, in Add() order. Valid after Run().
+        std::vector<StageTiming> Timings() const;
+
+        // "name  12.3 ms" lines plus the wall-clock total.
+        std::string FormatTimings() const;
+
+    private:
+        struct State;
+        std::shared_ptr<State> m_state;
+    };
+}
@@ -1,5 +1,7 @@
 #include "Util.h"
 #include "GLOBAL.h"
+#include "RollingStats.h"
+#include "WavWriter.h"
 #include <iostream>
 #include <cmath>
 std::string Util::getEnumString(Keys key) 
@@ -24,14 +26,28 @@ std::string Util::getEnumString(Key key)
     }
     return "";
 }
-std::vector<double> Util::dX(std::vector<double> data)
+void Util::createWavFile(const std::vector<short>& pcmData, int sampleRate, const std::string& fileName)
 {
-    vector<double> dx;
-    double dt = 1 / static_cast<double> (GLOBAL::sampleRate);
-    for (int i = 1; i < data.size(); i++)
+	std::string err;
+	if (!audiofile::WavWriter::WritePcm16File(fileName, pcmData, sampleRate, 2, &err))
+		std::cout << "createWavFile failed: " << err << std::endl;
+}
+void Util::createWavFileMono(const std::vector<short>& pcmData, int sampleRate, const std::string& fileName)
+{
+	std::string err;
+	if (!audiofile::WavWriter::WritePcm16File(fileName, pcmData, sampleRate, 1, &err))
+		std::cout << "createWavFileMono failed: " << err << std::endl;
+}
+std::vector<double> Util::dX(const std::vector<double>& data, const analysis::AnalysisContext& ctx)
+{
+    // x[i] - x[i-1] over dt, written straight into the result instead of a copy of the input.
+    const double rate = static_cast<double>(ctx.sampleRate);
+    if (data.size() < 2)
+        return vector<double>();
+    vector<double> dx(data.size() - 1);
+    for (size_t i = 1; i < data.size(); i++)
     {
-        dx.push_back((data[i] - data[i - 1]) / dt);
-        //cout << "THIS IS RES: "<<data[i] - data[i - 1] <<" /|\\ This is data[i] "<<data[i]<<" This is data[i-1] "<<data[i-1] << endl;
+        dx[i - 1] = (data[i] - data[i - 1]) * rate;
     }
     return dx;
 }
@@ -116,9 +132,9 @@ std::vector<short> Util::doubleToShortScaled(const std::vector<double>& input)
 
     return output;
 }
-std::vector<double> Util::integrate(vector<double>& data)
+std::vector<double> Util::integrate(const vector<double>& data, const analysis::AnalysisContext& ctx)
 {
-    double dt = 1 / (static_cast<double>(GLOBAL::sampleRate));
+    double dt = 1 / (static_cast<double>(ctx.sampleRate));
     int n = data.size();
     if (n <= 1) {
         std::cerr << "Error: Data vector must have more than one element." << std::endl;
@@ -180,47 +196,29 @@ void Util::createRawFile(vector<double>& data, const string& filename)
     }
     out.close();
 }
-std::vector<int> Util::noteSegmentation(vector<short> &left, vector<short> &right, vector<short> mono)
+std::vector<int> Util::noteSegmentation(const vector<short>& left, const vector<short>& right, const vector<short>& mono)
 {
     //Running average and compare to see if audio sample is n stdev away from avg
-    int windowSize = 48000;
-    double thresholdMultiplier = 3;
-    std::vector<int> lol;
+    //The window mean/variance slide in O(1) per sample, so the pass is O(N) instead of O(N * window).
+    const int windowSize = 48000;
+    const double thresholdMultiplier = 3;
+    std::vector<int> anomalies;
     if (mono.empty() || windowSize <= 0 || mono.size() < static_cast<size_t>(windowSize)) {
         std::cerr << "Invalid input data or window size." << std::endl;
+        return anomalies;
     }
 
-    double sum = 0.0;
-
-    for (int i = 0; i < windowSize; ++i) {
-        sum += mono[i];
-    }
-
-    for (size_t i = windowSize; i < mono.size(); ++i) {
-        double old = mono[i - windowSize];
-        sum = sum - old + mono[i];
-
-        double average = sum / windowSize;
-        double variance = 0.0;
+    dsp::SlidingMoments window(static_cast<size_t>(windowSize));
+    for (size_t i = 0; i < mono.size(); ++i) {
+        window.push(mono[i]);
+        if (i < static_cast<size_t>(windowSize))
+            continue;
 
-        for (int j = i - windowSize + 1; j <= static_cast<int>(i); ++j) {
-            double diff = mono[j] - average;
-            variance += diff * diff;
-        }
-
-        variance /= windowSize;
-
-        double stdDev = sqrt(variance);
-
-        if (std::abs(mono[i] - average) > thresholdMultiplier * stdDev) {
-            std::cout << "Anomaly detected at index " << i << ": " << mono[i] << std::endl;
+        if (std::abs(mono[i] - window.mean()) > thresholdMultiplier * window.stddev()) {
+            anomalies.push_back(static_cast<int>(i));
         }
     }
 
-
-    return lol;
-
-
+    std::cout << "Anomalies detected: " << anomalies.size() << std::endl;
+    return anomalies;
 }
-
-
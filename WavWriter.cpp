@@ -0,0 +1,369 @@
+#include "WavWriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "DSP.h"
+
+namespace audiofile
+{
+    namespace
+    {
+        static void SetError(std::string* outErr, const std::string& msg)
+        {
+            if (outErr) *outErr = msg;
+        }
+
+        static void put_u16le(unsigned char* p, std::uint16_t v)
+        {
+            p[0] = static_cast<unsigned char>(v & 0xFF);
+            p[1] = static_cast<unsigned char>((v >> 8) & 0xFF);
+        }
+
+        static void put_u32le(unsigned char* p, std::uint32_t v)
+        {
+            for (int i = 0; i < 4; ++i)
+                p[i] = static_cast<unsigned char>((v >> (8 * i)) & 0xFF);
+        }
+
+        static void put_u64le(unsigned char* p, std::uint64_t v)
+        {
+            for (int i = 0; i < 8; ++i)
+                p[i] = static_cast<unsigned char>((v >> (8 * i)) & 0xFF);
+        }
+
+        static void put_s24le(unsigned char* p, std::int32_t v)
+        {
+            p[0] = static_cast<unsigned char>(v & 0xFF);
+            p[1] = static_cast<unsigned char>((v >> 8) & 0xFF);
+            p[2] = static_cast<unsigned char>((v >> 16) & 0xFF);
+        }
+
+        static int BytesPerSample(WavSampleFormat f)
+        {
+            switch (f)
+            {
+            case WavSampleFormat::Pcm24: return 3;
+            case WavSampleFormat::Float32: return 4;
+            default: return 2;
+            }
+        }
+
+        constexpr std::size_t kBufferBytes = 1u << 20; // 1 MiB staging buffer
+        constexpr std::uint32_t kDs64PayloadBytes = 28; // riffSize, dataSize, sampleCount (u64), tableLength (u32)
+        constexpr unsigned short kWaveFormatPcm = 1;
+        constexpr unsigned short kWaveFormatIeeeFloat = 3;
+    }
+
+    WavWriter::WavWriter() = default;
+
+    WavWriter::~WavWriter()
+    {
+        if (IsOpen())
+            Finalize();
+    }
+
+    bool WavWriter::Open(const std::filesystem::path& path, int sampleRate, int channels, WavSampleFormat format, std::string* errorMessage)
+    {
+        if (IsOpen())
+            Finalize();
+
+        if (sampleRate <= 0 || (channels != 1 && channels != 2))
+        {
+            SetError(errorMessage, "WavWriter supports mono or stereo with a positive sample rate.");
+            return false;
+        }
+
+        m_out.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_out)
+        {
+            SetError(errorMessage, "Failed to open for writing: " + path.string());
+            return false;
+        }
+
+        m_format = format;
+        m_sampleRate = sampleRate;
+        m_channels = channels;
+        m_framesWritten = 0;
+        m_dataBytes = 0;
+        m_factOffset = 0;
+        m_failed = false;
+        m_buffer.resize(kBufferBytes);
+        m_bufferUsed = 0;
+
+        const int bytesPerSample = BytesPerSample(format);
+        const bool isFloat = (format == WavSampleFormat::Float32);
+        const std::uint16_t blockAlign = static_cast<std::uint16_t>(channels * bytesPerSample);
+
+        // RIFF + JUNK(ds64 placeholder) + fmt (+ fact for float) + data header.
+        unsigned char hdr[12 + 8 + kDs64PayloadBytes + 8 + 18 + 12 + 8] = {};
+        std::size_t pos = 0;
+        std::memcpy(hdr + pos, "RIFF", 4); pos += 4;
+        put_u32le(hdr + pos, 0); pos += 4; // patched in Finalize
+        std::memcpy(hdr + pos, "WAVE", 4); pos += 4;
+
+        std::memcpy(hdr + pos, "JUNK", 4); pos += 4;
+        put_u32le(hdr + pos, kDs64PayloadBytes); pos += 4;
+        pos += kDs64PayloadBytes;
+
+        const std::uint32_t fmtSize = isFloat ? 18u : 16u;
+        std::memcpy(hdr + pos, "fmt ", 4); pos += 4;
+        put_u32le(hdr + pos, fmtSize); pos += 4;
+        put_u16le(hdr + pos, isFloat ? kWaveFormatIeeeFloat : kWaveFormatPcm); pos += 2;
+        put_u16le(hdr + pos, static_cast<std::uint16_t>(channels)); pos += 2;
+        put_u32le(hdr + pos, static_cast<std::uint32_t>(sampleRate)); pos += 4;
+        put_u32le(hdr + pos, static_cast<std::uint32_t>(sampleRate) * blockAlign); pos += 4;
+        put_u16le(hdr + pos, blockAlign); pos += 2;
+        put_u16le(hdr + pos, static_cast<std::uint16_t>(bytesPerSample * 8)); pos += 2;
+        if (isFloat)
+        {
+            put_u16le(hdr + pos, 0); pos += 2; // cbSize
+
+            std::memcpy(hdr + pos, "fact", 4); pos += 4;
+            put_u32le(hdr + pos, 4); pos += 4;
+            m_factOffset = pos;
+            put_u32le(hdr + pos, 0); pos += 4; // frame count, patched in Finalize
+        }
+
+        std::memcpy(hdr + pos, "data", 4); pos += 4;
+        m_dataSizeOffset = pos;
+        put_u32le(hdr + pos, 0); pos += 4;
+
+        m_out.write(reinterpret_cast<const char*>(hdr), static_cast<std::streamsize>(pos));
+        if (!m_out)
+        {
+            m_out.close();
+            SetError(errorMessage, "Failed to write WAV header: " + path.string());
+            return false;
+        }
+        return true;
+    }
+
+    bool WavWriter::FlushBuffer()
+    {
+        if (m_bufferUsed == 0)
+            return !m_failed;
+        m_out.write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<std::streamsize>(m_bufferUsed));
+        m_bufferUsed = 0;
+        if (!m_out)
+            m_failed = true;
+        return !m_failed;
+    }
+
+    template <typename Convert>
+    bool WavWriter::AppendConverted(std::size_t sampleCount, Convert&& convertOne)
+    {
+        if (!IsOpen() || m_failed)
+            return false;
+
+        const std::size_t bps = static_cast<std::size_t>(BytesPerSample(m_format));
+        std::size_t i = 0;
+        while (i < sampleCount)
+        {
+            if (m_bufferUsed + bps > m_buffer.size() && !FlushBuffer())
+                return false;
+
+            const std::size_t room = (m_buffer.size() - m_bufferUsed) / bps;
+            const std::size_t n = (std::min)(room, sampleCount - i);
+            unsigned char* dst = m_buffer.data() + m_bufferUsed;
+            for (std::size_t k = 0; k < n; ++k, dst += bps)
+                convertOne(i + k, dst);
+            m_bufferUsed += n * bps;
+            i += n;
+        }
+
+        m_dataBytes += static_cast<std::uint64_t>(sampleCount) * bps;
+        m_framesWritten += sampleCount / static_cast<std::size_t>(m_channels);
+        return true;
+    }
+
+    bool WavWriter::AppendPcm16(const short* interleaved, std::size_t frameCount)
+    {
+        if (!interleaved || frameCount == 0)
+            return IsOpen() && !m_failed;
+
+        const std::size_t count = frameCount * static_cast<std::size_t>(m_channels);
+        switch (m_format)
+        {
+        case WavSampleFormat::Pcm24:
+            return AppendConverted(count, [&](std::size_t i, unsigned char* dst)
+            {
+                put_s24le(dst, static_cast<std::int32_t>(interleaved[i]) * 256);
+            });
+        case WavSampleFormat::Float32:
+            return AppendConverted(count, [&](std::size_t i, unsigned char* dst)
+            {
+                const float v = static_cast<float>(interleaved[i]) / 32768.0f;
+                std::memcpy(dst, &v, sizeof(v));
+            });
+        default:
+            break;
+        }
+
+        // Same layout as the file (little-endian PCM16): copy whole runs.
+        if (!IsOpen() || m_failed)
+            return false;
+        const unsigned char* src = reinterpret_cast<const unsigned char*>(interleaved);
+        std::size_t bytesLeft = count * sizeof(short);
+        while (bytesLeft > 0)
+        {
+            if (m_bufferUsed == m_buffer.size() && !FlushBuffer())
+                return false;
+            const std::size_t n = (std::min)(bytesLeft, m_buffer.size() - m_bufferUsed);
+            std::memcpy(m_buffer.data() + m_bufferUsed, src, n);
+            m_bufferUsed += n;
+            src += n;
+            bytesLeft -= n;
+        }
+        m_dataBytes += static_cast<std::uint64_t>(count) * sizeof(short);
+        m_framesWritten += frameCount;
+        return true;
+    }
+
+    bool WavWriter::AppendPcm16(Pcm16Span interleaved)
+    {
+        if (m_channels <= 0)
+            return false;
+        return AppendPcm16(interleaved.data(), interleaved.size() / static_cast<std::size_t>(m_channels));
+    }
+
+    bool WavWriter::AppendFloat(const float* interleaved, std::size_t frameCount)
+    {
+        if (!interleaved || frameCount == 0)
+            return IsOpen() && !m_failed;
+
+        const std::size_t count = frameCount * static_cast<std::size_t>(m_channels);
+        switch (m_format)
+        {
+        case WavSampleFormat::Pcm24:
+            return AppendConverted(count, [&](std::size_t i, unsigned char* dst)
+            {
+                put_s24le(dst, dsp::float_to_pcm24(interleaved[i]));
+            });
+        case WavSampleFormat::Float32:
+            return AppendConverted(count, [&](std::size_t i, unsigned char* dst)
+            {
+                std::memcpy(dst, &interleaved[i], sizeof(float));
+            });
+        default:
+            return AppendConverted(count, [&](std::size_t i, unsigned char* dst)
+            {
+                put_u16le(dst, static_cast<std::uint16_t>(dsp::float_to_pcm16(interleaved[i])));
+            });
+        }
+    }
+
+    bool WavWriter::AppendDouble(const double* interleaved, std::size_t frameCount)
+    {
+        if (!interleaved || frameCount == 0)
+            return IsOpen() && !m_failed;
+
+        const std::size_t count = frameCount * static_cast<std::size_t>(m_channels);
+        switch (m_format)
+        {
+        case WavSampleFormat::Pcm24:
+            return AppendConverted(count, [&](std::size_t i, unsigned char* dst)
+            {
+                put_s24le(dst, dsp::float_to_pcm24(interleaved[i]));
+            });
+        case WavSampleFormat::Float32:
+            return AppendConverted(count, [&](std::size_t i, unsigned char* dst)
+            {
+                const float v = static_cast<float>(interleaved[i]);
+                std::memcpy(dst, &v, sizeof(v));
+            });
+        default:
+            return AppendConverted(count, [&](std::size_t i, unsigned char* dst)
+            {
+                put_u16le(dst, static_cast<std::uint16_t>(dsp::float_to_pcm16(interleaved[i])));
+            });
+        }
+    }
+
+    bool WavWriter::Finalize(std::string* errorMessage)
+    {
+        if (!IsOpen())
+            return false;
+
+        bool ok = FlushBuffer();
+
+        // RIFF chunks are word aligned.
+        if (ok && (m_dataBytes & 1u))
+        {
+            const char pad = 0;
+            m_out.write(&pad, 1);
+            ok = static_cast<bool>(m_out);
+        }
+
+        const std::uint64_t fileBytes = m_dataSizeOffset + 4u + m_dataBytes + (m_dataBytes & 1u);
+        const std::uint64_t riffSize = fileBytes - 8u;
+        const bool needsRf64 = riffSize > 0xFFFFFFFFull || m_dataBytes > 0xFFFFFFFFull;
+
+        unsigned char b4[4] = {};
+        if (ok)
+        {
+            if (needsRf64)
+            {
+                m_out.seekp(0, std::ios::beg);
+                m_out.write("RF64", 4);
+                put_u32le(b4, 0xFFFFFFFFu);
+                m_out.write(reinterpret_cast<const char*>(b4), 4);
+
+                unsigned char ds64[8 + kDs64PayloadBytes] = {};
+                std::memcpy(ds64, "ds64", 4);
+                put_u32le(ds64 + 4, kDs64PayloadBytes);
+                put_u64le(ds64 + 8, riffSize);
+                put_u64le(ds64 + 16, m_dataBytes);
+                put_u64le(ds64 + 24, m_framesWritten);
+                put_u32le(ds64 + 32, 0); // no table entries
+                m_out.seekp(12, std::ios::beg);
+                m_out.write(reinterpret_cast<const char*>(ds64), sizeof(ds64));
+
+                m_out.seekp(static_cast<std::streamoff>(m_dataSizeOffset), std::ios::beg);
+                m_out.write(reinterpret_cast<const char*>(b4), 4);
+            }
+            else
+            {
+                m_out.seekp(4, std::ios::beg);
+                put_u32le(b4, static_cast<std::uint32_t>(riffSize));
+                m_out.write(reinterpret_cast<const char*>(b4), 4);
+
+                m_out.seekp(static_cast<std::streamoff>(m_dataSizeOffset), std::ios::beg);
+                put_u32le(b4, static_cast<std::uint32_t>(m_dataBytes));
+                m_out.write(reinterpret_cast<const char*>(b4), 4);
+            }
+
+            if (m_factOffset != 0)
+            {
+                m_out.seekp(static_cast<std::streamoff>(m_factOffset), std::ios::beg);
+                put_u32le(b4, static_cast<std::uint32_t>((std::min)(m_framesWritten, static_cast<std::uint64_t>(0xFFFFFFFFu))));
+                m_out.write(reinterpret_cast<const char*>(b4), 4);
+            }
+            ok = static_cast<bool>(m_out);
+        }
+
+        m_out.close();
+        m_buffer.clear();
+        m_buffer.shrink_to_fit();
+        m_bufferUsed = 0;
+
+        if (!ok)
+            SetError(errorMessage, "Failed while writing WAV data.");
+        return ok;
+    }
+
+    bool WavWriter::WritePcm16File(const std::filesystem::path& path, Pcm16Span interleaved, int sampleRate, int channels, std::string* errorMessage)
+    {
+        WavWriter w;
+        if (!w.Open(path, sampleRate, channels, WavSampleFormat::Pcm16, errorMessage))
+            return false;
+        if (!w.AppendPcm16(interleaved))
+        {
+            w.Finalize();
+            SetError(errorMessage, "Failed while writing WAV data: " + path.string());
+            return false;
+        }
+        return w.Finalize(errorMessage);
+    }
+}
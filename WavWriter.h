@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "AudioFileLoader.h"
+
+namespace audiofile
+{
+    enum class WavSampleFormat
+    {
+        Pcm16,
+        Pcm24,
+        Float32
+    };
+
+    // Streaming RIFF/WAVE writer: Open(), Append*() blocks, Finalize().
+    //
+    // Samples are converted straight into a 1 MiB staging buffer and written in large
+    // blocks; nothing holds a copy of the whole signal. The header reserves a JUNK chunk
+    // that Finalize() turns into a ds64 chunk (RF64) if the file ends up larger than 4 GiB.
+    class WavWriter
+    {
+    public:
+        WavWriter();
+        ~WavWriter(); // finalizes if still open
+
+        WavWriter(const WavWriter&) = delete;
+        WavWriter& operator=(const WavWriter&) = delete;
+
+        WavWriter(WavWriter&&) noexcept = default;
+        WavWriter& operator=(WavWriter&&) noexcept = default;
+
+        // channels must be 1 (mono) or 2 (interleaved stereo).
+        bool Open(const std::filesystem::path& path, int sampleRate, int channels,
+            WavSampleFormat format = WavSampleFormat::Pcm16, std::string* errorMessage = nullptr);
+
+        // Interleaved input, frameCount frames. Converted to the file's sample format.
+        bool AppendPcm16(const short* interleaved, std::size_t frameCount);
+        bool AppendFloat(const float* interleaved, std::size_t frameCount);   // nominal range [-1, 1]
+        bool AppendDouble(const double* interleaved, std::size_t frameCount); // nominal range [-1, 1]
+        bool AppendPcm16(Pcm16Span interleaved);
+
+        // Flushes, patches the chunk sizes (switching to RF64 if needed) and closes the file.
+        bool Finalize(std::string* errorMessage = nullptr);
+
+        bool IsOpen() const { return m_out.is_open(); }
+        std::uint64_t FramesWritten() const { return m_framesWritten; }
+
+        // One-shot helper for callers that already hold the whole signal.
+        static bool WritePcm16File(const std::filesystem::path& path, Pcm16Span interleaved, int sampleRate, int channels,
+            std::string* errorMessage = nullptr);
+
+    private:
+        template <typename Convert>
+        bool AppendConverted(std::size_t sampleCount, Convert&& convertOne);
+        bool FlushBuffer();
+
+        std::ofstream m_out;
+        std::vector<unsigned char> m_buffer;
+        std::size_t m_bufferUsed = 0;
+        WavSampleFormat m_format = WavSampleFormat::Pcm16;
+        int m_sampleRate = 0;
+        int m_channels = 0;
+        std::uint64_t m_framesWritten = 0;
+        std::uint64_t m_dataBytes = 0;
+        std::uint64_t m_dataSizeOffset = 0; // file offset of the data chunk's size field
+        std::uint64_t m_factOffset = 0;     // file offset of the fact chunk payload (float only)
+        bool m_failed = false;
+    };
+}
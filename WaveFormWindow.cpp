@@ -13,6 +13,7 @@
 #pragma comment(lib,"Winmm.lib") // mci lives here too
 #pragma comment(lib,"Msimg32.lib") // AlphaBlend for translucent spectrogram notes
 
+#include <array>
 #include <memory>
 #include <algorithm>
 #include <vector>
@@ -26,11 +27,16 @@
 #include <cstdint>
 #include <cstring>
 
+#include "Biquad.h"
+#include "Resampler.h"
+#include "RollingStats.h"
 #include "DSP.h"   // dsp helpers (FFTW STFT + cache builder)
 #include "PianoRollRenderer.h"
 #include "PianoSpectrogramUI.h"
 #include "AudioEngine.h"
+#include "WavWriter.h"
 #include "SpectrogramWindow.h"
+#include "Profiler.h"
 
 using namespace WaveformWindow;
 
@@ -94,7 +100,7 @@ namespace
         std::atomic<int> sampleRate{ 0 };
         std::atomic<int> mainChannels{ 2 };
         std::atomic<bool> stemPlaybackEnabled{ false };
-        std::atomic<const std::vector<short>*> stems[4]{};
+        std::atomic<const audiofile::Pcm16Span*> stems[4]{}; // points at ThreadParam stem views
         std::atomic<int> stemSampleRate[4]{};
         std::atomic<int> stemChannels[4]{};
         std::atomic<bool> stemEnabled[4]{};
@@ -293,19 +299,20 @@ struct ThreadParam
 
     // ---- optional stem playback mixing ----
     bool stemPlaybackEnabled = false;
-    std::vector<short>* stemVocals = nullptr;
+    audiofile::Pcm16Span stemVocals{};
     int stemVocalsSampleRate = 0;
     int stemVocalsChannels = 2;
-    std::vector<short>* stemDrums = nullptr;
+    audiofile::Pcm16Span stemDrums{};
     int stemDrumsSampleRate = 0;
     int stemDrumsChannels = 2;
-    std::vector<short>* stemBass = nullptr;
+    audiofile::Pcm16Span stemBass{};
     int stemBassSampleRate = 0;
     int stemBassChannels = 2;
-    std::vector<short>* stemChords = nullptr;
+    audiofile::Pcm16Span stemChords{};
     int stemChordsSampleRate = 0;
     int stemChordsChannels = 2;
     bool stemEnabled[4]{ true, true, true, true }; // vocals, drums, bass, chords
+    std::vector<short> stemConformed[4]; // owned copies of stems that arrived at another rate than sampleRate
     std::vector<short> stemMixScratch; // current playback mix (interleaved stereo)
 
     // ---- cached render data (per pixel column) ----
@@ -347,7 +354,7 @@ static bool ComputeWaveViewportFrameState(const ThreadParam* tp, size_t totalFra
 static bool HasStemPlayback(const ThreadParam* tp);
 static bool UsingAudioEngine(const ThreadParam* tp);
 static bool ShouldUseSourcePlaybackDirect(const ThreadParam* tp);
-static std::vector<short>* GetStemVectorByIndex(ThreadParam* tp, int idx);
+static audiofile::Pcm16Span GetStemSamplesByIndex(const ThreadParam* tp, int idx);
 static int GetStemSampleRateByIndex(const ThreadParam* tp, int idx);
 static int GetStemChannelsByIndex(const ThreadParam* tp, int idx);
 static bool PushAudioEngineLiveMixConfig(ThreadParam* tp);
@@ -405,7 +412,7 @@ static void PublishPlaybackAudioState(const ThreadParam* tp)
     gSharedPlaybackAudio.mainChannels.store(tp->isStereo ? 2 : 1);
     gSharedPlaybackAudio.stemPlaybackEnabled.store(HasStemPlayback(tp));
 
-    const std::vector<short>* stemPtrs[4] = { tp->stemVocals, tp->stemDrums, tp->stemBass, tp->stemChords };
+    const audiofile::Pcm16Span* stemPtrs[4] = { &tp->stemVocals, &tp->stemDrums, &tp->stemBass, &tp->stemChords };
     const int stemRates[4] = { tp->stemVocalsSampleRate, tp->stemDrumsSampleRate, tp->stemBassSampleRate, tp->stemChordsSampleRate };
     const int stemChs[4] = { tp->stemVocalsChannels, tp->stemDrumsChannels, tp->stemBassChannels, tp->stemChordsChannels };
     for (int i = 0; i < 4; ++i)
@@ -512,7 +519,7 @@ static void ClearPlaybackSync()
 static bool HasStemPlayback(const ThreadParam* tp)
 {
     return tp && tp->stemPlaybackEnabled &&
-        (tp->stemVocals || tp->stemDrums || tp->stemBass || tp->stemChords);
+        (!tp->stemVocals.empty() || !tp->stemDrums.empty() || !tp->stemBass.empty() || !tp->stemChords.empty());
 }
 
 static bool UsingAudioEngine(const ThreadParam* tp)
@@ -557,7 +564,7 @@ static bool PushAudioEngineLiveMixConfig(ThreadParam* tp)
 
     for (int i = 0; i < 4; ++i)
     {
-        cfg.stems[i].interleavedPcm16 = GetStemVectorByIndex(tp, i);
+        cfg.stems[i].mappedPcm16 = GetStemSamplesByIndex(tp, i);
         cfg.stems[i].sampleRate = GetStemSampleRateByIndex(tp, i);
         cfg.stems[i].channels = GetStemChannelsByIndex(tp, i);
         cfg.stemEnabled[i] = tp->stemEnabled[i];
@@ -566,16 +573,16 @@ static bool PushAudioEngineLiveMixConfig(ThreadParam* tp)
     return tp->audioEngine.SetLiveMixConfig(cfg);
 }
 
-static std::vector<short>* GetStemVectorByIndex(ThreadParam* tp, int idx)
+static audiofile::Pcm16Span GetStemSamplesByIndex(const ThreadParam* tp, int idx)
 {
-    if (!tp) return nullptr;
+    if (!tp) return {};
     switch (idx)
     {
     case 0: return tp->stemVocals;
     case 1: return tp->stemDrums;
     case 2: return tp->stemBass;
     case 3: return tp->stemChords;
-    default: return nullptr;
+    default: return {};
     }
 }
 
@@ -1057,40 +1064,7 @@ static void InvalidateToolbarKnob(HWND hwnd, const ThreadParam* tp, int idx)
 static bool WriteWav16ToPath(const std::wstring& outPath, const std::vector<short>& samples, int sampleRate, bool stereo)
 {
     if (outPath.empty()) return false;
-
-    const uint16_t numChannels = stereo ? 2u : 1u;
-    const size_t frameCount = stereo ? (samples.size() / 2) : samples.size();
-    const uint32_t datasz = static_cast<uint32_t>(frameCount * numChannels * sizeof(short));
-    const uint32_t fileSize = 36 + datasz;
-
-    FILE* f = nullptr;
-    _wfopen_s(&f, outPath.c_str(), L"wb");
-    if (!f) return false;
-
-    fwrite("RIFF", 1, 4, f);
-    fwrite(&fileSize, sizeof(fileSize), 1, f);
-    fwrite("WAVE", 1, 4, f);
-
-    uint32_t fmtSize = 16;
-    uint16_t audioFormat = 1;
-    uint32_t byteRate = sampleRate * numChannels * sizeof(short);
-    uint16_t blockAlign = numChannels * sizeof(short);
-    uint16_t bitsPerSample = 16;
-    fwrite("fmt ", 1, 4, f);
-    fwrite(&fmtSize, sizeof(fmtSize), 1, f);
-    fwrite(&audioFormat, sizeof(audioFormat), 1, f);
-    fwrite(&numChannels, sizeof(numChannels), 1, f);
-    fwrite(&sampleRate, sizeof(sampleRate), 1, f);
-    fwrite(&byteRate, sizeof(byteRate), 1, f);
-    fwrite(&blockAlign, sizeof(blockAlign), 1, f);
-    fwrite(&bitsPerSample, sizeof(bitsPerSample), 1, f);
-
-    fwrite("data", 1, 4, f);
-    fwrite(&datasz, sizeof(datasz), 1, f);
-    if (!samples.empty())
-        fwrite(samples.data(), sizeof(short), frameCount * numChannels, f);
-    fclose(f);
-    return true;
+    return audiofile::WavWriter::WritePcm16File(outPath, samples, sampleRate, stereo ? 2 : 1);
 }
 
 static std::wstring BuildOrRewriteTempWav16(const std::vector<short>& samples, int sampleRate, bool stereo, const std::wstring& preferredPath)
@@ -1115,6 +1089,25 @@ static std::wstring BuildOrRewriteTempWav16(const std::vector<short>& samples, i
     return outPath;
 }
 
+// Resamples (polyphase windowed sinc) every stem whose rate differs from the main waveform into
+// an owned copy, so the mixer, the audio engine and the spectrogram all read stems frame-for-frame.
+static void ConformStemsToMainRate(ThreadParam* tp)
+{
+    if (!tp || tp->sampleRate <= 0) return;
+    audiofile::Pcm16Span* spans[4] = { &tp->stemVocals, &tp->stemDrums, &tp->stemBass, &tp->stemChords };
+    int* rates[4] = { &tp->stemVocalsSampleRate, &tp->stemDrumsSampleRate, &tp->stemBassSampleRate, &tp->stemChordsSampleRate };
+    const int chs[4] = { tp->stemVocalsChannels, tp->stemDrumsChannels, tp->stemBassChannels, tp->stemChordsChannels };
+    for (int i = 0; i < 4; ++i)
+    {
+        if (spans[i]->empty() || *rates[i] <= 0 || *rates[i] == tp->sampleRate) continue;
+        const int ch = (std::max)(1, chs[i]);
+        dsp::resample_pcm16(spans[i]->data(), spans[i]->size() / static_cast<size_t>(ch), ch,
+            *rates[i], tp->sampleRate, tp->stemConformed[i]);
+        *spans[i] = tp->stemConformed[i];
+        *rates[i] = tp->sampleRate;
+    }
+}
+
 static void BuildCurrentStemMix(ThreadParam* tp)
 {
     if (!tp) return;
@@ -1136,11 +1129,11 @@ static void BuildCurrentStemMix(ThreadParam* tp)
     {
         for (int i = 0; i < 4; ++i)
         {
-            auto* sv = GetStemVectorByIndex(tp, i);
-            if (!sv || sv->empty()) continue;
+            const audiofile::Pcm16Span sv = GetStemSamplesByIndex(tp, i);
+            if (sv.empty()) continue;
             const int srcChannels = (std::max)(1, (std::min)(2, GetStemChannelsByIndex(tp, i)));
             const int srcRate = (GetStemSampleRateByIndex(tp, i) > 0) ? GetStemSampleRateByIndex(tp, i) : outRate;
-            const size_t srcFrames = sv->size() / static_cast<size_t>(srcChannels);
+            const size_t srcFrames = sv.size() / static_cast<size_t>(srcChannels);
             const size_t scaledFrames = static_cast<size_t>((static_cast<unsigned long long>(srcFrames) * static_cast<unsigned long long>(outRate)) / static_cast<unsigned long long>((std::max)(1, srcRate)));
             outFrames = (std::max)(outFrames, scaledFrames);
         }
@@ -1155,28 +1148,29 @@ static void BuildCurrentStemMix(ThreadParam* tp)
     for (int stemIdx = 0; stemIdx < 4; ++stemIdx)
     {
         if (!tp->stemEnabled[stemIdx]) continue;
-        auto* sv = GetStemVectorByIndex(tp, stemIdx);
-        if (!sv || sv->empty()) continue;
+        const audiofile::Pcm16Span sv = GetStemSamplesByIndex(tp, stemIdx);
+        if (sv.empty()) continue;
 
         const int srcRateRaw = GetStemSampleRateByIndex(tp, stemIdx);
         const int srcRate = (srcRateRaw > 0) ? srcRateRaw : outRate;
         const int srcChannels = (std::max)(1, (std::min)(2, GetStemChannelsByIndex(tp, stemIdx)));
-        const size_t srcFrames = sv->size() / static_cast<size_t>(srcChannels);
+        const size_t srcFrames = sv.size() / static_cast<size_t>(srcChannels);
         if (srcFrames == 0) continue;
 
         anyEnabled = true;
 
         for (size_t outFrame = 0; outFrame < outFrames; ++outFrame)
         {
-            // Nearest-neighbor resample to the main playback rate (fast enough for toggle rebuilds).
+            // Stems are conformed to the main rate when the window opens, so this is 1:1 in practice;
+            // nearest-neighbor only covers a stem whose rate could not be conformed.
             size_t srcFrame = static_cast<size_t>(
                 (static_cast<unsigned long long>(outFrame) * static_cast<unsigned long long>(srcRate)) /
                 static_cast<unsigned long long>((std::max)(1, outRate)));
             if (srcFrame >= srcFrames) break;
 
             const size_t srcBase = srcFrame * static_cast<size_t>(srcChannels);
-            const short sL = (*sv)[srcBase];
-            const short sR = (srcChannels >= 2 && (srcBase + 1) < sv->size()) ? (*sv)[srcBase + 1] : sL;
+            const short sL = sv[srcBase];
+            const short sR = (srcChannels >= 2 && (srcBase + 1) < sv.size()) ? sv[srcBase + 1] : sL;
 
             const size_t outBase = outFrame * static_cast<size_t>(outChannels);
             if (outChannels == 1)
@@ -1217,10 +1211,7 @@ static void ApplyPlaybackEqInPlace(ThreadParam* tp, std::vector<short>& interlea
     {
         for (short& s : interleaved)
         {
-            double y = (static_cast<double>(s) / 32768.0) * masterGain;
-            if (!std::isfinite(y)) y = 0.0;
-            y = std::clamp(y, -1.0, 1.0);
-            s = static_cast<short>(std::lround(y * 32767.0));
+            s = dsp::float_to_pcm16(dsp::pcm16_to_float(s) * masterGain);
         }
         return;
     }
@@ -1230,124 +1221,29 @@ static void ApplyPlaybackEqInPlace(ThreadParam* tp, std::vector<short>& interlea
     const size_t frames = interleaved.size() / static_cast<size_t>(channels);
     if (frames == 0) return;
 
-    struct Biquad
-    {
-        double b0 = 1.0, b1 = 0.0, b2 = 0.0;
-        double a1 = 0.0, a2 = 0.0;
-
-        double process(double x, double& z1, double& z2) const
-        {
-            // Transposed direct-form II
-            const double y = b0 * x + z1;
-            z1 = b1 * x - a1 * y + z2;
-            z2 = b2 * x - a2 * y;
-            return y;
-        }
-    };
-
-    auto normalize_biquad = [](double b0, double b1, double b2, double a0, double a1, double a2) -> Biquad
-    {
-        const double invA0 = (std::fabs(a0) > 1e-18) ? (1.0 / a0) : 1.0;
-        Biquad q{};
-        q.b0 = b0 * invA0;
-        q.b1 = b1 * invA0;
-        q.b2 = b2 * invA0;
-        q.a1 = a1 * invA0;
-        q.a2 = a2 * invA0;
-        return q;
-    };
-
-    auto make_peaking = [&](double fc, double q, double gainDb) -> Biquad
-    {
-        const double fs = static_cast<double>(tp->sampleRate);
-        fc = std::clamp(fc, 10.0, fs * 0.45);
-        q = (std::max)(0.1, q);
-        const double A = std::pow(10.0, gainDb / 40.0);
-        const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
-        const double cw0 = std::cos(w0);
-        const double sw0 = std::sin(w0);
-        const double alpha = sw0 / (2.0 * q);
-
-        const double b0 = 1.0 + alpha * A;
-        const double b1 = -2.0 * cw0;
-        const double b2 = 1.0 - alpha * A;
-        const double a0 = 1.0 + alpha / A;
-        const double a1 = -2.0 * cw0;
-        const double a2 = 1.0 - alpha / A;
-        return normalize_biquad(b0, b1, b2, a0, a1, a2);
-    };
-
-    auto make_lowshelf = [&](double fc, double slope, double gainDb) -> Biquad
-    {
-        const double fs = static_cast<double>(tp->sampleRate);
-        fc = std::clamp(fc, 10.0, fs * 0.45);
-        slope = (std::max)(0.1, slope);
-        const double A = std::pow(10.0, gainDb / 40.0);
-        const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
-        const double cw0 = std::cos(w0);
-        const double sw0 = std::sin(w0);
-        const double alpha = sw0 * 0.5 * std::sqrt((A + 1.0 / A) * (1.0 / slope - 1.0) + 2.0);
-        const double twoSqrtAAlpha = 2.0 * std::sqrt(A) * alpha;
-
-        const double b0 = A * ((A + 1.0) - (A - 1.0) * cw0 + twoSqrtAAlpha);
-        const double b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cw0);
-        const double b2 = A * ((A + 1.0) - (A - 1.0) * cw0 - twoSqrtAAlpha);
-        const double a0 = (A + 1.0) + (A - 1.0) * cw0 + twoSqrtAAlpha;
-        const double a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cw0);
-        const double a2 = (A + 1.0) + (A - 1.0) * cw0 - twoSqrtAAlpha;
-        return normalize_biquad(b0, b1, b2, a0, a1, a2);
-    };
-
-    auto make_highshelf = [&](double fc, double slope, double gainDb) -> Biquad
-    {
-        const double fs = static_cast<double>(tp->sampleRate);
-        fc = std::clamp(fc, 10.0, fs * 0.45);
-        slope = (std::max)(0.1, slope);
-        const double A = std::pow(10.0, gainDb / 40.0);
-        const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
-        const double cw0 = std::cos(w0);
-        const double sw0 = std::sin(w0);
-        const double alpha = sw0 * 0.5 * std::sqrt((A + 1.0 / A) * (1.0 / slope - 1.0) + 2.0);
-        const double twoSqrtAAlpha = 2.0 * std::sqrt(A) * alpha;
-
-        const double b0 = A * ((A + 1.0) + (A - 1.0) * cw0 + twoSqrtAAlpha);
-        const double b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cw0);
-        const double b2 = A * ((A + 1.0) + (A - 1.0) * cw0 - twoSqrtAAlpha);
-        const double a0 = (A + 1.0) - (A - 1.0) * cw0 + twoSqrtAAlpha;
-        const double a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cw0);
-        const double a2 = (A + 1.0) - (A - 1.0) * cw0 - twoSqrtAAlpha;
-        return normalize_biquad(b0, b1, b2, a0, a1, a2);
-    };
-
     // DJ-style-ish 3-band EQ:
     // - low shelf
     // - broad mid bell
     // - high shelf
-    const Biquad lowShelf = make_lowshelf(220.0, 0.9, tp->eqLowDb);
-    const Biquad midBell = make_peaking(1000.0, 0.75, tp->eqMidDb);
-    const Biquad highShelf = make_highshelf(4200.0, 0.9, tp->eqHighDb);
+    const std::array<dsp::BiquadCoeffs, 3> sections =
+        dsp::design_playback_eq(static_cast<double>(tp->sampleRate), tp->eqLowDb, tp->eqMidDb, tp->eqHighDb);
+    dsp::BiquadBank eq(channels, 3);
+    for (int i = 0; i < 3; ++i)
+        eq.set_section(i, sections[static_cast<size_t>(i)]);
 
     std::vector<float> processed(interleaved.size(), 0.0f);
-    double peak = 0.0;
-
-    for (int ch = 0; ch < channels; ++ch)
+    for (size_t i = 0; i < interleaved.size(); ++i)
+        processed[i] = dsp::pcm16_to_float(interleaved[i]);
     {
-        double lz1 = 0.0, lz2 = 0.0;
-        double mz1 = 0.0, mz2 = 0.0;
-        double hz1 = 0.0, hz2 = 0.0;
+        WAVEOUT_PROFILE_SCOPE("dsp.biquad");
+        eq.process(processed.data(), processed.data(), frames);
+    }
 
-        for (size_t i = 0; i < frames; ++i)
-        {
-            const size_t idx = i * static_cast<size_t>(channels) + static_cast<size_t>(ch);
-            double x = static_cast<double>(interleaved[idx]) / 32768.0;
-            x = lowShelf.process(x, lz1, lz2);
-            x = midBell.process(x, mz1, mz2);
-            x = highShelf.process(x, hz1, hz2);
-
-            if (!std::isfinite(x)) x = 0.0;
-            processed[idx] = static_cast<float>(x);
-            peak = (std::max)(peak, std::fabs(x));
-        }
+    double peak = 0.0;
+    for (float& x : processed)
+    {
+        if (!std::isfinite(x)) x = 0.0f;
+        peak = (std::max)(peak, static_cast<double>(std::fabs(x)));
     }
 
     // Peak protection with a little headroom; much cleaner than hard clipping.
@@ -1356,10 +1252,7 @@ static void ApplyPlaybackEqInPlace(ThreadParam* tp, std::vector<short>& interlea
 
     for (size_t i = 0; i < interleaved.size(); ++i)
     {
-        double y = static_cast<double>(processed[i]) * scale * masterGain;
-        if (y > 1.0) y = 1.0;
-        if (y < -1.0) y = -1.0;
-        interleaved[i] = static_cast<short>(std::lround(y * 32767.0));
+        interleaved[i] = dsp::float_to_pcm16(static_cast<double>(processed[i]) * scale * masterGain);
     }
 }
 
@@ -2514,6 +2407,7 @@ static std::vector<float> OnePoleHighpass(const std::vector<float>& x, int sr, d
 
 static void EnvelopeMinMax(const std::vector<float>& x, int block, std::vector<float>& outMin, std::vector<float>& outMax)
 {
+    WAVEOUT_PROFILE_SCOPE("waveform.envelopeMinMax");
     outMin.clear();
     outMax.clear();
     if (x.empty() || block <= 0)
@@ -2567,6 +2461,7 @@ static void ReduceEnvelopeMinMax2x(const std::vector<float>& srcMin, const std::
 
 static void BuildEnvelopeMipPyramid(ThreadParam* tp)
 {
+    WAVEOUT_PROFILE_SCOPE("waveform.buildMipPyramid");
     if (!tp)
         return;
 
@@ -2769,6 +2664,7 @@ static bool EnsureEnvelopeCacheKey(ThreadParam* tp, std::size_t totalFrames)
 
 static bool TryLoadEnvelopeCache(ThreadParam* tp, std::size_t totalFrames)
 {
+    WAVEOUT_PROFILE_SCOPE("waveform.loadEnvelopeCache");
     if (!tp || totalFrames == 0)
         return false;
     if (!EnsureEnvelopeCacheKey(tp, totalFrames))
@@ -2909,6 +2805,7 @@ static bool TryLoadEnvelopeCache(ThreadParam* tp, std::size_t totalFrames)
 
 static void TrySaveEnvelopeCache(const ThreadParam* tp, std::size_t totalFrames)
 {
+    WAVEOUT_PROFILE_SCOPE("waveform.saveEnvelopeCache");
     if (!tp || totalFrames == 0 || tp->envBlocks == 0 || tp->envCachePath.empty())
         return;
 
@@ -3064,30 +2961,22 @@ static void PrepareColorWaveEnvelopes(ThreadParam* tp)
     double lpDisp2000 = 0.0; // lowpass(disp, 2000)
     double lpHp2000 = 0.0;   // lowpass(hpLow, 2000) => mid
 
-    float bBaseMin = std::numeric_limits<float>::max();
-    float bBaseMax = -std::numeric_limits<float>::max();
-    float bLowMin = std::numeric_limits<float>::max();
-    float bLowMax = -std::numeric_limits<float>::max();
-    float bMidMin = std::numeric_limits<float>::max();
-    float bMidMax = -std::numeric_limits<float>::max();
-    float bHighMin = std::numeric_limits<float>::max();
-    float bHighMax = -std::numeric_limits<float>::max();
+    dsp::MinMax<float> bBase, bLow, bMid, bHigh;
     int inBlock = 0;
 
     auto flushBlock = [&]()
     {
         if (inBlock <= 0) return;
-        tp->baseMinF.push_back((bBaseMin == std::numeric_limits<float>::max()) ? 0.0f : bBaseMin);
-        tp->baseMaxF.push_back((bBaseMax == -std::numeric_limits<float>::max()) ? 0.0f : bBaseMax);
-        tp->lowMinF.push_back((bLowMin == std::numeric_limits<float>::max()) ? 0.0f : bLowMin);
-        tp->lowMaxF.push_back((bLowMax == -std::numeric_limits<float>::max()) ? 0.0f : bLowMax);
-        tp->midMinF.push_back((bMidMin == std::numeric_limits<float>::max()) ? 0.0f : bMidMin);
-        tp->midMaxF.push_back((bMidMax == -std::numeric_limits<float>::max()) ? 0.0f : bMidMax);
-        tp->highMinF.push_back((bHighMin == std::numeric_limits<float>::max()) ? 0.0f : bHighMin);
-        tp->highMaxF.push_back((bHighMax == -std::numeric_limits<float>::max()) ? 0.0f : bHighMax);
-
-        bBaseMin = bLowMin = bMidMin = bHighMin = std::numeric_limits<float>::max();
-        bBaseMax = bLowMax = bMidMax = bHighMax = -std::numeric_limits<float>::max();
+        tp->baseMinF.push_back(bBase.min_or_zero());
+        tp->baseMaxF.push_back(bBase.max_or_zero());
+        tp->lowMinF.push_back(bLow.min_or_zero());
+        tp->lowMaxF.push_back(bLow.max_or_zero());
+        tp->midMinF.push_back(bMid.min_or_zero());
+        tp->midMaxF.push_back(bMid.max_or_zero());
+        tp->highMinF.push_back(bHigh.min_or_zero());
+        tp->highMaxF.push_back(bHigh.max_or_zero());
+
+        bBase.reset(); bLow.reset(); bMid.reset(); bHigh.reset();
         inBlock = 0;
     };
 
@@ -3110,14 +2999,10 @@ static void PrepareColorWaveEnvelopes(ThreadParam* tp)
         const float mid = ClampFloat(static_cast<float>(midD), -tp->displayHeadroom, tp->displayHeadroom);
         const float high = ClampFloat(static_cast<float>(highD), -tp->displayHeadroom, tp->displayHeadroom);
 
-        bBaseMin = (std::min)(bBaseMin, x);
-        bBaseMax = (std::max)(bBaseMax, x);
-        bLowMin = (std::min)(bLowMin, low);
-        bLowMax = (std::max)(bLowMax, low);
-        bMidMin = (std::min)(bMidMin, mid);
-        bMidMax = (std::max)(bMidMax, mid);
-        bHighMin = (std::min)(bHighMin, high);
-        bHighMax = (std::max)(bHighMax, high);
+        bBase.push(x);
+        bLow.push(low);
+        bMid.push(mid);
+        bHigh.push(high);
 
         ++inBlock;
         if (inBlock >= tp->envBlock)
@@ -4361,11 +4246,11 @@ static void EmbeddedPianoSpecComputeColumn(ThreadParam* tp, double centerFrameD,
     mean /= (double)nfft;
 
     for (int i = 0; i < nfft; ++i)
-        tp->embeddedPianoSpecFft.in()[i] =
-        (tp->embeddedPianoSpecAnalysisMono[(std::size_t)i] - mean) * tp->embeddedPianoSpecWindow[(std::size_t)i];
+        tp->embeddedPianoSpecFft.in()[i] = (dsp::fft_real)
+        ((tp->embeddedPianoSpecAnalysisMono[(std::size_t)i] - mean) * tp->embeddedPianoSpecWindow[(std::size_t)i]);
     tp->embeddedPianoSpecFft.execute();
 
-    const fftw_complex* X = tp->embeddedPianoSpecFft.out();
+    const dsp::FftwR2C::Complex* X = tp->embeddedPianoSpecFft.out();
     if (!X) return;
 
     const double nyquist = 0.5 * (double)tp->sampleRate;
@@ -6428,6 +6313,7 @@ void WaveformWindow::ShowWaveformAsyncRefPlayStereoGridStems(std::vector<short>*
     tp->stemChords = stems.chordsInterleavedStereo;
     tp->stemChordsSampleRate = stems.chordsSampleRate;
     tp->stemChordsChannels = stems.chordsChannels;
+    ConformStemsToMainRate(tp);
 
     HANDLE h = CreateThread(nullptr, 0, ThreadProc, tp, 0, nullptr);
     if (h) CloseHandle(h);
@@ -6447,7 +6333,7 @@ bool WaveformWindow::BuildPlaybackSpectrogramMonoWindow(double centerFrame, int
         int sampleRate = 0;
         int mainChannels = 2;
         bool stemPlaybackEnabled = false;
-        const std::vector<short>* stems[4]{};
+        const audiofile::Pcm16Span* stems[4]{};
         int stemSampleRate[4]{};
         int stemChannels[4]{};
         bool stemEnabled[4]{};
@@ -6486,7 +6372,8 @@ bool WaveformWindow::BuildPlaybackSpectrogramMonoWindow(double centerFrame, int
         return static_cast<double>(v) / 32768.0;
     };
 
-    auto sampleSourceStereoAt = [&](const std::vector<short>* vec, int srcRate, int srcChannels, double timelineFramePos, double& outL, double& outR)
+    // Generic over std::vector<short> (main mix) and audiofile::Pcm16Span (stems).
+    auto sampleSourceStereoAt = [&](const auto* vec, int srcRate, int srcChannels, double timelineFramePos, double& outL, double& outR)
     {
         outL = 0.0;
         outR = 0.0;
@@ -6521,101 +6408,18 @@ bool WaveformWindow::BuildPlaybackSpectrogramMonoWindow(double centerFrame, int
     bool allStemsOn = true;
     for (int i = 0; i < 4; ++i)
     {
-        anyStemSource = anyStemSource || (s.stems[i] != nullptr);
+        anyStemSource = anyStemSource || (s.stems[i] && !s.stems[i]->empty());
         allStemsOn = allStemsOn && s.stemEnabled[i];
     }
     const bool useSourceDirect = (!s.stemPlaybackEnabled) || !anyStemSource || allStemsOn;
     if (useSourceDirect && !s.mainSamples)
         return false;
 
-    struct Biquad
-    {
-        double b0 = 1.0, b1 = 0.0, b2 = 0.0;
-        double a1 = 0.0, a2 = 0.0;
-        double process(double x, double& z1, double& z2) const
-        {
-            const double y = b0 * x + z1;
-            z1 = b1 * x - a1 * y + z2;
-            z2 = b2 * x - a2 * y;
-            return y;
-        }
-    };
-
-    auto normalize_biquad = [](double b0, double b1, double b2, double a0, double a1, double a2) -> Biquad
-    {
-        const double invA0 = (std::fabs(a0) > 1e-18) ? (1.0 / a0) : 1.0;
-        Biquad q{};
-        q.b0 = b0 * invA0; q.b1 = b1 * invA0; q.b2 = b2 * invA0;
-        q.a1 = a1 * invA0; q.a2 = a2 * invA0;
-        return q;
-    };
-    auto make_peaking = [&](double fc, double q, double gainDb) -> Biquad
-    {
-        const double fs = static_cast<double>(s.sampleRate);
-        fc = std::clamp(fc, 10.0, fs * 0.45);
-        q = (std::max)(0.1, q);
-        const double A = std::pow(10.0, gainDb / 40.0);
-        const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
-        const double cw0 = std::cos(w0);
-        const double sw0 = std::sin(w0);
-        const double alpha = sw0 / (2.0 * q);
-        return normalize_biquad(
-            1.0 + alpha * A,
-            -2.0 * cw0,
-            1.0 - alpha * A,
-            1.0 + alpha / A,
-            -2.0 * cw0,
-            1.0 - alpha / A);
-    };
-    auto make_lowshelf = [&](double fc, double slope, double gainDb) -> Biquad
-    {
-        const double fs = static_cast<double>(s.sampleRate);
-        fc = std::clamp(fc, 10.0, fs * 0.45);
-        slope = (std::max)(0.1, slope);
-        const double A = std::pow(10.0, gainDb / 40.0);
-        const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
-        const double cw0 = std::cos(w0);
-        const double sw0 = std::sin(w0);
-        const double alpha = sw0 * 0.5 * std::sqrt((A + 1.0 / A) * (1.0 / slope - 1.0) + 2.0);
-        const double t = 2.0 * std::sqrt(A) * alpha;
-        return normalize_biquad(
-            A * ((A + 1.0) - (A - 1.0) * cw0 + t),
-            2.0 * A * ((A - 1.0) - (A + 1.0) * cw0),
-            A * ((A + 1.0) - (A - 1.0) * cw0 - t),
-            (A + 1.0) + (A - 1.0) * cw0 + t,
-            -2.0 * ((A - 1.0) + (A + 1.0) * cw0),
-            (A + 1.0) + (A - 1.0) * cw0 - t);
-    };
-    auto make_highshelf = [&](double fc, double slope, double gainDb) -> Biquad
-    {
-        const double fs = static_cast<double>(s.sampleRate);
-        fc = std::clamp(fc, 10.0, fs * 0.45);
-        slope = (std::max)(0.1, slope);
-        const double A = std::pow(10.0, gainDb / 40.0);
-        const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
-        const double cw0 = std::cos(w0);
-        const double sw0 = std::sin(w0);
-        const double alpha = sw0 * 0.5 * std::sqrt((A + 1.0 / A) * (1.0 / slope - 1.0) + 2.0);
-        const double t = 2.0 * std::sqrt(A) * alpha;
-        return normalize_biquad(
-            A * ((A + 1.0) + (A - 1.0) * cw0 + t),
-            -2.0 * A * ((A - 1.0) + (A + 1.0) * cw0),
-            A * ((A + 1.0) + (A - 1.0) * cw0 - t),
-            (A + 1.0) - (A - 1.0) * cw0 + t,
-            2.0 * ((A - 1.0) - (A + 1.0) * cw0),
-            (A + 1.0) - (A - 1.0) * cw0 - t);
-    };
-
     const bool eqActive = std::fabs(s.eqLowDb) > 1e-6 || std::fabs(s.eqMidDb) > 1e-6 || std::fabs(s.eqHighDb) > 1e-6;
     const bool gainActive = std::fabs(s.masterGainDb) > 1e-6;
     const double masterGain = gainActive ? std::pow(10.0, s.masterGainDb / 20.0) : 1.0;
-    const Biquad lowShelf = eqActive ? make_lowshelf(220.0, 0.9, s.eqLowDb) : Biquad{};
-    const Biquad midBell = eqActive ? make_peaking(1000.0, 0.75, s.eqMidDb) : Biquad{};
-    const Biquad highShelf = eqActive ? make_highshelf(4200.0, 0.9, s.eqHighDb) : Biquad{};
-    double lz1 = 0.0, lz2 = 0.0, mz1 = 0.0, mz2 = 0.0, hz1 = 0.0, hz2 = 0.0;
-    double lz1r = 0.0, lz2r = 0.0, mz1r = 0.0, mz2r = 0.0, hz1r = 0.0, hz2r = 0.0;
-
-    outMono.assign(static_cast<std::size_t>(frameCount), 0.0);
+    // Mix the window as L/R first, then run the EQ over the whole block in one pass.
+    std::vector<double> mix(static_cast<std::size_t>(frameCount) * 2, 0.0);
     const double half = 0.5 * static_cast<double>(frameCount - 1);
     for (int i = 0; i < frameCount; ++i)
     {
@@ -6642,16 +6446,25 @@ bool WaveformWindow::BuildPlaybackSpectrogramMonoWindow(double centerFrame, int
                 r += sr;
             }
         }
+        mix[2 * static_cast<std::size_t>(i)] = l;
+        mix[2 * static_cast<std::size_t>(i) + 1] = r;
+    }
 
-        if (eqActive)
-        {
-            l = lowShelf.process(l, lz1, lz2);
-            l = midBell.process(l, mz1, mz2);
-            l = highShelf.process(l, hz1, hz2);
-            r = lowShelf.process(r, lz1r, lz2r);
-            r = midBell.process(r, mz1r, mz2r);
-            r = highShelf.process(r, hz1r, hz2r);
-        }
+    if (eqActive)
+    {
+        const std::array<dsp::BiquadCoeffs, 3> sections =
+            dsp::design_playback_eq(static_cast<double>(s.sampleRate), s.eqLowDb, s.eqMidDb, s.eqHighDb);
+        dsp::BiquadBank eq(2, 3);
+        for (int k = 0; k < 3; ++k)
+            eq.set_section(k, sections[static_cast<std::size_t>(k)]);
+        eq.process(mix.data(), mix.data(), static_cast<std::size_t>(frameCount));
+    }
+
+    outMono.assign(static_cast<std::size_t>(frameCount), 0.0);
+    for (int i = 0; i < frameCount; ++i)
+    {
+        double l = mix[2 * static_cast<std::size_t>(i)];
+        double r = mix[2 * static_cast<std::size_t>(i) + 1];
 
         if (gainActive)
         {
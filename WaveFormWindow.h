@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 
+#include "AudioFileLoader.h"
+
 namespace WaveformWindow
 {
     struct GridOverlayConfig
@@ -32,19 +34,21 @@ namespace WaveformWindow
         GridOverlayConfig grid{};
     };
 
+    // Stem views are non-owning (vector or memory-mapped WAV); the backing storage must
+    // outlive the window.
     struct StemPlaybackConfig
     {
         bool enabled = false;
-        std::vector<short>* vocalsInterleavedStereo = nullptr;
+        audiofile::Pcm16Span vocalsInterleavedStereo{};
         int vocalsSampleRate = 0;
         int vocalsChannels = 2;
-        std::vector<short>* drumsInterleavedStereo = nullptr;
+        audiofile::Pcm16Span drumsInterleavedStereo{};
         int drumsSampleRate = 0;
         int drumsChannels = 2;
-        std::vector<short>* bassInterleavedStereo = nullptr;
+        audiofile::Pcm16Span bassInterleavedStereo{};
         int bassSampleRate = 0;
         int bassChannels = 2;
-        std::vector<short>* chordsInterleavedStereo = nullptr;
+        audiofile::Pcm16Span chordsInterleavedStereo{};
         int chordsSampleRate = 0;
         int chordsChannels = 2;
     };
@@ -0,0 +1,56 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+namespace threading
+{
+    WorkerPool::WorkerPool(std::size_t threadCount)
+    {
+        if (threadCount == 0)
+            threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+
+        m_threads.reserve(threadCount);
+        for (std::size_t i = 0; i < threadCount; ++i)
+            m_threads.emplace_back([this]() { WorkerLoop(); });
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cv.notify_all();
+        for (auto& t : m_threads)
+        {
+            if (t.joinable())
+                t.join();
+        }
+    }
+
+    void WorkerPool::Enqueue(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_cv.notify_one();
+    }
+
+    void WorkerPool::WorkerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+                if (m_jobs.empty())
+                    return; // stopping and drained
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+            job();
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace threading
+{
+    // Small fixed-size thread pool. Submit() returns a std::future; exceptions thrown
+    // by a task are captured in its future. The destructor drains queued work and joins.
+    class WorkerPool
+    {
+    public:
+        // threadCount == 0 picks std::thread::hardware_concurrency().
+        explicit WorkerPool(std::size_t threadCount = 0);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        template <typename F>
+        auto Submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+        {
+            using R = std::invoke_result_t<std::decay_t<F>>;
+            // std::function needs a copyable target, packaged_task is move-only.
+            auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+            std::future<R> fut = task->get_future();
+            Enqueue([task]() { (*task)(); });
+            return fut;
+        }
+
+        std::size_t ThreadCount() const { return m_threads.size(); }
+
+    private:
+        void Enqueue(std::function<void()> job);
+        void WorkerLoop();
+
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void()>> m_jobs;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_stopping = false;
+    };
+}
@@ -6,6 +6,12 @@
 #include <complex>
 #include <fftw3.h>
 #include "Util.h"
+#include "AudioView.h"
+#include "FirConvolver.h"
+#include "FirFilter.h"
+#include "BandSplitter.h"
+#include "Profiler.h"
+#include "TaskGraph.h"
 #include <math.h>
 using namespace std;
 class filter
@@ -102,109 +108,61 @@ public:
 		return coefficients;
 	}
 	// PUT TWO FUNCTIONS THAT USE LONG FOR MORE PRECISION
-	static void yLapply_high_pass_filter(std::vector<short>& left_channel, std::vector<short>& right_channel, const std::vector<long double>& coefficients) {
-		size_t num_taps = coefficients.size();
-		vector<double> leftC;
-		leftC.resize(left_channel.size());
-
-		vector<double> rightC;
-		rightC.resize(right_channel.size());
-
-
-		// Apply the filter to the left channel.
-		for (size_t i = 0; i < left_channel.size(); i++) {
-			if (i + num_taps <= left_channel.size())
-			{
-				double filtered_sample = 0;
-
-				for (size_t j = 0; j < num_taps; j++)
-				{
-					filtered_sample += coefficients[j] * left_channel[i + j];
-				}
-				leftC[i] = filtered_sample;
-			}
-			else
-			{
-				leftC[i] = 0;
-			}
-		}
-		cout << "yesssa" << endl;
-		// Apply the filter to the right channel.
-		for (size_t i = 0; i < right_channel.size(); i++)
-		{
-			if (i + num_taps <= right_channel.size())
-			{
-				double filtered_sample = 0;
-				for (size_t j = 0; j < num_taps; j++)
-				{
-					filtered_sample += coefficients[j] * right_channel[i + j];
-				}
-				rightC[i] = filtered_sample;
-			}
-			else
-			{
-				rightC[i] = 0;
-			}
-		}
-
-		double maxValLeft = fabs(leftC[0]);
-		double maxValRight = fabs(rightC[0]);
+	static void yLapply_high_pass_filter(std::vector<short>& left_channel, std::vector<short>& right_channel, const std::vector<long double>& coefficients, threading::WorkerPool* pool = nullptr) {
+		const std::vector<double> h(coefficients.begin(), coefficients.end());
+		vector<double> leftC(left_channel.size());
+		vector<double> rightC(right_channel.size());
+
+		//SIMD direct form for short kernels, FFT convolution for long ones; with a pool the channels run concurrently
+		dsp::FirChannel channels[2];
+		channels[0].in = audiofile::AudioView(left_channel.data(), left_channel.size(), 1, 1);
+		channels[0].out = leftC.data();
+		channels[1].in = audiofile::AudioView(right_channel.data(), right_channel.size(), 1, 1);
+		channels[1].out = rightC.data();
+		dsp::fir_correlate_valid(channels, 2, h, dsp::FirMethod::Auto, pool);
+
+		const double maxi = (std::max)(maxAbs(leftC.data(), leftC.size()), maxAbs(rightC.data(), rightC.size()));
+		scaleToShort(leftC.data(), leftC.size(), maxi, left_channel.data());
+		scaleToShort(rightC.data(), rightC.size(), maxi, right_channel.data());
+	}
 
-		for (size_t j = 1; j < leftC.size(); j++)
-		{
-			double absValLeft = fabs(leftC[j]);
-			if (absValLeft > maxValLeft)
-			{
-				maxValLeft = absValLeft;
-			}
-		}
+	// Same filter over every channel of an interleaved view; returns the interleaved result.
+	static std::vector<short> yLapply_high_pass_filter(const audiofile::AudioView& audio, const std::vector<long double>& coefficients, threading::WorkerPool* pool = nullptr)
+	{
+		WAVEOUT_PROFILE_SCOPE("filter.yLapplyHighPass");
+		const std::vector<double> h(coefficients.begin(), coefficients.end());
+		const size_t n = audio.Frames() * audio.Channels();
+		std::vector<double> filtered(n);
+		dsp::fir_correlate_valid(audio, h, filtered.data(), dsp::FirMethod::Auto, pool);
+
+		std::vector<short> out(n);
+		scaleToShort(filtered.data(), n, maxAbs(filtered.data(), n), out.data());
+		return out;
+	}
 
-		for (size_t k = 1; k < rightC.size(); k++)
+	static double maxAbs(const double* x, size_t n)
+	{
+		double m = 0.0;
+		for (size_t i = 0; i < n; i++)
 		{
-			double absValRight = fabs(rightC[k]);
-			if (absValRight > maxValRight)
-			{
-				maxValRight = absValRight;
-			}
+			m = (std::max)(m, fabs(x[i]));
 		}
+		return m;
+	}
 
-
-		std::cout << "THIS IS MAX VALUE OF LEFT: " << maxValLeft << endl;
-		std::cout << "THIS IS MAX VALUE OF RIGHT: " << maxValRight << endl;
-
-		double maxi = (maxValLeft > maxValRight) ? maxValLeft : maxValRight;
-
-		std::cout << "THIS IS MAXI: " << maxi << endl;
-
-		double scaling_factor = maxi / (SHRT_MAX);
-
-		for (size_t i = 0;i < left_channel.size();i++)
-		{
-			double hey = leftC[i] / scaling_factor;
-			if (hey >= SHRT_MAX)
-			{
-				std::cout << "LEFT SIDE EXCEEDED MAX VALUE AT: " << i << " WITH VALUE: " << hey<<endl;
-				hey--;
-				
-			}
-
-			left_channel[i] = hey;
-		}
-		for (size_t i = 0;i < right_channel.size();i++)
+	//scale so the loudest sample across channels hits SHRT_MAX (nudged down by one so it never wraps)
+	static void scaleToShort(const double* x, size_t n, double maxi, short* out)
+	{
+		const double scaling_factor = (maxi > 0.0) ? maxi / (SHRT_MAX) : 1.0;
+		for (size_t i = 0; i < n; i++)
 		{
-			double hey = rightC[i] / scaling_factor;
+			double hey = x[i] / scaling_factor;
 			if (hey >= SHRT_MAX)
 			{
-				std::cout << "RIGHT SIDE EXCEEDED MAX VALUE AT: " << i << " WITH VALUE: " << hey<<endl;
 				hey--;
 			}
-
-			right_channel[i] = hey;
+			out[i] = hey;
 		}
-
-		
-
-
 	}
 	//-----------------------------------------------------------------------------------------------------------------------------------
 
@@ -252,336 +210,198 @@ public:
 		return b_discrete;
 	}
 
+	// The FFT filters below are overlap-save FIR convolutions (dsp::OverlapSaveConvolver) with a
+	// windowed-sinc kernel, run in fixed power-of-two blocks instead of one complex DFT over the
+	// whole channel. The output keeps the old contract: aligned with the input and peak-normalized
+	// to 32766 per channel. The blocks are transformed in dsp::fft_real (float by default); the
+	// result is quantized to 16 bits anyway. With a pool the channels are filtered concurrently,
+	// each with its own convolver.
+	using AnalysisConvolver = dsp::BasicOverlapSaveConvolver<dsp::fft_real>;
 
-	/*static std::vector<double> lowpass_coefficients(double fc, double Ts)
+	static void lowPassFFTW(std::vector<short>& left, std::vector<short>& right,int sampleRate, int cuttoff, threading::WorkerPool* pool = nullptr)
 	{
-		double pi = 3.14159265358979323846;
-		double K = tan(pi * fc * Ts);
-		double norm = 1 / (1 + K);
-
-		std::vector<double> coefs(5);
-		coefs[0] = K * norm;
-		coefs[1] = 2 * coefs[0];
-		coefs[2] = coefs[0];
-		coefs[3] = 2 * norm * (K - 1);
-		coefs[4] = norm * (1 - K);
-		return coefs;
-	}*/
-
+		firInPlace(left, right, sampleRate, cuttoff, true, pool);
+	}
 
-	static std::vector<long double> lowpass_coefficients(long double fc, long double Ts)
+	static void highPassFFTW(std::vector<short>& left, std::vector<short>& right, int sampleRate, int cutoff, threading::WorkerPool* pool = nullptr)
 	{
-		long double pi = 3.14159265358979323846;
-		long double K = tan(pi * fc * Ts);
-		long double norm = 1 / (1 + K);
-
-		std::vector<long double> coefs(5);
-		coefs[0] = K * norm;
-		coefs[1] = 2 * coefs[0];
-		coefs[2] = coefs[0];
-		coefs[3] = 2 * norm * (K - 1);
-		coefs[4] = norm * (1 - K);
-		return coefs;
+		firInPlace(left, right, sampleRate, cutoff, false, pool);
 	}
 
-	static std::vector<long double> highpass_coefficients(long double fc, long double Ts)
+	static void bandPassFFTW(std::vector<short>& left, std::vector<short>& right, int sampleRate, int lowerBound, int higherBound)
 	{
 
 	}
 
-
-	static void lowPassFFTW(std::vector<short>& left, std::vector<short>& right,int sampleRate, int cuttoff)
+	static void lowPassFFTW_HannWindow(std::vector<short>& left, std::vector<short>& right, int sampleRate, int cutoff, threading::WorkerPool* pool = nullptr)
 	{
-		// Start with Left Side
-		fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * left.size());
-		fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * left.size());
-
-		fftw_plan p = fftw_plan_dft_1d(left.size(), in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-
-		for (int i = 0; i < left.size(); i++)
-		{
-			in[i][0] = left[i]; //populate in with audio data
-			in[i][1] = 0.0;
-		}
-
-		fftw_execute(p);
-
-		double freq_step = (double)sampleRate / left.size();
-		double cutoff_bin = cuttoff / freq_step;					// Modify frequency data past cutoff, make it zero
-		for (int i = cutoff_bin; i < left.size() - cutoff_bin; i++)
-		{
-			out[i][0] = 0.0;
-			out[i][1] = 0.0;
-		}
-
-		fftw_plan q = fftw_plan_dft_1d(left.size(), out, in, FFTW_BACKWARD, FFTW_ESTIMATE); //invert back to time domain
-		fftw_execute(q);
-
-		for (int i = 0; i < left.size(); i++)
-		{
-			left[i] = in[i][0] / left.size(); //modify amplitude
-		}
-
-		//Empty Mem
-		fftw_destroy_plan(p);
-		fftw_destroy_plan(q);
-		fftw_free(in);
-		fftw_free(out);
-
-
-		//Now Do Right Side
-		std::cout << "Did left" << std::endl;
-		fftw_complex* inR = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * right.size());
-		fftw_complex* outR = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * right.size());
-
-		fftw_plan pR = fftw_plan_dft_1d(right.size(), inR, outR, FFTW_FORWARD, FFTW_ESTIMATE);
-		for (int i = 0; i < right.size(); i++)
-		{
-			inR[i][0] = right[i];
-			inR[i][1] = 0.0;
-		}
-
-		fftw_execute(pR);
-
-		double freq_stepR = (double)sampleRate / right.size();
-		double cutoff_binR = cuttoff / freq_stepR;
-		for (int i = cutoff_binR; i < right.size() - cutoff_binR; i++)
-		{
-			outR[i][0] = 0.0;
-			outR[i][1] = 0.0;
-		}
-
-		fftw_plan qR = fftw_plan_dft_1d(right.size(), outR, inR, FFTW_BACKWARD, FFTW_ESTIMATE);
-		fftw_execute(qR);
-
-		for (int i = 0; i < right.size(); i++)
-		{
-			right[i] = inR[i][0] / right.size();
-		}
-
-		//Empty Mem
-		fftw_destroy_plan(pR);
-		fftw_destroy_plan(qR);
-		fftw_free(inR);
-		fftw_free(outR);
+		firInPlace(left, right, sampleRate, cutoff, true, pool);
 	}
 
-	static void highPassFFTW(std::vector<short>& left, std::vector<short>& right, int sampleRate, int cutoff)//ADD NORMALIZATION FACTOR!!!!!!
+	// View-based variants: read each channel straight out of the (interleaved) source and write the
+	// filtered samples into one interleaved output, instead of filtering LeftRight() copies in place
+	// and re-interleaving them with Stereoize().
+	static std::vector<short> lowPassFFTW_HannWindow(const audiofile::AudioView& audio, int sampleRate, int cutoff, threading::WorkerPool* pool = nullptr)
 	{
-		//Left Side
-		fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * left.size());
-		fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * left.size());
-
-		fftw_plan p = fftw_plan_dft_1d(left.size(), in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-
-		for (int i = 0; i < left.size(); i++)
-		{
-			in[i][0] = left[i];
-			in[i][1] = 0.0;
-		}
-		//do fft
-		fftw_execute(p);
-		//modify spectral data
-		double freq_step = (double)sampleRate / left.size();
-		double cutoff_bin = cutoff / freq_step;
-		for (int i = 0; i < cutoff_bin; i++)
-		{
-			out[i][0] = 0.0;
-			out[i][1] = 0.0;
-		}
-		for (int i = left.size() - cutoff_bin; i < left.size(); i++)
-		{
-			out[i][0] = 0.0;
-			out[i][1] = 0.0;
-		}
-
-		//go back to time domain
-		fftw_plan q = fftw_plan_dft_1d(left.size(), out, in, FFTW_BACKWARD, FFTW_ESTIMATE);
-		fftw_execute(q);
-
-		//Get max value of Inverted FFT imag and real
-		std::vector<double> normsL(left.size());
-		for (int i = 0; i < left.size(); i++)
-		{
-			double real = in[i][0];
-			double imag = in[i][1];
-			normsL[i] = std::sqrt(real * real + imag * imag);
-		}
-		double maxValL = *std::max_element(normsL.begin(), normsL.end());
+		WAVEOUT_PROFILE_SCOPE("filter.lowPass");
+		return firView(audio, sampleRate, cutoff, true, pool);
+	}
 
+	static std::vector<short> highPassFFTW(const audiofile::AudioView& audio, int sampleRate, int cutoff, threading::WorkerPool* pool = nullptr)
+	{
+		WAVEOUT_PROFILE_SCOPE("filter.highPass");
+		return firView(audio, sampleRate, cutoff, false, pool);
+	}
 
+	//keepLow: low pass at cutoff, otherwise high pass; same kernels as the two bands of splitBands()
+	static AnalysisConvolver makeAnalysisConvolver(int sampleRate, int cutoff, bool keepLow)
+	{
+		const int taps = dsp::crossover_taps(sampleRate, cutoff);
+		return AnalysisConvolver(keepLow ? dsp::design_lowpass_fir(sampleRate, cutoff, taps)
+			: dsp::design_highpass_fir(sampleRate, cutoff, taps));
+	}
 
-		for (int i = 0; i < left.size(); i++)
+	static std::vector<short> firView(const audiofile::AudioView& audio, int sampleRate, int cutoff, bool keepLow, threading::WorkerPool* pool)
+	{
+		std::vector<short> out(audio.Frames() * audio.Channels());
+		if (audio.empty() || sampleRate <= 0)
 		{
-			left[i] = in[i][0] / maxValL*32766;
+			return out;
 		}
-
-		//Empty Mem
-		fftw_destroy_plan(p);
-		fftw_destroy_plan(q);
-		fftw_free(in);
-		fftw_free(out);
-
-		//Right Side
-		std::cout << "Did left" << std::endl;
-		fftw_complex* inR = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * right.size());
-		fftw_complex* outR = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * right.size());
-
-		fftw_plan pR = fftw_plan_dft_1d(right.size(), inR, outR, FFTW_FORWARD, FFTW_ESTIMATE);
-		for (int i = 0; i < right.size(); i++)
+		std::vector<audiofile::AudioView> channels;
+		std::vector<short*> dst;
+		for (int c = 0; c < audio.Channels(); c++)
 		{
-			inR[i][0] = right[i];
-			inR[i][1] = 0.0;
+			channels.push_back(audio.Channel(c));
+			dst.push_back(out.data() + c);
 		}
+		firChannels(channels, dst, audio.Channels(), sampleRate, cutoff, keepLow, pool);
+		return out;
+	}
 
-		fftw_execute(pR);
-
-		double freq_stepR = (double)sampleRate / right.size();
-		double cutoff_binR = cutoff / freq_stepR;
-		for (int i = 0; i < cutoff_bin; i++)
-		{
-			outR[i][0] = 0.0;
-			outR[i][1] = 0.0;
-		}
-		for (int i = right.size() - cutoff_bin; i < right.size(); i++)
+	static void firInPlace(std::vector<short>& left, std::vector<short>& right, int sampleRate, int cutoff, bool keepLow, threading::WorkerPool* pool)
+	{
+		if (sampleRate <= 0)
 		{
-			outR[i][0] = 0.0;
-			outR[i][1] = 0.0;
+			return;
 		}
+		//the whole channel is filtered into scratch before anything is written back
+		firChannels({ audiofile::AudioView(left.data(), left.size(), 1, 1), audiofile::AudioView(right.data(), right.size(), 1, 1) },
+			{ left.data(), right.data() }, 1, sampleRate, cutoff, keepLow, pool);
+	}
 
-		fftw_plan qR = fftw_plan_dft_1d(right.size(), outR, inR, FFTW_BACKWARD, FFTW_ESTIMATE);
-		fftw_execute(qR);
-		std::vector<double> norms(right.size());
-		for (int i = 0; i < right.size(); i++)
+	//channel c goes to dst[c], outStride apart; every task gets its own convolver and scratch
+	static void firChannels(const std::vector<audiofile::AudioView>& channels, const std::vector<short*>& dst, int outStride,
+		int sampleRate, int cutoff, bool keepLow, threading::WorkerPool* pool)
+	{
+		if (!pool || channels.size() < 2)
 		{
-			double real = inR[i][0];
-			double imag = inR[i][1];
-			norms[i] = std::sqrt(real * real + imag * imag);
+			AnalysisConvolver conv = makeAnalysisConvolver(sampleRate, cutoff, keepLow);
+			std::vector<float> scratch;
+			for (size_t c = 0; c < channels.size(); c++)
+			{
+				firChannel(conv, channels[c], dst[c], outStride, scratch);
+			}
+			return;
 		}
-		double maxVal = *std::max_element(norms.begin(), norms.end());
-
-		for (int i = 0; i < right.size(); i++)
+		threading::TaskGraph graph;
+		for (size_t c = 0; c < channels.size(); c++)
 		{
-			right[i] = inR[i][0] / maxVal*32766;
+			graph.Add("fir channel " + std::to_string(c), [&, c]() {
+				AnalysisConvolver conv = makeAnalysisConvolver(sampleRate, cutoff, keepLow);
+				std::vector<float> scratch;
+				firChannel(conv, channels[c], dst[c], outStride, scratch);
+			});
 		}
-
-		//Empty Mem
-		fftw_destroy_plan(pR);
-		fftw_destroy_plan(qR);
-		fftw_free(inR);
-		fftw_free(outR);
-	}
-
-	static void bandPassFFTW(std::vector<short>& left, std::vector<short>& right, int sampleRate, int lowerBound, int higherBound)
-	{
-
+		graph.RunOrThrow(pool);
 	}
 
-	static void lowPassFFTW_HannWindow(std::vector<short>& left, std::vector<short>& right, int sampleRate, int cutoff)
+	static void firChannel(AnalysisConvolver& conv, const audiofile::AudioView& channel, short* out, int outStride, std::vector<float>& scratch)
 	{
-		// Start with Left Side
-		fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * left.size());
-		fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * left.size());
-
-		fftw_plan p = fftw_plan_dft_1d(left.size(), in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-
-		for (int i = 0; i < left.size(); i++)
-		{
-			in[i][0] = left[i];
-			in[i][1] = 0.0;
-		}
-
-		fftw_execute(p);
-
-		double freq_step = (double)sampleRate / left.size();
-		double cutoff_bin = cutoff / freq_step;
-		for (int i = cutoff_bin; i < left.size() - cutoff_bin; i++)
+		const size_t N = channel.Frames();
+		if (N == 0)
 		{
-			out[i][0] = 0.0;
-			out[i][1] = 0.0;
+			return;
 		}
+		WAVEOUT_PROFILE_SCOPE("filter.firChannel");
+		scratch.resize(N);
+		dsp::fir_filter_aligned(conv, channel.data(), N, channel.Stride(), scratch.data());
+		peakNormalize(scratch.data(), N, out, outStride);
+	}
 
-		fftw_plan q = fftw_plan_dft_1d(left.size(), out, in, FFTW_BACKWARD, FFTW_ESTIMATE);
-		fftw_execute(q);
-
-		//Get max value of Inverted FFT imag and real
-		std::vector<double> normsL(left.size());
-		for (int i = 0; i < left.size(); i++)
+	//scale one filtered channel so its peak lands on 32766
+	static void peakNormalize(const float* x, size_t N, short* out, int outStride)
+	{
+		float maxVal = 0.0f;
+		for (size_t i = 0; i < N; i++)
 		{
-			double real = in[i][0];
-			double imag = in[i][1];
-			normsL[i] = std::sqrt(real * real + imag * imag);
+			maxVal = (std::max)(maxVal, std::fabs(x[i]));
 		}
-		double maxValL = *std::max_element(normsL.begin(), normsL.end());
-
-
-		for (int i = 0; i < left.size(); i++)
+		if (maxVal <= 0.0f)
 		{
-			left[i] = in[i][0] /maxValL *32766;
+			maxVal = 1.0f; //silence stays silent instead of dividing by zero
 		}
-		//Hann Window
-		
-
-
-		//Empty Mem
-		fftw_destroy_plan(p);
-		fftw_destroy_plan(q);
-		fftw_free(in);
-		fftw_free(out);
-
-
-		//Now Do Right Side
-		std::cout << "Did left asdasd" << std::endl;
-		fftw_complex* inR = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * right.size());
-		fftw_complex* outR = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * right.size());
-
-		fftw_plan pR = fftw_plan_dft_1d(right.size(), inR, outR, FFTW_FORWARD, FFTW_ESTIMATE);
-		for (int i = 0; i < right.size(); i++)
+		const double scale = 32766.0 / maxVal;
+		for (size_t i = 0; i < N; i++)
 		{
-			inR[i][0] = right[i];
-			inR[i][1] = 0.0;
+			out[i * outStride] = (short)(x[i] * scale);
 		}
+	}
 
-		fftw_execute(pR);
-
-		double freq_stepR = (double)sampleRate / right.size();
-		double cutoff_binR = cutoff / freq_stepR;
-		for (int i = cutoff_binR; i < right.size() - cutoff_binR; i++)
+	// Crossover split: one pass per channel yields crossovers.size() + 1 bands (low to high), each
+	// interleaved like the input. For crossovers {200} the bands match lowPassFFTW_HannWindow and
+	// highPassFFTW of the same view (to rounding) at half the FFT work of running both. Every band
+	// is peak-normalized per channel like the single filters; the unnormalized bands from
+	// dsp::BandSplitter sum back to the input.
+	static std::vector<std::vector<short>> splitBands(const audiofile::AudioView& audio, int sampleRate, const std::vector<int>& crossovers, threading::WorkerPool* pool = nullptr)
+	{
+		WAVEOUT_PROFILE_SCOPE("filter.splitBands");
+		const size_t bands = crossovers.size() + 1;
+		std::vector<std::vector<short>> out(bands, std::vector<short>(audio.Frames() * audio.Channels()));
+		if (audio.empty() || sampleRate <= 0 || crossovers.empty())
 		{
-			outR[i][0] = 0.0;
-			outR[i][1] = 0.0;
+			return out;
 		}
 
-		fftw_plan qR = fftw_plan_dft_1d(right.size(), outR, inR, FFTW_BACKWARD, FFTW_ESTIMATE);
-		fftw_execute(qR);
+		const std::vector<double> crossoversHz(crossovers.begin(), crossovers.end());
+		const size_t N = audio.Frames();
+		auto splitChannel = [&](dsp::BandSplitter& splitter, int c, std::vector<float>& scratch) {
+			scratch.resize(N * bands);
+			std::vector<float*> dst(bands);
+			for (size_t b = 0; b < bands; b++)
+			{
+				dst[b] = scratch.data() + b * N;
+			}
+			splitter.split(audio.Channel(c), dst.data());
+			for (size_t b = 0; b < bands; b++)
+			{
+				peakNormalize(dst[b], N, out[b].data() + c, audio.Channels());
+			}
+		};
 
-		//Get Max value in inverted FFT array imag and real
-		std::vector<double> norms(right.size());
-		for (int i = 0; i < right.size(); i++) 
+		if (!pool || audio.Channels() < 2)
 		{
-			double real = inR[i][0];
-			double imag = inR[i][1];
-			norms[i] = std::sqrt(real * real + imag * imag);
+			dsp::BandSplitter splitter(sampleRate, crossoversHz);
+			std::vector<float> scratch;
+			for (int c = 0; c < audio.Channels(); c++)
+			{
+				splitChannel(splitter, c, scratch);
+			}
+			return out;
 		}
-		double maxVal = *std::max_element(norms.begin(), norms.end());
-		
-
-
-		for (int i = 0; i < right.size(); i++)
+		//channels write disjoint (interleaved) samples of every band, so they can run side by side
+		threading::TaskGraph graph;
+		for (int c = 0; c < audio.Channels(); c++)
 		{
-			right[i] = inR[i][0] / maxVal *32766;  // float values are still too high, so clipping happens 
+			graph.Add("split channel " + std::to_string(c), [&, c]() {
+				dsp::BandSplitter splitter(sampleRate, crossoversHz);
+				std::vector<float> scratch;
+				splitChannel(splitter, c, scratch);
+			});
 		}
-		//Hann Window
-		
-
-		//Empty Mem
-		fftw_destroy_plan(pR);
-		fftw_destroy_plan(qR);
-		fftw_free(inR);
-		fftw_free(outR);
+		graph.RunOrThrow(pool);
+		return out;
 	}
 
-	
-
 };
 
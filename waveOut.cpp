@@ -1,4 +1,4 @@
-﻿#define _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
 #define _CRT_SECURE_NO_DEPRECATE
 #include <windows.h>
 #include <mmsystem.h>
@@ -22,7 +22,7 @@
 #include "Chunk.h"
 #include "Util.h"
 #include "HighQuality.h"
-#include "GLOBAL.h"
+#include "AnalysisContext.h"
 #include "MidiMaker.h"
 #include "KeyDetection.h"
 #include <iomanip>
@@ -30,6 +30,20 @@
 #include <filesystem>
 #include "BPMDetection.h"
 #include "AudioFileLoader.h"
+#include "AudioView.h"
+#include "MappedFile.h"
+#include "ParallelLoader.h"
+#include "WorkerPool.h"
+#include "TaskGraph.h"
+#include "BatchRunner.h"
+#include "Benchmarks.h"
+#include "Profiler.h"
+#include "FftwPlanCache.h"
+#include "BatchedStft.h"
+#include "ConstantQ.h"
+#include "NoteSegmentor.h"
+#include "AnalysisFrontEnd.h"
+#include "Options.h"
 
 #include <keyfinder/keyfinder.h>
 
@@ -62,113 +76,21 @@ struct LIST
 	char ListTypeID[4];
 };
 static int BPM = 0;
+// Copies the data chunk of a PCM16 WAV out of a memory mapping. Prefer holding an
+// audiofile::MappedWavFile directly when the samples only need to be read.
 static vector<short int> getData(string file)
 {
-	vector<short int> data;
-	struct WAVE_HEADER waveheader;
-	FILE* sound;
-	bool foundList = false;
-	sound = fopen(file.c_str(), "rb");
-	short int D;
-	fread(&waveheader, sizeof(waveheader), 1, sound);
-
-	cout << "Chunk: " << waveheader.Chunk << endl;
-	cout << "Chunk Size: " << waveheader.ChunkSize << endl;
-	cout << "Format: " << waveheader.format << endl;
-
-	cout << "SubChunk1ID: " << waveheader.Sub_chunk1ID << endl;
-	cout << "SubChunk1Size: " << waveheader.Sub_chunk1Size << endl;
-	cout << "Audio Format: " << waveheader.AudioFormat << endl;
-	cout << "Num of Channels: " << waveheader.NumChannels << endl;
-	cout << "SampleRate: " << waveheader.SampleRate << endl;
-	cout << "ByteRate: " << waveheader.ByteRate << endl;
-	cout << "Block Align: " << waveheader.BlockAlign << endl;
-	cout << "Bits Per Sample:" << waveheader.BitsPerSample << endl;
-
-	cout << "SubChunk2ID: " << waveheader.Sub_chunk2ID << endl;
-	cout << "SubChunk2Size: " << waveheader.Sub_chunk2Size << endl;
-	cout << "sizeof " << sizeof(waveheader.BitsPerSample) << " reg " << waveheader.BitsPerSample << endl;
-
-	wstring temp = wstring(file.begin(), file.end());
-	LPCWSTR ws = temp.c_str();
-	HANDLE h = CreateFile(ws, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);	//get Size
-	int size = GetFileSize(h,NULL);
-
-	char lol[4];
-	int location=0;
-	ifstream read;
-	read.open(file);
-	read.seekg(0, read.beg);
-	for (int i = 0;i < size;i++)
-	{
-		try
-		{
-			read.seekg(i);
-			read.read(reinterpret_cast<char*>(&lol), sizeof(lol)); 
-			if (lol[0] == 'L' && lol[1] == 'I' && lol[2] == 'S' && lol[3] == 'T')
-			{
-				location = i;
-				foundList = true;
-				cout << "FOUND LIST AT: " << i << endl;
-				break;
-			}
-		}
-		catch (exception e)
-		{
-		}
-	}
-	cout << "Finished looking for LIST"<<endl;
-	int listSize=0;
-	int positon = 0;
-	if (foundList)
-	{
-		read.seekg(location+4);
-		read.read(reinterpret_cast<char*>(&listSize), sizeof(listSize));
-		cout << listSize << endl;
-		read.seekg(location + 8 + listSize);
-		positon = location + 8 + listSize;
-	}
-	else
-	{
-		positon = 44;
-	}
-	fseek(sound, positon, SEEK_SET);
-	std::chrono::system_clock::time_point now1 = std::chrono::system_clock::now();
-	/*read.seekg(0, read.beg);
-	location = 0;
-	for (int i = 0;i < size;i++)
+	audiofile::MappedWavFile wav;
+	string err;
+	if (!wav.Open(file, &err))
 	{
-		try
-		{
-			read.seekg(i);
-			read.read(reinterpret_cast<char*>(&lol), sizeof(lol));
-			if (lol[0] == 'D' && lol[1] == 'A' && lol[2] == 'T' && lol[3] == 'A')
-			{
-				cout << "FOUND DATA at "<<i<<endl;
-				location = i;
-				break;
-			}
-		}
-		catch (exception e)
-		{
-		}
-	}
-	cout << "Finished finding DATA" << endl;
-	read.seekg(location + 4);
-	int sizeofdata = 0;
-	read.read(reinterpret_cast<char*>(&sizeofdata), 4);
-	char* datas = (char*)&data[0];
-	read.read(datas, sizeofdata);*/
-	while (!feof(sound))
-	{
-		fread(&D, waveheader.BitsPerSample/8, 1, sound);
-		data.push_back(D);
+		cout << "getData failed: " << err << endl;
+		return {};
 	}
-	std::chrono::system_clock::time_point now2 = std::chrono::system_clock::now();
-	std::chrono::duration<double> elapsed = now2 - now1;
-	cout << "Took " << elapsed.count() << " seconds" << endl;
-	cout << "Finished populating vector" << endl;
-	return data;
+	audiofile::Pcm16Span samples = wav.Samples();
+	cout << "Num of Channels: " << wav.Channels() << endl;
+	cout << "SampleRate: " << wav.SampleRate() << endl;
+	return vector<short int>(samples.begin(), samples.end());
 }
 void writeAudioBlock(HWAVEOUT hWaveOut, vector<short int> block, DWORD size)
 {
@@ -230,39 +152,6 @@ static WAVE_HEADER getHDR(string path)
 	fread(&hdr, sizeof(hdr), 1, l);
 	return hdr;
 }
-pair<vector<short int>, vector<short int>> LeftRight(vector<short int> origin)
-{
-	cout << "Size of samples:" << origin.size() << endl;
-	vector<short int> left;
-	vector<short int> right;
-	int size = origin.size();
-	for (int i = 0;i < size;i++)
-	{
-		if (i % 2 == 0)
-		{
-			left.push_back(origin[i]);
-		}
-		else
-		{
-			right.push_back(origin[i]);
-		}
-	}
-	cout << "Size of left: " << left.size()<<endl;
-	cout << "Size of right: " << right.size()<<endl;
-	return make_pair(left, right);
-}
-vector<short int> Consolidate(vector<short int> left,vector<short int> right)
-{
-	vector<short int> consolidated;
-	int size = (left.size() + right.size())/2;
-
-	for (int i = 0;i < size;i++)
-	{
-		consolidated.push_back((left[i] + right[i]) / 2);
-	}
-	cout <<"SIZE "<< consolidated.size() << endl;
-	return consolidated;
-}
 vector<short> Stereoize(vector<short> left, vector<short> right)
 {
 	size_t num_samples = min(left.size(), right.size());
@@ -277,54 +166,77 @@ vector<short> Stereoize(vector<short> left, vector<short> right)
 	return interleaved;
 }
 
-static std::vector<short> ForceInterleavedStereo(const std::vector<short>& src, int channels)
+int main(int argc, char* argv[])
 {
-	if (channels <= 0 || src.empty()) return {};
-
-	if (channels == 2)
-		return src;
-
-	const size_t ch = static_cast<size_t>(channels);
-	const size_t frames = src.size() / ch;
-	std::vector<short> out(frames * 2, 0);
-
-	if (channels == 1)
+	// waveOut --batch [-j N] [-t N] [-o dir] [--stems] [-l list.txt] <file|dir|glob>...
+	smf::Options opts;
+	opts.define("b|batch=b", "Analyze the inputs headlessly: no windows, no playback");
+	opts.define("j|jobs=i:0", "Tracks analyzed concurrently in batch mode (0 = one per worker thread)");
+	opts.define("t|threads=i:0", "Worker threads shared by every analysis stage (0 = one per core)");
+	opts.define("o|output=s:analysis_results", "Directory for the per-track .analysis.json files");
+	opts.define("s|stems=b", "Run demucs stem separation for every track in batch mode");
+	opts.define("l|list=s", "Text file with one input (file, directory or glob) per line");
+	opts.define("bench=s", "Run a micro-benchmark and exit: fir, precision, midi");
+	opts.define("fftw-planner=s:measure", "FFTW planning effort: estimate, measure or patient");
+	opts.define("fftw-wisdom=s", "FFTW wisdom file (default: <temp>/waveOut/fftw.wisdom)");
+	opts.define("analysis-rate=i:11025", "Sample rate key and BPM detection run at (0 = source rate)");
+	opts.define("analysis-window=s", "Only estimate tempo and key on OFFSET:SECONDS of each track, e.g. 10:150");
+	opts.define("pitch-bins=i:36", "Constant-Q bins per octave for note detection: 12, 24 or 36 (0 = linear FFT peaks)");
+	opts.process(argc, argv);
+
+	analysis::FrontEndOptions frontEnd;
+	frontEnd.targetSampleRate = opts.getInteger("analysis-rate");
+	if (!opts.getString("analysis-window").empty() && !analysis::ParseCropWindow(opts.getString("analysis-window"), frontEnd))
 	{
-		for (size_t i = 0; i < frames; ++i)
-		{
-			const short s = src[i];
-			out[2 * i] = s;
-			out[2 * i + 1] = s;
-		}
-		return out;
+		std::cerr << "Ignoring malformed --analysis-window '" << opts.getString("analysis-window") << "' (expected OFFSET:SECONDS)" << std::endl;
 	}
 
-	// Downmix multi-channel inputs to stereo by averaging even/odd channel groups.
-	for (size_t i = 0; i < frames; ++i)
+	// Plans are measured once per machine and size, then come back from the wisdom file.
+	dsp::FftwPlanCache& fftPlans = dsp::FftwPlanCache::instance();
+	unsigned plannerFlags = FFTW_MEASURE;
+	if (!dsp::FftwPlanCache::parse_planner_flags(opts.getString("fftw-planner"), plannerFlags))
+	{
+		std::cerr << "Unknown --fftw-planner '" << opts.getString("fftw-planner") << "', using measure" << std::endl;
+	}
+	fftPlans.set_planner_flags(plannerFlags);
+	const std::filesystem::path wisdomPath = opts.getString("fftw-wisdom").empty()
+		? dsp::FftwPlanCache::default_wisdom_path()
+		: std::filesystem::path(opts.getString("fftw-wisdom"));
+	if (!opts.getString("fftw-wisdom").empty())
 	{
-		const size_t base = i * ch;
-		long long accL = 0;
-		long long accR = 0;
-		int nL = 0;
-		int nR = 0;
-		for (int c = 0; c < channels; ++c)
+		fftPlans.load_wisdom(wisdomPath);
+	}
+	auto saveWisdom = [&]() {
+		std::string error;
+		if (!fftPlans.save_wisdom(wisdomPath, &error))
 		{
-			const short s = src[base + static_cast<size_t>(c)];
-			if ((c % 2) == 0) { accL += s; ++nL; }
-			else { accR += s; ++nR; }
+			std::cerr << error << std::endl;
 		}
-		if (nL == 0) { accL = accR; nL = (nR > 0 ? nR : 1); }
-		if (nR == 0) { accR = accL; nR = (nL > 0 ? nL : 1); }
-		out[2 * i] = static_cast<short>(accL / nL);
-		out[2 * i + 1] = static_cast<short>(accR / nR);
+	};
+
+	if (!opts.getString("bench").empty())
+	{
+		const int rc = bench::Run(opts.getString("bench"));
+		saveWisdom();
+		return rc;
 	}
-	return out;
-}
 
+	if (opts.getBoolean("batch"))
+	{
+		analysis::BatchOptions batch;
+		batch.inputs = opts.getArgList();
+		batch.listFile = opts.getString("list");
+		batch.jobs = static_cast<size_t>((std::max)(0, opts.getInteger("jobs")));
+		batch.threads = static_cast<size_t>((std::max)(0, opts.getInteger("threads")));
+		batch.outputDir = opts.getString("output");
+		batch.runStemSeparation = opts.getBoolean("stems");
+		batch.frontEnd = frontEnd;
+		batch.pitchBinsPerOctave = opts.getInteger("pitch-bins");
+		const int rc = analysis::RunBatch(batch);
+		saveWisdom();
+		return rc;
+	}
 
-int main(int argc, char* argv[])
-{
-	
 	HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
 
 	SetConsoleTextAttribute(hConsole, FOREGROUND_BLUE);
@@ -345,6 +257,15 @@ int main(int argc, char* argv[])
 	std::filesystem::path p(file);
 	string filename = p.stem().string();
 
+	// One pool loads the source mix and the four stems concurrently. The source
+	// decode does not depend on demucs, so it runs while stem separation is in progress.
+	// Warm starts map the previously decoded PCM out of the decode cache instead of re-decoding.
+	// Every later stage fans out onto the same pool, so --threads caps the whole run.
+	threading::WorkerPool loadPool(static_cast<size_t>((std::max)(0, opts.getInteger("threads"))));
+	audiofile::DecodeCache decodeCache;
+	std::future<audiofile::LoadedAudio> sourceFuture =
+		audiofile::ParallelLoader::LoadAsync(loadPool, { file, audiofile::LoadMode::Decode, &decodeCache });
+
 	std::cout << "Running Stem Seperation with CUDA!" << endl;
 	StemSeperator::split(file);
 	std::cout << "Finished!" << endl;
@@ -357,44 +278,68 @@ int main(int argc, char* argv[])
 	string other = "separated/htdemucs_ft/"+filename+"/other.wav";
 
 
-	//lets load these files
-	WAVE_HEADER bassHdr = getHDR(bass);
-	WAVE_HEADER vocalsHdr = getHDR(vocals);
-	WAVE_HEADER drumsHdr = getHDR(drums);
-	WAVE_HEADER otherHdr = getHDR(other);
-
-	vector<short int> bassData = getData(bass);
-	vector<short int> vocalData = getData(vocals);
-	vector<short int> drumData = getData(drums);
-	vector<short int> chordData = getData(other);
+	//lets load these files. PCM16 stems are memory-mapped (O(1), backed by the page cache), anything
+	//else is decoded. The results must stay alive for as long as the waveform window plays them.
+	std::vector<std::future<audiofile::LoadedAudio>> stemFutures = audiofile::ParallelLoader::LoadAllAsync(loadPool, {
+		{ bass, audiofile::LoadMode::MapOrDecode },
+		{ vocals, audiofile::LoadMode::MapOrDecode },
+		{ drums, audiofile::LoadMode::MapOrDecode },
+		{ other, audiofile::LoadMode::MapOrDecode } });
+	audiofile::LoadedAudio bassWav = stemFutures[0].get();
+	audiofile::LoadedAudio vocalsWav = stemFutures[1].get();
+	audiofile::LoadedAudio drumsWav = stemFutures[2].get();
+	audiofile::LoadedAudio otherWav = stemFutures[3].get();
+	for (const audiofile::LoadedAudio* stem : { &bassWav, &vocalsWav, &drumsWav, &otherWav })
+	{
+		if (!stem->ok)
+			std::cerr << "Failed to load stem, it will be silent: " << stem->error << std::endl;
+	}
 	std::cout << "Loaded stems into memory" << endl;
 	std::cout << "Stem sample rates/channels: "
-		<< "vocals=" << vocalsHdr.SampleRate << "Hz/" << vocalsHdr.NumChannels << "ch, "
-		<< "drums=" << drumsHdr.SampleRate << "Hz/" << drumsHdr.NumChannels << "ch, "
-		<< "bass=" << bassHdr.SampleRate << "Hz/" << bassHdr.NumChannels << "ch, "
-		<< "chords=" << otherHdr.SampleRate << "Hz/" << otherHdr.NumChannels << "ch" << endl;
-	Key SONG_KEY = Key::NO_KEY;
-	GLOBAL::MUSICAL_KEY = SONG_KEY;
-	GLOBAL::isMonophonic = true; //WORK ON THIS NEXT ------------------------------------------------------------------------------------------ L()()K
+		<< "vocals=" << vocalsWav.SampleRate() << "Hz/" << vocalsWav.Channels() << "ch, "
+		<< "drums=" << drumsWav.SampleRate() << "Hz/" << drumsWav.Channels() << "ch, "
+		<< "bass=" << bassWav.SampleRate() << "Hz/" << bassWav.Channels() << "ch, "
+		<< "chords=" << otherWav.SampleRate() << "Hz/" << otherWav.Channels() << "ch" << endl;
 	std::cout << file << endl;
 	HWAVEOUT hWaveOut;
 	LPSTR block;
 	DWORD blockSize;
-	audiofile::DecodedPcm16 decodedMain;
-	std::string decodeError;
-	if (!audiofile::AudioFileLoader::LoadPcm16(file, decodedMain, &decodeError))
+	audiofile::LoadedAudio sourceAudio = sourceFuture.get();
+	if (!sourceAudio.ok)
 	{
-		std::cerr << "Failed to decode source audio (" << file << "): " << decodeError << std::endl;
+		std::cerr << "Failed to decode source audio (" << file << "): " << sourceAudio.error << std::endl;
 		return 1;
 	}
-	vector<short int> pcmData = ForceInterleavedStereo(decodedMain.samples, decodedMain.channels);
+	const int sourceChannels = sourceAudio.Channels();
+	const int sourceSampleRate = sourceAudio.SampleRate();
+	const bool sourceFromCache = sourceAudio.mapped.IsOpen();
+	vector<short int> pcmData = (!sourceFromCache && sourceChannels == 2)
+		? std::move(sourceAudio.decoded.samples)
+		: audiofile::AudioFileLoader::ToInterleavedStereo(sourceAudio.Samples(), sourceChannels);
 	if (pcmData.empty())
 	{
 		std::cerr << "Decoded source audio is empty after stereo conversion: " << file << std::endl;
 		return 1;
 	}
-	std::cout << "Loaded source audio via AudioFileLoader: "
-		<< decodedMain.channels << "ch @" << decodedMain.sampleRate << "Hz -> stereo PCM16 (" << pcmData.size() / 2 << " frames)" << std::endl;
+	std::cout << "Loaded source audio " << (sourceFromCache ? "from decode cache: " : "via AudioFileLoader: ")
+		<< sourceChannels << "ch @" << sourceSampleRate << "Hz -> stereo PCM16 (" << pcmData.size() / 2 << " frames)" << std::endl;
+
+	// Stems that come back at a different rate than the mix are converted once, here, so the
+	// mixer and the audio engine can read them frame-for-frame instead of resampling per sample.
+	{
+		threading::TaskGraph conformGraph;
+		for (audiofile::LoadedAudio* stem : { &bassWav, &vocalsWav, &drumsWav, &otherWav })
+		{
+			if (!stem->ok || stem->SampleRate() == sourceSampleRate) continue;
+			std::cout << "Resampling stem " << stem->path << " " << stem->SampleRate() << "Hz -> " << sourceSampleRate << "Hz" << std::endl;
+			conformGraph.Add("conformStem", [stem, sourceSampleRate]() {
+				audiofile::ParallelLoader::ConformSampleRate(*stem, sourceSampleRate);
+			});
+		}
+		string conformError;
+		if (!conformGraph.Run(&loadPool, &conformError))
+			std::cerr << "Stem resampling failed: " << conformError << std::endl;
+	}
 
 	WAVE_HEADER wav{};
 	std::memcpy(wav.Chunk, "RIFF", 4);
@@ -404,7 +349,7 @@ int main(int argc, char* argv[])
 	wav.Sub_chunk1Size = 16;
 	wav.AudioFormat = 1;
 	wav.NumChannels = 2;
-	wav.SampleRate = decodedMain.sampleRate;
+	wav.SampleRate = sourceSampleRate;
 	wav.BitsPerSample = 16;
 	wav.BlockAlign = static_cast<short>(wav.NumChannels * (wav.BitsPerSample / 8));
 	wav.ByteRate = wav.SampleRate * wav.BlockAlign;
@@ -440,27 +385,55 @@ int main(int argc, char* argv[])
 
 	vector<long double> coefficients = filter::yLcalculate_high_pass_filter_coefficients(wav.SampleRate,1000,1000 ); //crappy filter or coefficients after like 500 hz there is crackling; 550hz only one instance of fucked up audio
 	//                                                                                                      600hz kicks up the shit audio & 700hz nails the coffin, num_taps does not fix this at all // reason gives
-	pair<vector<short>, vector<short>> dat1 = LeftRight(pcmData);                                           // cracks even at 500 hz at kicks
-	vector<short> left = dat1.first;
-	vector<short> right = dat1.second;
-
-	vector<double> leftD = filter::short_to_double(left);
-	vector<double> rightD = filter::short_to_double(right);
-
-
-	//get Song Key and BPM
-	
-	vector<short int> mono = Consolidate(dat1.first, dat1.second);
-	vector<double> monoD = filter::short_to_double(mono);
-	
-	KeyFinder::KeyFinder kf;
-
-	Key k = KeyDetection::getKey(monoD, wav.SampleRate, kf);
+	//                                                                                                      cracks even at 500 hz at kicks
+	// Every stage reads pcmData through this view: channels are picked and mono is downmixed on
+	// the fly instead of materializing per-channel and mono copies of the whole song.
+	const audiofile::AudioView audio = audiofile::AudioView::Interleaved(pcmData, 2);
+
+	// Key, beat grid, the band split and the FIR convolution only depend on the decoded PCM,
+	// so they run side by side on the load pool; the graph reports how long each one took.
+	Key k = Key::NO_KEY;
+	BPMDetection::BeatGridEstimate gridEstimate;
+	int cuttoff_f = 200;
+	vector<short int> lowPassDat;
+	vector<short int> highPassDat;
+	vector<short> convolutionData;
+
+	fftw_make_planner_thread_safe();
+	fftwf_make_planner_thread_safe();
+	threading::TaskGraph analysisGraph;
+	// Key and tempo share one decimated mono signal instead of each downmixing the full-rate PCM.
+	analysis::AnalysisSignal analysisSignal;
+	const auto frontEndTask = analysisGraph.Add("analysis front end", [&]() {
+		analysisSignal = analysis::BuildAnalysisSignal(audio, wav.SampleRate, frontEnd);
+	});
+	analysisGraph.Add("key", [&]() {
+		KeyFinder::KeyFinder kf;
+		k = KeyDetection::getKey(analysisSignal, kf);
+	}, { frontEndTask });
+	// get BPM + initial grid anchor (t0) using aubio + simple onset/kick logic
+	analysisGraph.Add("beat grid", [&]() {
+		gridEstimate = BPMDetection::estimateBeatGridMonoAubio(analysisSignal);
+	}, { frontEndTask });
+	//low and high band come out of one crossover pass
+	analysisGraph.Add("band split", [&]() {
+		vector<vector<short>> bands = filter::splitBands(audio, wav.SampleRate, { cuttoff_f }, &loadPool);
+		lowPassDat = std::move(bands[0]);
+		highPassDat = std::move(bands[1]);
+	});
+	/////////////////////////LOW PASS CONVOLUTION////////////////////////////
+	analysisGraph.Add("fir convolution", [&]() {
+		convolutionData = filter::yLapply_high_pass_filter(audio, coefficients, &loadPool);
+	});
+	string graphError;
+	if (!analysisGraph.Run(&loadPool, &graphError))
+	{
+		std::cerr << "Analysis failed: " << graphError << std::endl;
+		return 1;
+	}
+	cout << "Analysis stage timings:\n" << analysisGraph.FormatTimings();
 
 	string key = Util::getEnumString(k);
-
-	// get BPM + initial grid anchor (t0) using aubio + simple onset/kick logic
-	BPMDetection::BeatGridEstimate gridEstimate = BPMDetection::estimateBeatGridMonoAubio(monoD, wav.SampleRate);
 	BPM = static_cast<int>(std::round(gridEstimate.bpm));
 	if (BPM <= 0) BPM = 120;
 
@@ -470,15 +443,8 @@ int main(int argc, char* argv[])
 		<< ", onset=" << gridEstimate.approxOnset << ", kick=" << gridEstimate.kickAttack << ")\n";
 	cout << "Song Key: " << Util::getEnumString(k) << endl;
 	
-	
-
-
-
-
-
-	
 	cout << "Finished oh yea \n";
-	vector<short int> data = Stereoize(left, right);
+	vector<short int>& data = pcmData;
 	cout<<"Max Value is : " << *max_element(data.begin(), data.end()) << endl;
 	
 	//writeAudioBlock(hWaveOut, data, blockSize);
@@ -487,49 +453,12 @@ int main(int argc, char* argv[])
 	//HighQuality l("Test/nightdrive.wav");
 	//l.Init();
 
-	int cuttoff_f = 200;
-	vector<short> leftLowPass = dat1.first;
-	vector<short> rightLowPass = dat1.second;
-	filter::lowPassFFTW_HannWindow(leftLowPass, rightLowPass, wav.SampleRate, cuttoff_f);
-	vector<short int> lowPassDat = Stereoize(leftLowPass, rightLowPass);
-
-
-	leftLowPass.clear();
-	rightLowPass.clear();
-	leftLowPass.shrink_to_fit();
-	rightLowPass.shrink_to_fit();
-
-
-	vector<short> leftHighPass = dat1.first;
-	vector<short> rightHighPass = dat1.second;
-	filter::highPassFFTW(leftHighPass, rightHighPass, wav.SampleRate, cuttoff_f);
-	vector<short int> highPassDat = Stereoize(leftHighPass, rightHighPass);
-
-	leftHighPass.clear();
-	rightHighPass.clear();
-	leftHighPass.shrink_to_fit();
-	rightHighPass.shrink_to_fit();
-
-
-
-	/////////////////////////LOW PASS CONVOLUTION////////////////////////////
-
-	vector<short> properL = dat1.first;
-	vector<short> properR = dat1.second;
-	filter::yLapply_high_pass_filter(properL, properR, coefficients);
-	vector<short> convolutionData = Stereoize(properL, properR);
-
-	//////////////////////////////////////////////////////////////////////////
-
 	/////////////////////EFFECT SIDECHAIN////////////////////////////////////
 
 
 	float twoBeatDuration = (1 / (BPM / 60.0)) / 0.5;
 	float qBeatDuration = (1.0 / (BPM / 60.0)) / 4.0;
 	
-	GLOBAL::qBeatDuration = qBeatDuration;
-	GLOBAL::sampleRate = wav.SampleRate;
-	GLOBAL::twoBeatDuration = twoBeatDuration;
 
 	int sampleSizeQuart = qBeatDuration * wav.SampleRate;
 	int sampleSizeTwo = twoBeatDuration * wav.SampleRate;
@@ -550,8 +479,8 @@ int main(int argc, char* argv[])
 
 
 
-	pair<vector<short int>, vector<short int>> dat = LeftRight(data);//use pcmData for unfiltered fft, data for filtered fft
-	vector<short int> preProcData = Consolidate(dat.first, dat.second);
+	vector<short int> preProcData(audio.Frames());//use pcmData for unfiltered fft, data for filtered fft
+	audio.CopyMono(preProcData.data());
 	vector<double> audiodata(preProcData.begin(), preProcData.end());
 	cout << "BPM: " << BPM << endl;
 	cout << qBeatDuration<<endl;    
@@ -559,11 +488,11 @@ int main(int argc, char* argv[])
 	int numOfChunks = audiodata.size() /( sampleSize*2);
 	cout <<"THIS IS SAMPLESIZE MAIN FUNC " << sampleSize << endl;
 	cout << "Length of Audio is " << numOfChunks * qBeatDuration << " seconds \n";
-	GLOBAL::SONG_LENGTH = numOfChunks * qBeatDuration;
-	vector<vector<double>> sampleChunks;
+	analysis::AnalysisContext ctx = analysis::AnalysisContext::FromTempo(wav.SampleRate, BPM, k, numOfChunks * qBeatDuration);
+	ctx.pitchBinsPerOctave = opts.getInteger("pitch-bins");
+	ctx.isMonophonic = true; //WORK ON THIS NEXT ------------------------------------------------------------------------------------------ L()()K
 	int inputSize = 1024;//4096 wont work; possible error in how the output data is being stored
 	int outputSize = (inputSize / 2) + 1;
-	int flags = FFTW_ESTIMATE;
 	cout << "HELLO THIS IS NUMOFCHUNKS MAIN FUNC " <<numOfChunks <<endl;
 	cout <<"THIS IS AUDIODATA SIZE MAIN FUNC " << audiodata.size() << endl;
 
@@ -580,18 +509,18 @@ int main(int argc, char* argv[])
 	gridCfg.kickAttackSeconds = gridEstimate.kickAttack;
 	WaveformWindow::StemPlaybackConfig stemCfg;
 	stemCfg.enabled = true;
-	stemCfg.vocalsInterleavedStereo = &vocalData;
-	stemCfg.vocalsSampleRate = vocalsHdr.SampleRate;
-	stemCfg.vocalsChannels = vocalsHdr.NumChannels;
-	stemCfg.drumsInterleavedStereo = &drumData;
-	stemCfg.drumsSampleRate = drumsHdr.SampleRate;
-	stemCfg.drumsChannels = drumsHdr.NumChannels;
-	stemCfg.bassInterleavedStereo = &bassData;
-	stemCfg.bassSampleRate = bassHdr.SampleRate;
-	stemCfg.bassChannels = bassHdr.NumChannels;
-	stemCfg.chordsInterleavedStereo = &chordData;
-	stemCfg.chordsSampleRate = otherHdr.SampleRate;
-	stemCfg.chordsChannels = otherHdr.NumChannels;
+	stemCfg.vocalsInterleavedStereo = vocalsWav.Samples();
+	stemCfg.vocalsSampleRate = vocalsWav.SampleRate();
+	stemCfg.vocalsChannels = vocalsWav.Channels();
+	stemCfg.drumsInterleavedStereo = drumsWav.Samples();
+	stemCfg.drumsSampleRate = drumsWav.SampleRate();
+	stemCfg.drumsChannels = drumsWav.Channels();
+	stemCfg.bassInterleavedStereo = bassWav.Samples();
+	stemCfg.bassSampleRate = bassWav.SampleRate();
+	stemCfg.bassChannels = bassWav.Channels();
+	stemCfg.chordsInterleavedStereo = otherWav.Samples();
+	stemCfg.chordsSampleRate = otherWav.SampleRate();
+	stemCfg.chordsChannels = otherWav.Channels();
 	std::wstring sourcePathHint = std::wstring(file.begin(), file.end());
 	WaveformWindow::ShowWaveformAsyncRefPlayStereoGridStems(&data, wav.SampleRate, true, gridCfg, stemCfg, wname, sourcePathHint);
 	std::wstring sname = std::wstring(filename.begin(), filename.end()) + L" - Spectrum Analyzer";
@@ -605,87 +534,101 @@ int main(int argc, char* argv[])
 
 	vector<Chunk> chunkData;
 	cout << "starting chunk haha" << endl;
-	pair<vector<short int>, vector<short int>> lowP = LeftRight(lowPassDat);
-	pair<vector<short int>, vector<short int>> highP = LeftRight(highPassDat);
+	const audiofile::AudioView lowPassView = audiofile::AudioView::Interleaved(lowPassDat, 2);
+	const audiofile::AudioView highPassView = audiofile::AudioView::Interleaved(highPassDat, 2);
 
 
 	cout << "THIS IS LOWPASS DAT SIZE: " << lowPassDat.size() << endl;
 
 
-	vector<short int> lowPP = Consolidate(lowP.first, lowP.second);
-	vector<short int> highPP = Consolidate(highP.first, highP.second);
-	cout << "THIS IS LOWPP SIZE: " << lowPP.size()<<endl;
-	vector<Chunk> cDat = MidiMaker::lowPass(lowPP);
+	cout << "THIS IS LOWPASS FRAMES: " << lowPassView.Frames()<<endl;
+	//the two bands are independent, so they are chunked side by side
+	analysis::ChunkStore cDat;
+	analysis::ChunkStore midPass;
+	threading::TaskGraph chunkGraph;
+	chunkGraph.Add("midi low", [&]() { cDat = MidiMaker::lowPass(lowPassView, ctx, &loadPool); });
+	chunkGraph.Add("midi high", [&]() { midPass = MidiMaker::highPass(highPassView, ctx, &loadPool); }); //I THINK CHUNKS ARENT BEING DONE PROPERLY TIMING IS WRONG
+	if (!chunkGraph.Run(&loadPool, &graphError))
+	{
+		std::cerr << "Chunking failed: " << graphError << std::endl;
+		return 1;
+	}
 	cout << "DID LOW PASS\n";
-	vector<Chunk> midPass = MidiMaker::highPass(highPP); //I THINK CHUNKS ARENT BEING DONE PROPERLY TIMING IS WRONG
 
-	std::cout << "This is chunk seperation time: " << GLOBAL::twoBeatDuration << "s" << endl;
-	for (Chunk c : cDat)
+	std::cout << "This is chunk seperation time: " << ctx.twoBeatDuration << "s" << endl;
+	if (cDat.IsClamped())
 	{
-		vector<Keys> p = c.getKeyVec();
-		vector<double> inten = c.getIntenVec();
-		for (int i = 0;i<p.size();i++)
+		for (size_t c = 0;c < cDat.Size();c++)
 		{
-			cout << "Low Pass iteration: "<< c.getIter()<<" TIME: "<<c.getStart() <<" to "<<c.getEnd() <<" Intensity: "<< 20*log(inten[i]/32768) << " Key: " << Util::getEnumString(p[i]) << endl;
+			const Keys* p = cDat.Notes(c);
+			const double* inten = cDat.Magnitudes(c);
+			for (int i = 0;i < cDat.PeaksPerChunk();i++)
+			{
+				cout << "Low Pass iteration: "<< cDat.Index(c)<<" TIME: "<<cDat.StartSeconds(c) <<" to "<<cDat.EndSeconds(c) <<" Intensity: "<< 20*log(inten[i]/32768) << " Key: " << Util::getEnumString(p[i]) << endl;
+			}
 		}
 	}
 	cout << endl;
-	for (Chunk q : midPass)
+	if (midPass.IsClamped())
 	{
-		vector<Keys> p = q.getKeyVec();
-		vector<double> inten = q.getIntenVec();
-		vector<double> freqvec = q.getFreqV();
-		for (int i = 0;i<p.size();i++)
+		for (size_t q = 0;q < midPass.Size();q++)
 		{
-			cout << "High Pass iteration: " << q.getIter() <<" TIME: "<<q.getStart()<<" to "<<q.getEnd() <<" Frequency: "<<freqvec[i]<<" Hz " << " Intensity: " << 20 * log(inten[i] / 32768) << " Key: " << Util::getEnumString(p[i]) << endl;
+			const Keys* p = midPass.Notes(q);
+			const double* inten = midPass.Magnitudes(q);
+			const double* freqvec = midPass.Frequencies(q);
+			for (int i = 0;i < midPass.PeaksPerChunk();i++)
+			{
+				cout << "High Pass iteration: " << midPass.Index(q) <<" TIME: "<<midPass.StartSeconds(q)<<" to "<<midPass.EndSeconds(q) <<" Frequency: "<<freqvec[i]<<" Hz " << " Intensity: " << 20 * log(inten[i] / 32768) << " Key: " << Util::getEnumString(p[i]) << endl;
+			}
 		}
 	}
 
 
-	for (int i = 0;i < numOfChunks;i++)
+	// Strongest note of every sampleSize hop: one constant-Q frame per chunk (C1-C8, semitone bins),
+	// or the peak of a 1024-point FFT with --pitch-bins=0.
+	if (ctx.pitchBinsPerOctave > 0)
 	{
-		for (int j = 0;j < sampleSize;j++)
+		dsp::ConstantQConfig chunkCq;
+		chunkCq.sampleRate = wav.SampleRate;
+		chunkCq.minMidi = 24;
+		chunkCq.maxMidi = 108;
+		chunkCq.binsPerOctave = ctx.pitchBinsPerOctave;
+		chunkCq.q = dsp::semitone_q();
+		chunkCq.hop = sampleSize;
+		dsp::ConstantQFrames chunkNotes;
+		dsp::ConstantQ(chunkCq).analyze(audio, chunkNotes, &loadPool, numOfChunks);
+		vector<double> noteMagnitudes(chunkNotes.notes());
+		for (int i = 0;i < chunkNotes.frames;i++)
 		{
-			sampleChunks[i].push_back(audiodata[(i*sampleSize)+j]);
+			chunkNotes.note_magnitudes(i, noteMagnitudes.data());
+			const int note = (int)distance(noteMagnitudes.begin(), max_element(noteMagnitudes.begin(), noteMagnitudes.end()));
+			vector<double> freqVector = { dsp::midi_to_hz(chunkNotes.minMidi + note) };
+			vector<double> intenVector = { 1.0 };
+
+			Chunk chunk = Chunk(make_pair(freqVector, intenVector), i, qBeatDuration * (i + 1), qBeatDuration * (i + 2));
+			chunkData.push_back(chunk);
 		}
 	}
-	int N = 10;
-	for (int i = 0;i < numOfChunks;i++)
+	else
 	{
-		// compute FFT for chunk i
-		fftw_complex* output_buffer = static_cast<fftw_complex*>(fftw_malloc(outputSize * sizeof(fftw_complex)));
-		fftw_plan plan = fftw_plan_dft_r2c_1d(inputSize, &sampleChunks[i][0], output_buffer, flags);
-		fftw_execute(plan);
-
-		vector<double> test;
-		for (int k = 0; k < outputSize - 1; ++k)
-		{
-			test.push_back((double)output_buffer[k][0]);
-		}
-
-		auto lol = max_element(test.begin(), test.end());
-		double frequency = distance(begin(test), lol) * (wav.SampleRate / inputSize);
-		vector<double> freqVector = { frequency };
-		vector<double> intenVector = { 1.0 };
-
-		Chunk chunk = Chunk(make_pair(freqVector, intenVector), i, qBeatDuration * (i + 1), qBeatDuration * (i + 2));
-		chunkData.push_back(chunk);
-
-		// build index list and find top-N safely
-		vector<size_t> index(test.size());
-		iota(index.begin(), index.end(), 0);               // FIX: fill index, not test
-		int topN = std::min<int>(N, static_cast<int>(index.size()));
-		if (topN > 0)
+		// One batched STFT over every chunk: inputSize-sample frames, one per sampleSize hop.
+		dsp::StftConfig chunkStft;
+		chunkStft.frameSize = inputSize;
+		chunkStft.hop = sampleSize;
+		chunkStft.window = dsp::StftWindow::Rectangular;
+		dsp::StftMagnitudes chunkSpectra;
+		dsp::BatchedStft(chunkStft).analyze(audiodata.data(), audiodata.size(), chunkSpectra, &loadPool, numOfChunks);
+		for (int i = 0;i < chunkSpectra.frames;i++)
 		{
-			std::partial_sort(index.begin(), index.begin() + topN, index.end(),
-				[&](size_t A, size_t B) {
-					return test[A] > test[B];
-				});
+			const double* spectrum = chunkSpectra.frame(i);
+			const double* lol = max_element(spectrum, spectrum + outputSize - 1);
+			double frequency = distance(spectrum, lol) * (wav.SampleRate / inputSize);
+			vector<double> freqVector = { frequency };
+			vector<double> intenVector = { 1.0 };
+
+			Chunk chunk = Chunk(make_pair(freqVector, intenVector), i, qBeatDuration * (i + 1), qBeatDuration * (i + 2));
+			chunkData.push_back(chunk);
 		}
-
-		// cleanup FFTW allocations & plan
-		fftw_destroy_plan(plan);
-		fftw_free(output_buffer);
 	}
 
 	cout << "Length of ChunkData " << chunkData.size() << " \n";
@@ -694,6 +637,16 @@ int main(int argc, char* argv[])
 
 
 	//WRITE TO MIDI
+	string midiName = "transcription.mid";
+	string midiError;
+	const vector<MidiStem> midiStems = {
+		{ "Low Pass", &cDat, 0, 33 },  // fingered bass
+		{ "High Pass", &midPass, 1, 0 }, // piano
+	};
+	if (!MidiMaker::makeMidi(midiStems, gridEstimate, midiName, &midiError))
+	{
+		std::cerr << "MIDI export failed: " << midiError << std::endl;
+	}
 
 
 
@@ -704,9 +657,9 @@ int main(int argc, char* argv[])
 	string aja = "bigboi.wav";
 	string ooo = "jaj.wav";
 	string sid = "delay.wav";
-	Util::createWavFile(lowPassDat,wav.ChunkSize,fName);
-	Util::createWavFile(highPassDat, wav.ChunkSize, lola);
-	Util::createWavFile(convolutionData, wav.ChunkSize, smar);
+	Util::createWavFile(lowPassDat,wav.SampleRate, fName);
+	Util::createWavFile(highPassDat, wav.SampleRate, lola);
+	Util::createWavFile(convolutionData, wav.SampleRate, smar);
 	cout << "Convolution Data Size: " << convolutionData.size() << " wav.Chunksize: " << wav.ChunkSize << endl;
 	//MidiMaker::doSomething();
 	vector<double> j = Util::normalizeVector16(preProcData, 16);
@@ -714,13 +667,13 @@ int main(int argc, char* argv[])
 	j[1] = 0;
 	Util::createRawFile(preProcData, "jojo.raw");
 	Util::createRawFile(j, "hahaha.raw");
-	vector<double> deriv = Util::dX(j);
+	vector<double> deriv = Util::dX(j, ctx);
 	Util::createRawFile(deriv, "dderiv.raw");
 
 	std::cout << "AHAHAHA" << endl;
-	vector<double> integ = Util::integrate(j);
+	vector<double> integ = Util::integrate(j, ctx);
 	vector<short> integSc = Util::doubleToShortScaled(integ);
-	Util::createWavFileMono(Util::normalizeVector(integSc), wav.ChunkSize, ooo);
+	Util::createWavFileMono(Util::normalizeVector(integSc), wav.SampleRate, ooo);
 	std::cout << "oha" << endl;
 
 	Util::saveVectorToFile(deriv, "hello.txt");
@@ -728,9 +681,14 @@ int main(int argc, char* argv[])
 	std::chrono::duration<double> elapsed2 = now2 - now1;
 	cout << "Took " << elapsed2.count() << " seconds" << endl;
 	vector<short>scaled = Util::doubleToShortScaled(deriv);
-	//Util::noteSegmentation(left, right, scaled);
-	Util::createWavFileMono(Util::normalizeVector(scaled),wav.ChunkSize, aja);
+	OnsetConfig onsetConfig;
+	onsetConfig.sampleRate = wav.SampleRate;
+	const vector<Onset> onsets = NoteSegmentor::detect(audio, onsetConfig);
+	cout << "Onsets: " << onsets.size() << endl;
+	Util::createWavFileMono(Util::normalizeVector(scaled), wav.SampleRate, aja);
 	
+	WAVEOUT_PROFILE_DUMP("waveout_trace.json");
+	saveWisdom();
 
 	return 0;
 }